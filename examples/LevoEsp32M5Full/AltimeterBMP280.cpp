@@ -3,90 +3,229 @@
  *  Created: 21/02/2021
  *      Author: Bernd Wokoeck
  *
- * Altimeter function using a BMP280 module with Adafruit library
- * Derived from Adafruit example
- * 
+ * Altimeter function using a BMP280 module
+ * Register access and compensation from the Bosch BMP280 datasheet
+ *
  * For use with M5Core2: SDA and SCL to pin 32 and 33
  * (PA_SDA & PA_SCL --> access via class "Wire")
  *
  */
 
 #include "AltimeterBmp280.h"
+#include "PowerMath.h"
+#include "SysClock.h"
+
+// registers
+#define BMP280_REG_CALIB    0x88
+#define BMP280_REG_ID       0xD0
+#define BMP280_REG_RESET    0xE0
+#define BMP280_REG_CTRLMEAS 0xF4
+#define BMP280_REG_CONFIG   0xF5
+#define BMP280_REG_DATA     0xF7 // pressure msb, lsb, xlsb, temperature msb, lsb, xlsb
+
+#define BMP280_CHIPID       0x58
+#define BME280_CHIPID       0x60
+#define BMP280_SOFTRESET    0xB6
+#define BMP280_FORCED       ((1 << 5) | (3 << 2) | 1) // temp x1, pressure x4, forced mode
+#define BMP280_SKIPPED      0x80000                   // no conversion result
 
 float AltimeterBMP280::m_lastPressure = 0.0; // last pressure for sealevel calibration
 
 AltimeterBMP280::AltimeterBMP280( TwoWire* tw ) : m_pWire(tw)
 {
-    m_pBmp = new Adafruit_BMP280(m_pWire);
 }
 
-AltimeterBMP280::~AltimeterBMP280()
+bool AltimeterBMP280::writeReg(uint8_t reg, uint8_t val)
+{
+    uint32_t us = micros();
+    m_pWire->beginTransmission(m_i2cAddress);
+    m_pWire->write(reg);
+    m_pWire->write(val);
+    bool bOk = m_pWire->endTransmission() == 0;
+    m_stats.busUs += micros() - us;
+    return bOk;
+}
+
+bool AltimeterBMP280::readRegs(uint8_t reg, uint8_t* pData, size_t len)
+{
+    uint32_t us = micros();
+    m_pWire->beginTransmission(m_i2cAddress);
+    m_pWire->write(reg);
+    bool bOk = m_pWire->endTransmission() == 0 && m_pWire->requestFrom(m_i2cAddress, (uint8_t)len) == len;
+    for (size_t i = 0; bOk && i < len; i++)
+        pData[i] = m_pWire->read();
+    m_stats.busUs += micros() - us;
+    return bOk;
+}
+
+bool AltimeterBMP280::readCalibration()
 {
-    delete m_pBmp;
+    uint8_t buf[24];
+    if (!readRegs(BMP280_REG_CALIB, buf, sizeof(buf)))
+        return false;
+    uint16_t* pDst = (uint16_t*)&m_calib; // little endian, same order as in NVM
+    for (int i = 0; i < 12; i++)
+        pDst[i] = buf[2 * i] | (buf[2 * i + 1] << 8);
+    return m_calib.T1 != 0 && m_calib.P1 != 0;
 }
 
 bool  AltimeterBMP280::Init()
 {
-    uint8_t i2cAddress = 0x77;
+    static const uint8_t addresses[2] = { 0x77, 0x76 };
 
-    if (!m_pBmp->begin(i2cAddress))
+    m_pWire->begin();
+    for (int i = 0; i < 2; i++)
     {
-        i2cAddress = 0x76;
-        if (!m_pBmp->begin(i2cAddress))
+        uint8_t id = 0;
+        m_i2cAddress = addresses[i];
+        if (readRegs(BMP280_REG_ID, &id, 1) && (id == BMP280_CHIPID || id == BME280_CHIPID))
         {
-            // Serial.println( "Could not find a valid BMP280 sensor, check wiring!" );
-            return false;
+            // filter is done in software, forced mode does not use standby time
+            writeReg(BMP280_REG_RESET, BMP280_SOFTRESET);
+            delay(3); // NVM copy after reset
+            if (readCalibration() && writeReg(BMP280_REG_CONFIG, 0x00))
+            {
+                m_stats.tiStart = millis();
+                return startConversion();
+            }
         }
     }
-
-    /* Default settings from datasheet. */
-    m_pBmp->setSampling( Adafruit_BMP280::MODE_NORMAL,     /* Operating Mode. */
-                         Adafruit_BMP280::SAMPLING_X2,     /* Temp. oversampling */
-                         Adafruit_BMP280::SAMPLING_X16,    /* Pressure oversampling */
-                         Adafruit_BMP280::FILTER_X16,      /* Filtering. */
-                         Adafruit_BMP280::STANDBY_MS_500); /* Standby time. */
-
-    return true;
+    // Serial.println( "Could not find a valid BMP280 sensor, check wiring!" );
+    m_i2cAddress = 0;
+    return false;
 }
 
-float AltimeterBMP280::GetTemp()
+bool AltimeterBMP280::startConversion()
 {
-    return m_pBmp->readTemperature();
+    m_bConverting = writeReg(BMP280_REG_CTRLMEAS, BMP280_FORCED);
+    m_tiStart = (uint32_t)SysClock::Millis(); // same clock as the loop timestamp in Update()
+    return m_bConverting;
 }
 
-float AltimeterBMP280::GetAltitude(float sealevelPressure)
+bool AltimeterBMP280::readConversion(float& temp, float& pressure)
 {
-    float alt = readAltitude(sealevelPressure);
-    alt = round(alt * 10.0) / 10.0;
-    return alt;
+    uint8_t buf[6];
+    if (!readRegs(BMP280_REG_DATA, buf, sizeof(buf)))
+        return false;
+    int32_t adcP = ((int32_t)buf[0] << 12) | ((int32_t)buf[1] << 4) | (buf[2] >> 4);
+    int32_t adcT = ((int32_t)buf[3] << 12) | ((int32_t)buf[4] << 4) | (buf[5] >> 4);
+    if (adcP == BMP280_SKIPPED || adcT == BMP280_SKIPPED)
+        return false;
+    pressure = compensate(adcT, adcP, temp);
+    return pressure > 0.0;
 }
 
-// copied from Adafruit_BMP280 and made static
-float AltimeterBMP280::GetCurrentSealevelhPa(float calibrationAltitude)
+// integer compensation from the datasheet, pressure in Pa
+float AltimeterBMP280::compensate(int32_t adcT, int32_t adcP, float& temp)
 {
-    if( m_lastPressure == 0.0 || calibrationAltitude == 0.0 )
+    const stCalib& c = m_calib;
+    int32_t var1 = ((((adcT >> 3) - ((int32_t)c.T1 << 1))) * ((int32_t)c.T2)) >> 11;
+    int32_t var2 = (((((adcT >> 4) - ((int32_t)c.T1)) * ((adcT >> 4) - ((int32_t)c.T1))) >> 12) * ((int32_t)c.T3)) >> 14;
+    int32_t tFine = var1 + var2;
+    temp = ((tFine * 5 + 128) >> 8) / 100.0;
+
+    int64_t p1 = ((int64_t)tFine) - 128000;
+    int64_t p2 = p1 * p1 * (int64_t)c.P6;
+    p2 = p2 + ((p1 * (int64_t)c.P5) << 17);
+    p2 = p2 + (((int64_t)c.P4) << 35);
+    p1 = ((p1 * p1 * (int64_t)c.P3) >> 8) + ((p1 * (int64_t)c.P2) << 12);
+    p1 = (((((int64_t)1) << 47) + p1)) * ((int64_t)c.P1) >> 33;
+    if (p1 == 0)
         return 0.0;
-
-    return m_lastPressure / pow(1.0 - (calibrationAltitude / 44330.0), 5.255);
+    int64_t p = 1048576 - adcP;
+    p = (((p << 31) - p2) * 3125) / p1;
+    p1 = (((int64_t)c.P9) * (p >> 13) * (p >> 13)) >> 25;
+    p2 = (((int64_t)c.P8) * p) >> 19;
+    p = ((p + p1 + p2) >> 8) + (((int64_t)c.P7) << 4);
+    return (float)p / 256.0;
 }
 
-// copied from Adafruit_BMP280 to get access to pressure and altitude in one read cycle
-float AltimeterBMP280::readAltitude(float seaLevelhPa)
+bool AltimeterBMP280::Update(DisplayData::enIds& id, float& fVal, uint32_t timestamp)
 {
-    float altitude;
+    if (m_i2cAddress == 0)
+        return false;
 
-    m_lastPressure = m_pBmp->readPressure(); // in Si units for Pascal
-    m_lastPressure /= 100.0;                 // hPa
-    altitude = 44330 * (1.0 - pow(m_lastPressure / seaLevelhPa, 0.1903));
-    // Serial.printf( "Pressure: %f, altitude: %f\r\n", m_lastPressure, altitude );
+    // finished conversion: one burst read, next conversion
+    if (m_bConverting && timestamp - m_tiStart >= CONVERSION_MS)
+    {
+        float temp, pressure;
+        if (readConversion(temp, pressure))
+        {
+            m_temp = temp;
+            m_pressures[m_head] = pressure;
+            m_head = (m_head + 1) % AVG_SAMPLES;
+            m_nPressures = min(m_nPressures + 1, (int)AVG_SAMPLES);
+            m_stats.nConversions++;
+            m_nErrors = 0;
+
+            float rawAlt = PowerMath::AltitudeFromPressure(pressure / 100.0, m_sealevelhPa);
+            if (m_stats.nRaw++ > 0)
+                m_stats.sumRawDiff2 += (rawAlt - m_stats.lastRaw) * (rawAlt - m_stats.lastRaw);
+            m_stats.lastRaw = rawAlt;
+        }
+        else if (++m_nErrors >= 10)
+        {
+            Serial.printf( "BMP280 sensor error - reset\r\n");
+            m_stats.nErrors++;
+            m_nErrors = 0;
+            writeReg(BMP280_REG_RESET, BMP280_SOFTRESET);
+            m_tiStart = timestamp; // next conversion after reset time
+        }
+        m_bConverting = false;
+    }
+    if (!m_bConverting && timestamp - m_tiStart >= SAMPLE_MS)
+        startConversion();
 
-    // on error 
-    if( altitude < -100.0 )
+    // publish altitude and temperature
+    if (m_nPressures == 0)
+        return false;
+    if (SysClock::IsDue(timestamp, m_tiPublish))
     {
-        Serial.printf( "BMP280 sensor error - reset\r\n");
-        m_pBmp->reset();
+        m_tiPublish = timestamp + m_publishMs;
+        float sum = 0.0;
+        for (int i = 0; i < m_nPressures; i++)
+            sum += m_pressures[i];
+        m_lastPressure = sum / m_nPressures / 100.0; // hPa
+        float alt = PowerMath::AltitudeFromPressure(m_lastPressure, m_sealevelhPa);
+        if (m_stats.nPub++ > 0)
+            m_stats.sumPubDiff2 += (alt - m_stats.lastPub) * (alt - m_stats.lastPub);
+        m_stats.lastPub = alt;
+
+        id = DisplayData::BARO_ALTIMETER;
+        fVal = round(alt * 10.0) / 10.0;
+        m_bTempDue = SysClock::IsDue(timestamp, m_tiTemp);
+        return true;
     }
+    if (m_bTempDue)
+    {
+        m_bTempDue = false;
+        m_tiTemp = timestamp + TEMP_MS;
+        id = DisplayData::BARO_TEMP;
+        fVal = m_temp;
+        return true;
+    }
+    return false;
+}
 
-    return altitude;
+// noise: rms of successive differences / sqrt(2), riding adds the altitude change
+void AltimeterBMP280::PrintStats()
+{
+    uint32_t ms = millis() - m_stats.tiStart;
+    if (ms == 0 || m_i2cAddress == 0)
+        return;
+    float rawNoise = (m_stats.nRaw > 1) ? sqrt(m_stats.sumRawDiff2 / (m_stats.nRaw - 1) / 2.0) : 0.0;
+    float pubNoise = (m_stats.nPub > 1) ? sqrt(m_stats.sumPubDiff2 / (m_stats.nPub - 1) / 2.0) : 0.0;
+    Serial.printf("altimeter: %.1f conversions/s, I2C %u us/s, noise %.0f cm raw, %.0f cm published, %u resets\r\n",
+        m_stats.nConversions * 1000.0 / ms, (uint32_t)((uint64_t)m_stats.busUs * 1000 / ms), rawNoise * 100.0, pubNoise * 100.0, m_stats.nErrors);
+    m_stats = {};
+    m_stats.tiStart = millis();
 }
 
+// copied from Adafruit_BMP280 and made static, pow() replaced by lookup table
+float AltimeterBMP280::GetCurrentSealevelhPa(float calibrationAltitude)
+{
+    if( m_lastPressure == 0.0 || calibrationAltitude == 0.0 )
+        return 0.0;
+
+    return PowerMath::SealevelFromAltitude(m_lastPressure, calibrationAltitude);
+}
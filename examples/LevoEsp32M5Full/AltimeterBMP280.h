@@ -3,9 +3,13 @@
  *  Created: 21/02/2021
  *      Author: Bernd Wokoeck
  *
- * Altimeter function using a BMP280 module with Adafruit library
- * https://github.com/adafruit/Adafruit_BMP280_Library
- * 
+ * Altimeter function using a BMP280 module
+ *
+ * Forced mode conversions scheduled from the main loop: Update() reads the
+ * finished conversion (temperature and pressure in one burst) and starts the
+ * next one, it never waits for the sensor. Pressure is averaged over the last
+ * AVG_SAMPLES conversions, altitude is published every PUBLISH_MS.
+ *
  * For use with M5Core2: SDA and SCL to pin 32 and 33
  * (PA_SDA & PA_SCL --> access via class "Wire")
  *
@@ -14,30 +18,81 @@
 #ifndef ALTIMETER_BMP280_H
 #define ALTIMETER_BMP280_H
 
-#include <Adafruit_BMP280.h>
 #include <Wire.h>
+#include "DisplayData.h"
 
 class AltimeterBMP280
 {
 public:
+    enum
+    {
+        SAMPLE_MS     = 50,   // conversion interval, Update() at least as often
+        CONVERSION_MS = 14,   // max. conversion time, temp x1, pressure x4 oversampling
+        AVG_SAMPLES   = 8,    // pressure moving average, 400 ms
+        PUBLISH_MS    = 250,  // altitude, 4 Hz
+        TEMP_MS       = 1000, // temperature
+    };
+
     AltimeterBMP280( TwoWire* tw  = &Wire );
-    ~AltimeterBMP280();
 
     bool  Init(); // returns true, if sensor exists
-    float GetAltitude( float sealevelhPa = 1013.25 );
-    float GetTemp();
+    void  SetSealevel(float sealevelhPa) { m_sealevelhPa = sealevelhPa; }
+    void  SetPublishRate(uint32_t publishMs) { m_publishMs = max(publishMs, (uint32_t)SAMPLE_MS); }
+    bool  Update(DisplayData::enIds& id, float& fVal, uint32_t timestamp); // BARO_ALTIMETER or BARO_TEMP when due
+    void  PrintStats(); // I2C bus time and altitude noise since last call
 
     static bool  CanCalculateSealevel() { return m_lastPressure != 0.0; }
     static float GetCurrentSealevelhPa( float calibrationAltitude );
 
 protected:
     TwoWire * m_pWire;
-    uint8_t   m_i2cAddress;
+    uint8_t   m_i2cAddress = 0;
+
+    // calibration from sensor NVM
+    struct stCalib
+    {
+        uint16_t T1;
+        int16_t  T2, T3;
+        uint16_t P1;
+        int16_t  P2, P3, P4, P5, P6, P7, P8, P9;
+    } m_calib;
+
+    // conversion schedule
+    bool     m_bConverting = false;
+    uint32_t m_tiStart     = 0;
+    uint32_t m_tiPublish   = 0;
+    uint32_t m_tiTemp      = 0;
+    uint32_t m_publishMs   = PUBLISH_MS;
+    int      m_nErrors     = 0;
+
+    // filter
+    float    m_pressures[AVG_SAMPLES]; // Pa
+    int      m_nPressures = 0;
+    int      m_head       = 0;
+    float    m_temp       = 0.0;
+    float    m_sealevelhPa = 1013.25;
+    bool     m_bTempDue   = false;
+
+    // statistics: bus time, noise from successive differences
+    struct stStats
+    {
+        uint32_t tiStart;
+        uint32_t busUs;
+        uint32_t nConversions;
+        uint32_t nErrors;
+        float    lastRaw, sumRawDiff2;
+        float    lastPub, sumPubDiff2;
+        uint32_t nRaw, nPub;
+    } m_stats = {};
 
-    Adafruit_BMP280* m_pBmp; // use I2C interface
+    static float m_lastPressure; // hPa, filtered
 
-    static float m_lastPressure;
-    float readAltitude(float seaLevelhPa);
+    bool readCalibration();
+    bool startConversion();
+    bool readConversion(float& temp, float& pressure);
+    bool writeReg(uint8_t reg, uint8_t val);
+    bool readRegs(uint8_t reg, uint8_t* pData, size_t len);
+    float compensate(int32_t adcT, int32_t adcP, float& temp);
 };
 
-#endif // ALTIMETER_BMP280_H
\ No newline at end of file
+#endif // ALTIMETER_BMP280_H
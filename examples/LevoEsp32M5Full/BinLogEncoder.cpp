@@ -0,0 +1,117 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * writes sessions and blocks of the binary log format (see BinLogFormat.h)
+ *
+ */
+
+#include "BinLogEncoder.h"
+
+void BinLogEncoder::WriteHeader(DisplayData& DispData, const RTC_DateTypeDef& date, const RTC_TimeTypeDef& time)
+{
+    FlushBlock();
+
+    uint8_t hdr[16];
+    size_t n = 0;
+    memcpy(hdr, BinLogFormat::Magic(), 4);
+    n = 4;
+    hdr[n++] = BinLogFormat::VERSION;
+    hdr[n++] = date.Date;
+    hdr[n++] = date.Month;
+    hdr[n++] = date.Year & 0xFF;
+    hdr[n++] = date.Year >> 8;
+    hdr[n++] = time.Hours;
+    hdr[n++] = time.Minutes;
+    hdr[n++] = time.Seconds;
+
+    // count visible values
+    uint8_t nIds = 0;
+    for (int i = 0; i < DisplayData::numElements; i++)
+        if (DispData.GetDescription((DisplayData::enIds)i))
+            nIds++;
+    hdr[n++] = nIds;
+    write(hdr, n);
+
+    for (int i = 0; i < DisplayData::numElements; i++)
+    {
+        const DisplayData::stDisplayData* pDesc = DispData.GetDescription((DisplayData::enIds)i);
+        if (!pDesc)
+            continue;
+        uint8_t lenLabel = strlen(pDesc->strLabel);
+        uint8_t lenUnit  = strlen(pDesc->strUnit);
+        uint8_t desc[4]  = { (uint8_t)i, (uint8_t)pDesc->flags, (uint8_t)pDesc->nLogPrecision, lenLabel };
+        write(desc, 4);
+        write(pDesc->strLabel, lenLabel);
+        write(&lenUnit, 1);
+        write(pDesc->strUnit, lenUnit);
+    }
+    m_lastTime = 0;
+}
+
+// new block: absolute time base, delta values restart at 0
+uint8_t* BinLogEncoder::reserve(uint32_t time)
+{
+    if (m_len + BinLogFormat::MAX_RECORD > BinLogFormat::BLOCK_SIZE)
+        FlushBlock();
+    if (m_len == 0 || time < m_lastTime)
+    {
+        FlushBlock();
+        m_len = BinLogFormat::BLOCK_HEADER;
+        m_len += BinLogFormat::PutVarint(&m_block[m_len], time);
+        m_lastTime    = time;
+        m_blockMillis = millis();
+        memset(m_lastValue, 0, sizeof(m_lastValue));
+    }
+    return &m_block[m_len];
+}
+
+bool BinLogEncoder::AddValue(uint8_t id, float fVal, int logPrecision, uint32_t time)
+{
+    if (id >= DisplayData::numElements)
+        return false;
+
+    // fixed point value with log precision
+    static const float scale[] = { 1.0f, 10.0f, 100.0f, 1000.0f };
+    int32_t value = lroundf(fVal * scale[constrain(logPrecision, 0, 3)]);
+
+    uint8_t* p = reserve(time);
+    size_t n = 0;
+    p[n++] = id;
+    n += BinLogFormat::PutVarint(&p[n], time - m_lastTime);
+    n += BinLogFormat::PutVarint(&p[n], BinLogFormat::ZigZag(value - m_lastValue[id]));
+    m_lastValue[id] = value;
+    m_len += n;
+    m_lastTime = time;
+    return true;
+}
+
+bool BinLogEncoder::AddRaw(const uint8_t* pData, size_t len, uint32_t time)
+{
+    if (len > BinLogFormat::MAX_RECORD - 7)
+        return false;
+
+    uint8_t* p = reserve(time);
+    size_t n = 0;
+    p[n++] = BinLogFormat::ID_RAW;
+    n += BinLogFormat::PutVarint(&p[n], time - m_lastTime);
+    p[n++] = (uint8_t)len;
+    memcpy(&p[n], pData, len);
+    n += len;
+    m_len += n;
+    m_lastTime = time;
+    return true;
+}
+
+void BinLogEncoder::FlushBlock()
+{
+    if (m_len == 0)
+        return;
+    size_t payload = m_len - BinLogFormat::BLOCK_HEADER;
+    m_block[0] = BinLogFormat::BLOCK_MARKER;
+    m_block[1] = payload & 0xFF;
+    m_block[2] = payload >> 8;
+    write(m_block, m_len);
+    m_len = 0;
+}
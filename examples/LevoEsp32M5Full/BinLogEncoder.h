@@ -0,0 +1,49 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * writes sessions and blocks of the binary log format (see BinLogFormat.h)
+ *
+ */
+
+#ifndef BIN_LOG_ENCODER_H
+#define BIN_LOG_ENCODER_H
+
+#include <M5Core2.h>
+#include "DisplayData.h"
+#include "BinLogFormat.h"
+
+class BinLogEncoder
+{
+public:
+    typedef bool (*WriteFn)(void* pCtx, const void* pData, size_t len);
+
+    void SetOutput(WriteFn fnWrite, void* pCtx) { m_fnWrite = fnWrite; m_pCtx = pCtx; }
+
+    // session header with date and metadata of all visible values, starts a new time base
+    void WriteHeader(DisplayData& DispData, const RTC_DateTypeDef& date, const RTC_TimeTypeDef& time);
+
+    // time in ms since session start
+    bool AddValue(uint8_t id, float fVal, int logPrecision, uint32_t time);
+    bool AddRaw(const uint8_t* pData, size_t len, uint32_t time);
+
+    void     FlushBlock();
+    bool     HasData()          { return m_len > 0; }
+    uint32_t BlockStartMillis() { return m_blockMillis; } // for time bounded flush
+
+protected:
+    WriteFn  m_fnWrite = NULL;
+    void*    m_pCtx    = NULL;
+
+    uint8_t  m_block[BinLogFormat::BLOCK_SIZE];
+    size_t   m_len = 0;
+    uint32_t m_lastTime = 0;
+    uint32_t m_blockMillis = 0;
+    int32_t  m_lastValue[DisplayData::numElements];
+
+    uint8_t* reserve(uint32_t time); // start new block if needed, returns write position
+    bool     write(const void* pData, size_t len) { return m_fnWrite ? m_fnWrite(m_pCtx, pData, len) : false; }
+};
+
+#endif // BIN_LOG_ENCODER_H
@@ -0,0 +1,72 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * compact binary log format (FileLogger::BIN_DELTA), shared with extras/LogConverter
+ *
+ * file:     session header, blocks, [session header, blocks, ...]
+ * session:  "LVB1", version, day, month, year(2), hour, minute, second, nIds,
+ *           nIds * { id, flags, logPrecision, lenLabel, label, lenUnit, unit }
+ * block:    BLOCK_MARKER, payload length(2), payload
+ * payload:  varint time base (ms since session start), records
+ * record:   id, varint dt (ms since previous record), zigzag varint delta of value * 10^logPrecision
+ *           ID_RAW, varint dt, len, len bytes of undecoded BLE data
+ *
+ * Delta values start at 0 in every block, so each block can be decoded on its own.
+ * All multi byte values are little endian.
+ *
+ */
+
+#ifndef BIN_LOG_FORMAT_H
+#define BIN_LOG_FORMAT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+class BinLogFormat
+{
+public:
+    enum
+    {
+        VERSION       = 1,
+        BLOCK_MARKER  = 0xB5,
+        BLOCK_SIZE    = 512, // incl. marker and length
+        BLOCK_HEADER  = 3,
+        ID_RAW        = 0xFF,
+        MAX_RECORD    = 1 + 5 + 1 + 20, // raw record with 20 bytes BLE data
+    };
+
+    static const char* Magic() { return "LVB1"; }
+
+    static uint32_t ZigZag(int32_t v)    { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+    static int32_t  UnZigZag(uint32_t v) { return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+
+    // returns number of bytes written (max. 5)
+    static size_t PutVarint(uint8_t* p, uint32_t v)
+    {
+        size_t n = 0;
+        while (v >= 0x80)
+        {
+            p[n++] = (uint8_t)(v | 0x80);
+            v >>= 7;
+        }
+        p[n++] = (uint8_t)v;
+        return n;
+    }
+
+    // returns number of bytes read, 0 on error
+    static size_t GetVarint(const uint8_t* p, size_t len, uint32_t& v)
+    {
+        v = 0;
+        for (size_t n = 0; n < len && n < 5; n++)
+        {
+            v |= (uint32_t)(p[n] & 0x7F) << (7 * n);
+            if ((p[n] & 0x80) == 0)
+                return n + 1;
+        }
+        return 0;
+    }
+};
+
+#endif // BIN_LOG_FORMAT_H
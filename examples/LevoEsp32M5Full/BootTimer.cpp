@@ -0,0 +1,35 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * Boot phase timestamps (ms since reset), time to first BLE value
+ *
+ */
+
+#include "BootTimer.h"
+
+uint32_t    BootTimer::s_ms[NUM_PHASES] = {};
+const char* BootTimer::s_names[NUM_PHASES] =
+{
+    "setup", "settings", "BLE scan", "M5 init", "sensors", "screen", "loop", "SD ready", "BLE connect", "BLE value",
+};
+
+void BootTimer::Mark(enPhase phase)
+{
+    if (s_ms[phase] != 0)
+        return;
+    uint32_t ms = millis();
+    s_ms[phase] = ms ? ms : 1; // 0: not marked
+    if (phase == LOOP || phase == BLE_VALUE)
+        Print();
+}
+
+void BootTimer::Print()
+{
+    Serial.print("boot (ms):");
+    for (int i = 0; i < NUM_PHASES; i++)
+        if (s_ms[i] != 0)
+            Serial.printf(" %s %u,", s_names[i], s_ms[i]);
+    Serial.println();
+}
@@ -0,0 +1,42 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * Boot phase timestamps (ms since reset), time to first BLE value
+ *
+ */
+
+#ifndef BOOT_TIMER_H
+#define BOOT_TIMER_H
+
+#include <Arduino.h>
+
+class BootTimer
+{
+public:
+    typedef enum
+    {
+        SETUP = 0,    // setup() entered
+        SETTINGS,     // preferences loaded
+        BLE_SCAN,     // bluetooth scanning
+        M5_INIT,      // LCD, touch, power management, SD mounted
+        SENSORS,      // altimeter, IMU
+        SCREEN,       // layout, first screen drawn
+        LOOP,         // setup() done
+        SD_READY,     // journal recovery and card usage, in background
+        BLE_CONNECT,  // first connection
+        BLE_VALUE,    // first value from the bike
+        NUM_PHASES,
+    } enPhase;
+
+    static void Mark(enPhase phase);   // first call per phase counts
+    static bool IsMarked(enPhase phase) { return s_ms[phase] != 0; }
+    static void Print();
+
+protected:
+    static uint32_t    s_ms[NUM_PHASES];
+    static const char* s_names[NUM_PHASES];
+};
+
+#endif // BOOT_TIMER_H
@@ -70,6 +70,7 @@ public:
         BARO_TEMP,
         PWR_POWER,
         TRIP_RIDERPOWER,
+        SYS_RUNTIME,
 
         NUM_ELEMENTS // must be the last value
     } enIds;
@@ -153,6 +154,7 @@ protected:
         { BARO_TEMP,              "Temp",           "&o",   4, 1, 1,              DYNAMIC },
         { PWR_POWER,              "Calc power",     "W",    4, 0, 0,              DYNAMIC },
         { TRIP_RIDERPOWER,        "Avg Prider",     "W",    4, 0, 0,              TRIP    },
+        { SYS_RUNTIME,            "M5 runtime",     "min",  4, 0, 0,              DYNAMIC },
     };
 
     std::bitset<numElements> hiddenMask;
@@ -0,0 +1,21 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * output of display values, implemented by M5Screen and by host tools
+ *
+ */
+
+#ifndef DISPLAY_SINK_H
+#define DISPLAY_SINK_H
+
+#include "DisplayData.h"
+
+class DisplaySink
+{
+public:
+    virtual void ShowValue(DisplayData::enIds id, float val, DisplayData& dispData) = 0;
+};
+
+#endif // DISPLAY_SINK_H
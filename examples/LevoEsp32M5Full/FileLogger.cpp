@@ -9,34 +9,28 @@
 
 #include <M5Core2.h>
 #include "FileLogger.h"
+#include "SysClock.h"
 
-File dataFile;
+bool FileLogger::Init(DisplayData& DispData)
+{
+    return m_manager.Init(&DispData);
+}
 
-// check SD card occupied space in %
+// check SD card occupied space in %, cached
 int8_t FileLogger::PercentFull()
 {
-    // check card
-    sdcard_type_t Type = SD.cardType();
-    if (Type == CARD_UNKNOWN || Type == CARD_NONE)
-    {
-        // Serial.println("No SD card.");
-        return -1;
-    }
-
-    // used percent
-    uint64_t used = SD.usedBytes();
-    if (used == 0)
-        used = (uint64_t)1;
-    uint64_t usedPercent = (used * (uint64_t)100) / SD.totalBytes();
-
-    return (int8_t)usedPercent;
+    return m_manager.PercentFull(m_writer.IsOpen() ? m_nBytes : 0);
 }
 
 // try to open log file
-bool FileLogger::Open()
+bool FileLogger::Open(enLogFormat format)
 {
+    m_format = format;
+    m_nBytes = 0;
+    m_binEncoder.FlushBlock();
+
     // reset timestamp and start distance
-    m_tiOpenFile = millis();
+    m_tiOpenFile = (uint32_t)SysClock::Millis();
     m_tiStart    = 0;
     m_kmStart    = 0.0f;
     m_kmLast     = 0.0f;
@@ -54,33 +48,29 @@ bool FileLogger::Open()
         return false;
     }
 
-    // free space
-    uint64_t freeBytes = (SD.totalBytes() - SD.usedBytes()) / (uint64_t)1000;
-    Serial.print("SD card free: ");
-    Serial.print( (uint32_t)freeBytes );
-    Serial.println(" KB");
-
     // used percent
     Serial.print("SD percent used: ");
     Serial.print((int)PercentFull());
     Serial.println(" %");
 
-    // filename is <date>.log
-    char filename[20];
-    RTC_TimeTypeDef RTC_Time;
-    RTC_DateTypeDef RTC_Date;
-    M5.Rtc.GetDate(&RTC_Date);
-    M5.Rtc.GetTime(&RTC_Time);
-    snprintf(filename, sizeof(filename), "/%02d%02d%02d.log", RTC_Date.Date, RTC_Date.Month, (uint8_t)(RTC_Date.Year-2000));
+    // filename is <date><ride>.log or <date><ride>.bin
+    RTC_TimeTypeDef& RTC_Time = m_openTime;
+    RTC_DateTypeDef& RTC_Date = m_openDate;
+    SysClock::GetDate(&RTC_Date);
+    SysClock::GetTime(&RTC_Time);
+    m_manager.GetFilename(m_filename, format == BIN_DELTA, format);
 
     // open file in append mode
-    dataFile = SD.open( filename, FILE_APPEND );
-    if (!dataFile)
+    if (!m_writer.Open(m_filename))
     {
         Serial.println("Error opening log file.");
         return false;
     }
 
+    // binary header is written with first value
+    if (format == BIN_DELTA)
+        return true;
+
     // log date time
     char timeStrbuff[40];
     snprintf(timeStrbuff, sizeof(timeStrbuff), "%02d.%02d.%04d, %02d:%02d:%02d", RTC_Date.Date, RTC_Date.Month, RTC_Date.Year, RTC_Time.Hours, RTC_Time.Minutes, RTC_Time.Seconds);
@@ -92,36 +82,73 @@ bool FileLogger::Open()
 
 void FileLogger::Flush()
 {
-    dataFile.flush();
+    m_binEncoder.FlushBlock();
+    m_writer.Flush();
     Serial.println("log file flushed.");
 }
 
 void FileLogger::Close()
 {
-    dataFile.close();
+    if (!m_writer.IsOpen())
+        return;
+    m_binEncoder.FlushBlock();
+    m_writer.Close();
+    m_writer.PrintStats();
     Serial.println("log file closed.");
+
+    // ride index
+    m_manager.OnClosed(m_filename, m_openDate, m_openTime, ((uint32_t)SysClock::Millis() - m_tiOpenFile) / 1000, m_kmLast - m_kmStart, m_format, m_nBytes);
 }
 
-// write a text line to file
-bool FileLogger::Writeln(const char* strLog)
+void FileLogger::Poll(uint32_t timestamp)
 {
-    if (dataFile)
+    if (!m_writer.IsOpen())
     {
-        dataFile.println(strLog);
-        return true;
+        // compress old logs while not logging
+        m_manager.Poll();
+        return;
     }
-    return false;
+
+    // binary block is incomplete for max. 1s
+    if (m_binEncoder.HasData() && millis() - m_binEncoder.BlockStartMillis() >= 1000)
+        m_binEncoder.FlushBlock();
+    m_writer.Poll(timestamp);
+
+    // rotate by size
+    if (m_nBytes >= LogManager::MAX_LOG_SIZE)
+        NewRide();
 }
 
-bool FileLogger::Writeln(std::string& strLog)
+void FileLogger::NewRide()
 {
-    if (dataFile)
+    m_manager.NewFile();
+    if (m_writer.IsOpen())
     {
-        strLog += "\r\n";
-        dataFile.write( (const uint8_t*)strLog.c_str(), strLog.length());
-        return true;
+        Close();
+        Open(m_format);
     }
-    return false;
+}
+
+// all data to log buffer
+bool FileLogger::write(const void* pData, size_t len)
+{
+    m_nBytes += len;
+    return m_writer.Write((const char*)pData, len);
+}
+
+// write a text line to log buffer
+bool FileLogger::Writeln(const char* strLog)
+{
+    write(strLog, strlen(strLog));
+    return write("\r\n", 2);
+}
+
+bool FileLogger::Writeln(LineBuffer& line)
+{
+    if (m_bSerialEcho)
+        Serial.println(line.c_str());
+    line.Append("\r\n");
+    return write(line.c_str(), line.Length());
 }
 
 // log one line in the specified format
@@ -154,73 +181,61 @@ bool FileLogger::Writeln(DisplayData::enIds id, LevoEsp32Ble::stBleVal& bleVal,
 
     case CSV_TABLE:
         return LogCsvTable(id, bleVal, DispData, timestamp);
-    }
-    return false;
-}
 
-// format binary data to hex 
-void FileLogger::HexDump(char* pBuf, int nLen, std::string& str)
-{
-    char s[] = "00 ";
-    for (int i = 0; i < nLen; i++)
-    {
-        snprintf(s, sizeof(s), "%02x ", pBuf[i]);
-        str += s;
+    case BIN_DELTA:
+        return LogBinDelta(id, bleVal, DispData, timestamp);
     }
+    return false;
 }
 
 // format for log output
-void FileLogger::LogDump(DisplayData::enIds id, float val, DisplayData& DispData, std::string& str)
+void FileLogger::LogDump(DisplayData::enIds id, float val, DisplayData& DispData, LineBuffer& line)
 {
     const DisplayData::stDisplayData* pDesc = DispData.GetDescription(id);
     if (pDesc == 0)
         return;
 
-    // format float value
-    char strVal[20];
-    dtostrf(val, 7, pDesc->nLogPrecision, strVal);
-
-    // format line
-    char s[80];
-    snprintf(s, sizeof(s), "%-14s%s %s", pDesc->strLabel, strVal, pDesc->strUnit);
+    // label value unit
+    line.AppendPadded(pDesc->strLabel, 14);
+    line.AppendFloat(val, 7, pDesc->nLogPrecision);
+    line.Append(' ');
+    line.AppendUnit(pDesc->strUnit);
+}
 
-    // replace degree symbol
-    char* p = strstr(s, "&o");
-    if (p)
-    {
-        *p = 0xB0;
-        *(p + 1) = ' ';
-    }
-    str = s;
+// time and distance stamp
+void FileLogger::appendStamp(LineBuffer& line, uint32_t timestamp)
+{
+    line.AppendFloat((timestamp - m_tiStart) / 1000.0, 9, 3); // time in seconds
+    line.Append('\t');
+    line.AppendFloat(m_kmLast - m_kmStart, 7, 2);
 }
 
 // log value in text or hex representation w/o timestamp
 bool FileLogger::LogSimple(DisplayData::enIds id, LevoEsp32Ble::stBleVal& bleVal, DisplayData& DispData, uint32_t timestamp)
 {
-    std::string strLog;
-
     // log header
     if(m_bFirstLine)
     {
-        strLog = "Label         Value";
-        Writeln(strLog);
-        Serial.println(strLog.c_str());
+        m_line.Clear();
+        m_line.Append("Label         Value");
+        Writeln(m_line);
         m_bFirstLine = false;
     }
 
+    m_line.Clear();
+
     // log known data 
     if (id != DisplayData::UNKNOWN && bleVal.unionType == LevoEsp32Ble::FLOAT)
     {
-        LogDump(id, bleVal.fVal, DispData, strLog);       // format string for simple log output
+        LogDump(id, bleVal.fVal, DispData, m_line);       // format string for simple log output
     }
     // log unknown data
     else if (bleVal.unionType == LevoEsp32Ble::BINARY)   // undecoded/raw for hex byte log output
     {
-        strLog = "UNKNOWN\t";
-        HexDump((char*)bleVal.raw.data, bleVal.raw.len, strLog);
+        m_line.Append("UNKNOWN\t");
+        m_line.AppendHex(bleVal.raw.data, bleVal.raw.len);
     }
-    Serial.println(strLog.c_str());
-    return Writeln(strLog);
+    return Writeln(m_line);
 }
 
 // check, if a float value has changed within a given range
@@ -239,30 +254,18 @@ bool FileLogger::hasChanged(float fVal1, float fVal2, int precision)
 // log tab separated with timestamp and distance 
 bool FileLogger::LogCsvSimple(DisplayData::enIds id, LevoEsp32Ble::stBleVal& bleVal, DisplayData& DispData, enLogFormat format, uint32_t timestamp)
 {
-    // log buffer
-    char strLog[200] = "";
-
     // also log unknown?
     bool bLogUnknown = (format == CSV_KNOWN || format == CSV_KNOWNCHANGED ) ? false : true;
 
     // write header to csv
     if (m_bFirstLine)
     {
-        strncpy( strLog, "Time\tDist\tId\tLabel\tValue\tUnit", sizeof( strLog) );
-        Writeln( strLog );
-        Serial.println(strLog);
+        m_line.Clear();
+        m_line.Append("Time\tDist\tId\tLabel\tValue\tUnit");
+        Writeln( m_line );
         m_bFirstLine = false;
     }
 
-    // timestamp string
-    char strTime[20];
-    float ti = timestamp - m_tiStart;
-    dtostrf(ti / 1000.0, 9, 3, strTime); // time in seconds
-
-    // distance string
-    char strDistance[20];
-    dtostrf(m_kmLast - m_kmStart, 7, 2, strDistance);
-
     // log known value
     if (id != DisplayData::UNKNOWN && bleVal.unionType == LevoEsp32Ble::FLOAT)
     {
@@ -284,43 +287,37 @@ bool FileLogger::LogCsvSimple(DisplayData::enIds id, LevoEsp32Ble::stBleVal& ble
         if( pDesc->flags & DisplayData::TIME )
             return false;
 
-        // format float value with correct precision
-        char strVal[20];
-        dtostrf(bleVal.fVal, 7, pDesc->nLogPrecision, strVal);
-
-        // replace degree symbol
-        char strUnit[10];
-        strncpy( strUnit, pDesc->strUnit, sizeof(strUnit) );
-        if( strUnit[0] == '&' && strUnit[1] == 'o' )
-        {
-            strUnit[0] = '\xb0';
-            strUnit[1] = '\0';
-        }
-
-        // log to file
         // time  km  id  label  value  unit
-        snprintf(strLog, sizeof(strLog), "%s\t%s\t%d\t%s\t%s\t%s", strTime, strDistance, id, pDesc->strLabel, strVal, strUnit );
-        Serial.println(strLog);
-        return Writeln( strLog );
+        m_line.Clear();
+        appendStamp(m_line, timestamp);
+        m_line.Append('\t').AppendInt(id).Append('\t').Append(pDesc->strLabel).Append('\t');
+        m_line.AppendFloat(bleVal.fVal, 7, pDesc->nLogPrecision).Append('\t');
+        m_line.AppendUnit(pDesc->strUnit);
+        return Writeln( m_line );
     }
     // log unknown data
     else if (bLogUnknown && id == DisplayData::UNKNOWN && bleVal.unionType == LevoEsp32Ble::BINARY)
     {
         // time  km -1 hexdump
-        std::string strHex;
-        HexDump((char*)bleVal.raw.data, bleVal.raw.len, strHex);
-        snprintf(strLog, sizeof(strLog), "%s\t%s\t-1\t%s", strTime, strDistance, strHex.c_str());
-        Serial.println(strLog);
-        return Writeln(strLog);
+        m_line.Clear();
+        appendStamp(m_line, timestamp);
+        m_line.Append("\t-1\t");
+        m_line.AppendHex(bleVal.raw.data, bleVal.raw.len);
+        return Writeln(m_line);
     }
 
     return false;
 }
 
+// format cached text of one table column
+void FileLogger::formatTableColumn(int id, const DisplayData::stDisplayData* pDesc)
+{
+    m_tableTextLen[id] = LineBuffer::FormatFloat(m_tableText[id], m_tableLineBuffer[id], 7, pDesc->nLogPrecision);
+}
+
 bool FileLogger::LogCsvTable(DisplayData::enIds id, LevoEsp32Ble::stBleVal& bleVal, DisplayData& DispData, uint32_t timestamp)
 {
     int i = 0;
-    std::string strLog;
 
     // we can only handle float values
     if (id == DisplayData::UNKNOWN || bleVal.unionType != LevoEsp32Ble::FLOAT)
@@ -333,7 +330,7 @@ bool FileLogger::LogCsvTable(DisplayData::enIds id, LevoEsp32Ble::stBleVal& bleV
     if (m_bFirstLine)
     {
         // collect data for 5 seconds while not logging
-        uint32_t tiWait  = (millis() - m_tiOpenFile) / 1000L; // use millis() instead of timestamp here, because it may be tool old
+        uint32_t tiWait  = ((uint32_t)SysClock::Millis() - m_tiOpenFile) / 1000L; // use clock instead of timestamp here, because it may be tool old
         if( tiWait < 5 )
             return true;
 
@@ -344,64 +341,101 @@ bool FileLogger::LogCsvTable(DisplayData::enIds id, LevoEsp32Ble::stBleVal& bleV
             const DisplayData::stDisplayData* pDesc = DispData.GetDescription(idStatic);
             if (pDesc && isStaticValue(pDesc))
             {
-                float value = m_tableLineBuffer[idStatic];
-                LogDump(idStatic, value, DispData, strLog);
-                Writeln(strLog);
-                Serial.println(strLog.c_str());
+                m_line.Clear();
+                LogDump(idStatic, m_tableLineBuffer[idStatic], DispData, m_line);
+                Writeln(m_line);
             }
         }
 
-        // head line
-        strLog = "Time\tDist\tId";
+        // head line and column template: dynamic values in id order
+        m_nTableCols = 0;
+        m_line.Clear();
+        m_line.Append("Time\tDist\tId");
         for ( i = 0; i < DisplayData::numElements; i++)
         {
             const DisplayData::stDisplayData* pDesc = DispData.GetDescription((DisplayData::enIds)i);
             if (pDesc && isDynamicValue(pDesc))
             {
-                strLog += "\t";
-                strLog += pDesc->strLabel;
+                m_line.Append('\t').Append(pDesc->strLabel);
+                m_tableCols[m_nTableCols++] = i;
+                formatTableColumn(i, pDesc);
             }
         }
-        Writeln(strLog);
-        Serial.println(strLog.c_str());
+        Writeln(m_line);
+        m_bFirstLine = false;
+    }
+    else
+    {
+        // only the new value needs formatting
+        const DisplayData::stDisplayData* pDesc = DispData.GetDescription(id);
+        if (pDesc && isDynamicValue(pDesc))
+            formatTableColumn(id, pDesc);
+    }
+
+    // time, distance, id and all cached values
+    m_line.Clear();
+    appendStamp(m_line, timestamp);
+    m_line.Append('\t').AppendInt(id);
+    for (i = 0; i < m_nTableCols; i++)
+        m_line.Append('\t').Append(m_tableText[m_tableCols[i]], m_tableTextLen[m_tableCols[i]]);
+
+    return Writeln(m_line);
+}
+
+bool FileLogger::LogBinDelta(DisplayData::enIds id, LevoEsp32Ble::stBleVal& bleVal, DisplayData& DispData, uint32_t timestamp)
+{
+    if (m_bFirstLine)
+    {
+        m_binEncoder.WriteHeader(DispData, m_openDate, m_openTime);
         m_bFirstLine = false;
     }
 
-    // timestamp string
-    char strTime[20];
-    float ti = timestamp - m_tiStart;
-    dtostrf(ti/1000.0, 9, 3, strTime); // time in seconds
+    if (bleVal.unionType == LevoEsp32Ble::FLOAT)
+    {
+        const DisplayData::stDisplayData* pDesc = DispData.GetDescription(id);
+        if (pDesc == 0 || (pDesc->flags & DisplayData::TIME))
+            return false;
+        return m_binEncoder.AddValue((uint8_t)id, bleVal.fVal, pDesc->nLogPrecision, timestamp - m_tiStart);
+    }
+    else if (bleVal.unionType == LevoEsp32Ble::BINARY && bleVal.raw.len <= sizeof(bleVal.raw.data))
+        return m_binEncoder.AddRaw(bleVal.raw.data, bleVal.raw.len, timestamp - m_tiStart);
+
+    return false;
+}
 
-    // distance string
-    char strDistance[20];
-    dtostrf(m_kmLast - m_kmStart, 7, 2, strDistance);
+// formatting speed and size for all formats with a simulated ride, log file is not written
+void FileLogger::Benchmark(DisplayData& DispData)
+{
+    const int nLoops = 2000;
+    static const enLogFormat formats[] = { SIMPLE, CSV_SIMPLE, CSV_TABLE, BIN_DELTA };
+    static const char* names[] = { "SIMPLE", "CSV_SIMPLE", "CSV_TABLE", "BIN_DELTA" };
 
-    // id string
-    char strId[5];
-    snprintf(strId, sizeof(strId), "%d", id);
+    bool bEcho = m_bSerialEcho;
+    m_bSerialEcho = false;
 
-    // build line
-    strLog = strTime;
-    strLog += "\t";
-    strLog += strDistance;
-    strLog += "\t";
-    strLog += strId;
+    LevoEsp32Ble::stBleVal bleVal;
+    bleVal.unionType = LevoEsp32Ble::FLOAT;
 
-    // append all values
-    for ( i = 0; i < DisplayData::numElements; i++)
+    for (int f = 0; f < 4; f++)
     {
-        const DisplayData::stDisplayData* pDesc = DispData.GetDescription((DisplayData::enIds)i);
-        if (pDesc && isDynamicValue(pDesc))
+        m_bFirstLine = true;
+        m_tiOpenFile = (uint32_t)SysClock::Millis() - 10000; // skip CSV_TABLE collection time
+        m_nBytes     = 0;
+        uint32_t heapStart = ESP.getFreeHeap();
+        uint32_t ti = micros();
+        for (int i = 0; i < nLoops; i++)
         {
-            strLog += "\t";
-            // format float value with correct precision
-            char strVal[20];
-            dtostrf(m_tableLineBuffer[i], 7, pDesc->nLogPrecision, strVal);
-            strLog += strVal;
+            // slowly changing values, ~10 values per second
+            DisplayData::enIds id = (DisplayData::enIds)(i % DisplayData::numElements);
+            bleVal.fVal = 100.0f + id + 20.0f * sinf(i * 0.002f + id);
+            Writeln(id, bleVal, DispData, formats[f], i * 100);
         }
+        m_binEncoder.FlushBlock();
+        ti = micros() - ti;
+        Serial.printf("FileLogger %-10s: %lu values, %lu bytes in %lu us, %lu KB/s, heap diff %ld\r\n", names[f], (unsigned long)nLoops,
+            (unsigned long)m_nBytes, (unsigned long)ti, (unsigned long)(ti ? (uint64_t)m_nBytes * 1000 / ti : 0), (long)(heapStart - ESP.getFreeHeap()));
     }
 
-    Serial.println(strLog.c_str());
-    return Writeln(strLog);
+    m_bSerialEcho = bEcho;
+    m_bFirstLine = true;
 }
-
@@ -12,6 +12,10 @@
 
 #include <LevoEsp32Ble.h>
 #include "DisplayData.h"
+#include "LogWriter.h"
+#include "LineBuffer.h"
+#include "BinLogEncoder.h"
+#include "LogManager.h"
 
 class FileLogger
 {
@@ -24,28 +28,48 @@ public:
         CSV_KNOWN,        // one line per value, time an distance stamp, numeric id for value type, no UNKNOWN message
         CSV_KNOWNCHANGED, // one line per value, time an distance stamp, numeric id for value type, only changed values, no UNKNOWN message
         CSV_TABLE,        // all values per line with time- and distance-stamp, no UNKNOWN messages
+        BIN_DELTA,        // binary, delta and varint coded values in blocks, see BinLogFormat.h
 
         NUM_FORMATS   // number of format constants, must be at last position
     } enLogFormat;
 
+    FileLogger() { m_binEncoder.SetOutput(binWrite, this); }
+
+    bool   Init(DisplayData& DispData); // once at boot: card usage, retention
     bool   Writeln(DisplayData::enIds id, LevoEsp32Ble::stBleVal& bleVal, DisplayData& DispData, enLogFormat format, uint32_t timestamp );
-    bool   Open();
+    bool   Open(enLogFormat format = CSV_SIMPLE);
     void   Close();
     void   Flush();
+    void   Poll(uint32_t timestamp); // time bounded flush of log buffer, rotation, background compression
+    void   NewRide();                // next log session goes to a new file
     int8_t PercentFull();
 
+    void   SetSerialEcho(bool bEcho) { m_bSerialEcho = bEcho; } // copy of each log line to serial
+    void   Benchmark(DisplayData& DispData);                    // formatting speed and heap usage to serial
+
 protected:
+    LogWriter  m_writer;
+    LogManager m_manager;
+    char       m_filename[LogManager::FILENAME_SIZE] = "";
+
     uint32_t m_tiOpenFile = 0;
     uint32_t m_tiStart = 0;
     float    m_kmStart = 0.0f;
     float    m_kmLast  = 0.0f;
     bool     m_bFirstLine = false;
+    bool     m_bSerialEcho = true;
+
+    // every line is formatted here
+    LineBuffer m_line;
 
+    uint32_t m_nBytes = 0; // bytes passed to log writer
+
+    bool  write(const void* pData, size_t len);
     bool  Writeln(const char* strLog);
-    bool  Writeln(std::string& strLog);
+    bool  Writeln(LineBuffer& line);
 
-    void  HexDump(char* pBuf, int nLen, std::string& str);
-    void  LogDump(DisplayData::enIds id, float val, DisplayData& DispData, std::string& str);
+    void  LogDump(DisplayData::enIds id, float val, DisplayData& DispData, LineBuffer& line);
+    void  appendStamp(LineBuffer& line, uint32_t timestamp);
 
     bool LogSimple(DisplayData::enIds id, LevoEsp32Ble::stBleVal& bleVal, DisplayData& DispData, uint32_t timestamp);
     bool LogCsvSimple( DisplayData::enIds id, LevoEsp32Ble::stBleVal& bleVal, DisplayData& DispData, enLogFormat format, uint32_t timestamp);
@@ -54,11 +78,28 @@ protected:
     // for CSV_TABLE log and value change detection
     float m_tableLineBuffer[DisplayData::numElements] = {0};
 
+    // CSV_TABLE column template: dynamic ids and their formatted values, built with the head line
+    enum { TABLE_COLSIZE = LineBuffer::FLOAT_SIZE };
+    uint8_t m_tableCols[DisplayData::numElements];
+    int     m_nTableCols = 0;
+    char    m_tableText[DisplayData::numElements][TABLE_COLSIZE];
+    uint8_t m_tableTextLen[DisplayData::numElements] = {0};
+    void    formatTableColumn(int id, const DisplayData::stDisplayData* pDesc);
+
     bool isStaticValue( const DisplayData::stDisplayData* pDesc )  { return (pDesc->flags & DisplayData::STATIC) ? true : false; }
     bool isDynamicValue( const DisplayData::stDisplayData* pDesc ) { return (pDesc->flags & DisplayData::DYNAMIC) ? true : false; }
     bool isTripValue( const DisplayData::stDisplayData* pDesc)     { return (pDesc->flags & DisplayData::TRIP) ? true : false; }
 
     bool hasChanged( float fVal1, float fVal2, int precision );
+
+    // BIN_DELTA: one block is collected by the encoder, then passed to the log writer
+    enLogFormat     m_format = NONE;
+    BinLogEncoder   m_binEncoder;
+    RTC_TimeTypeDef m_openTime;
+    RTC_DateTypeDef m_openDate;
+
+    bool LogBinDelta(DisplayData::enIds id, LevoEsp32Ble::stBleVal& bleVal, DisplayData& DispData, uint32_t timestamp);
+    static bool binWrite(void* pCtx, const void* pData, size_t len) { return ((FileLogger*)pCtx)->write(pData, len); }
 };
 
 #endif // FILE_LOGGER_H
\ No newline at end of file
@@ -13,15 +13,119 @@
 // - 0,5% is 0.29 --> will this sensor be too noisy for this ? May be baro inclination will be better :-(
 
 #include "IMUSensors.h"
+#include "SysClock.h"
+
+// Mahony gains: accelerometer correction with time constant 2 / TWO_KP = 2 s,
+// slow integral feedback compensates gyro bias
+#define TWO_KP 1.0f
+#define TWO_KI 0.02f
+#define RAD2DEG 57.29578f
+#define DEG2RAD 0.01745329f
 
 bool IMUSensors::Init()
 {
-    if (M5.IMU.Init() == 0)
+    if (M5.IMU.Init() != 0)
+        return false;
+
+    M5.IMU.SetGyroFsr(MPU6886::GFS_250DPS);
+    M5.IMU.SetAccelFsr(MPU6886::AFS_8G); // bumps do not saturate
+    m_hQueue = xQueueCreate(QUEUE_LEN, sizeof(stSample));
+    m_stats.tiStart = millis();
+    xTaskCreatePinnedToCore(imuTask, "IMU", 3072, this, 2, &m_hTask, 0);
+    return m_hTask != NULL;
+}
+
+// fixed rate, the filter gets the real time step anyway
+void IMUSensors::imuTask(void* pParam)
+{
+    IMUSensors* pThis = (IMUSensors*)pParam;
+    TickType_t tiWake = xTaskGetTickCount();
+    for (;;)
+    {
+        pThis->sample();
+        vTaskDelayUntil(&tiWake, pdMS_TO_TICKS(pThis->m_sampleMs));
+    }
+}
+
+void IMUSensors::sample()
+{
+    float ax, ay, az, gx, gy, gz;
+    uint32_t us = micros();
+    M5.IMU.getAccelData(&ax, &ay, &az);
+    M5.IMU.getGyroData(&gx, &gy, &gz);
+    uint32_t usRead = micros();
+    m_stats.busUs += usRead - us;
+
+    if (m_usLast == 0)
+        initOrientation(ax, ay, az);
+    else
+    {
+        uint32_t dtUs = us - m_usLast;
+        if (dtUs > m_stats.maxDtUs)
+            m_stats.maxDtUs = dtUs;
+        mahonyUpdate(gx * DEG2RAD, gy * DEG2RAD, gz * DEG2RAD, ax, ay, az, dtUs / 1000000.0f);
+    }
+    m_usLast = us;
+
+    stSample s;
+    s.us    = us;
+    s.pitch = asinf(-2.0f * (m_q1 * m_q3 - m_q0 * m_q2)) * RAD2DEG;
+    s.roll  = atan2f(2.0f * (m_q0 * m_q1 + m_q2 * m_q3), 1.0f - 2.0f * (m_q1 * m_q1 + m_q2 * m_q2)) * RAD2DEG;
+    if (xQueueSend(m_hQueue, &s, 0) != pdTRUE)
+        m_stats.nDropped++;
+
+    m_stats.filterUs += micros() - usRead;
+    m_stats.nSamples++;
+}
+
+// start with the gravity vector, no settling time
+void IMUSensors::initOrientation(float ax, float ay, float az)
+{
+    float roll  = atan2f(ay, az) * 0.5f;
+    float pitch = atan2f(-ax, sqrtf(ay * ay + az * az)) * 0.5f;
+    float cr = cosf(roll), sr = sinf(roll), cp = cosf(pitch), sp = sinf(pitch);
+    m_q0 = cr * cp;
+    m_q1 = sr * cp;
+    m_q2 = cr * sp;
+    m_q3 = -sr * sp;
+}
+
+// Mahony AHRS without magnetometer, gyro in rad/s, dt in s
+void IMUSensors::mahonyUpdate(float gx, float gy, float gz, float ax, float ay, float az, float dt)
+{
+    float norm = sqrtf(ax * ax + ay * ay + az * az);
+    if (norm > 0.0f)
     {
-        M5.IMU.SetGyroFsr(MPU6886::GFS_250DPS);
-        return true;
+        ax /= norm; ay /= norm; az /= norm;
+
+        // estimated direction of gravity and error to measured direction
+        float vx = m_q1 * m_q3 - m_q0 * m_q2;
+        float vy = m_q0 * m_q1 + m_q2 * m_q3;
+        float vz = m_q0 * m_q0 - 0.5f + m_q3 * m_q3;
+        float ex = ay * vz - az * vy;
+        float ey = az * vx - ax * vz;
+        float ez = ax * vy - ay * vx;
+
+        m_ix += TWO_KI * ex * dt;
+        m_iy += TWO_KI * ey * dt;
+        m_iz += TWO_KI * ez * dt;
+        gx += TWO_KP * ex + m_ix;
+        gy += TWO_KP * ey + m_iy;
+        gz += TWO_KP * ez + m_iz;
     }
-    return false;
+
+    // integrate rate of change of quaternion
+    gx *= 0.5f * dt;
+    gy *= 0.5f * dt;
+    gz *= 0.5f * dt;
+    float qa = m_q0, qb = m_q1, qc = m_q2;
+    m_q0 += -qb * gx - qc * gy - m_q3 * gz;
+    m_q1 +=  qa * gx + qc * gz - m_q3 * gy;
+    m_q2 +=  qa * gy - qb * gz + m_q3 * gx;
+    m_q3 +=  qa * gz + qb * gy - qc * gx;
+
+    norm = sqrtf(m_q0 * m_q0 + m_q1 * m_q1 + m_q2 * m_q2 + m_q3 * m_q3);
+    m_q0 /= norm; m_q1 /= norm; m_q2 /= norm; m_q3 /= norm;
 }
 
 void IMUSensors::FeedValue(DisplayData::enIds id, float fVal, uint32_t timestamp)
@@ -33,12 +137,50 @@ void IMUSensors::FeedValue(DisplayData::enIds id, float fVal, uint32_t timestamp
     }
 }
 
+// average of all samples since last publish, roll is bike pitch in mounting position
 bool IMUSensors::Update(DisplayData::enIds& id, float& fVal, uint32_t timestamp)
 {
-    float pitch, roll, yaw;
-    M5.IMU.getAhrsData(&pitch, &roll, &yaw);
-    fVal = roll;
+    if (m_hQueue == NULL)
+        return false;
+
+    stSample s;
+    while (xQueueReceive(m_hQueue, &s, 0) == pdTRUE)
+    {
+        if (m_nSum == 0)
+            m_usFirst = s.us;
+        m_sumOffsUs += s.us - m_usFirst;
+        m_sumRoll += s.roll;
+        m_nSum++;
+    }
+    if (m_nSum == 0 || !SysClock::IsDue(timestamp, m_tiPublish))
+        return false;
+
+    m_tiPublish = timestamp + PUBLISH_MS;
+    m_stats.sumLagUs += micros() - (m_usFirst + m_sumOffsUs / m_nSum);
+    m_stats.nPublished++;
+
     id = DisplayData::GYRO_PITCH;
+    fVal = round(m_sumRoll / m_nSum * 10.0) / 10.0;
+    m_sumRoll = 0.0;
+    m_sumOffsUs = 0;
+    m_nSum = 0;
     return true;
 }
 
+// lag: mean sample age at publish, the filter adds its accelerometer time constant
+void IMUSensors::PrintStats()
+{
+    uint32_t ms = millis() - m_stats.tiStart;
+    if (ms == 0 || m_hTask == NULL)
+        return;
+    Serial.printf("IMU: %.1f samples/s, CPU %u us/s (I2C %u, filter %u), max interval %u us, %u dropped, lag %u ms\r\n",
+        m_stats.nSamples * 1000.0 / ms,
+        (uint32_t)((uint64_t)(m_stats.busUs + m_stats.filterUs) * 1000 / ms),
+        (uint32_t)((uint64_t)m_stats.busUs * 1000 / ms),
+        (uint32_t)((uint64_t)m_stats.filterUs * 1000 / ms),
+        m_stats.maxDtUs, m_stats.nDropped,
+        m_stats.nPublished ? m_stats.sumLagUs / m_stats.nPublished / 1000 : 0);
+    m_stats.nSamples = m_stats.nDropped = m_stats.busUs = m_stats.filterUs = m_stats.maxDtUs = 0;
+    m_stats.nPublished = m_stats.sumLagUs = 0;
+    m_stats.tiStart = millis();
+}
@@ -5,6 +5,15 @@
  *
  * deliver IMU sensor data
  *
+ * A task on core 0 samples the MPU6886 every SAMPLE_MS (slower in power
+ * saving modes) and runs a Mahony AHRS filter with the measured time step
+ * of each sample. Orientation
+ * samples go through a queue to the main loop, Update() averages all
+ * samples since the last call (decimation) and publishes GYRO_PITCH.
+ *
+ * The MPU6886 shares Wire1 with AXP192, RTC and touch. TwoWire serializes
+ * the bus between tasks since arduino-esp32 2.0.
+ *
  */
 
 #ifndef IMUSENSORS_H
@@ -17,12 +26,61 @@
 class IMUSensors
 {
 public:
+    enum
+    {
+        SAMPLE_MS  = 10,  // 100 Hz
+        QUEUE_LEN  = 32,  // samples, main loop may be late by 320 ms
+        PUBLISH_MS = 100, // decimated to 10 Hz
+    };
+
     bool Init();
 
     void FeedValue(DisplayData::enIds id, float fVal, uint32_t timestamp); // value from any other sensor
     bool Update(DisplayData::enIds& id, float& fVal, uint32_t timestamp);  // poll IMU sensor values
+    void PrintStats(); // task CPU time, I2C time, drops and lag since last call
+    void SetSampleInterval(uint32_t ms) { m_sampleMs = ms ? ms : SAMPLE_MS; } // power mode
 
 protected:
+    struct stSample
+    {
+        uint32_t us;    // sample time
+        float    pitch; // degrees
+        float    roll;
+    };
+
+    TaskHandle_t  m_hTask  = NULL;
+    QueueHandle_t m_hQueue = NULL;
+    volatile uint32_t m_sampleMs = SAMPLE_MS;
+
+    // Mahony filter, used by task only
+    float    m_q0 = 1.0, m_q1 = 0.0, m_q2 = 0.0, m_q3 = 0.0;
+    float    m_ix = 0.0, m_iy = 0.0, m_iz = 0.0; // integral feedback, gyro bias
+    uint32_t m_usLast = 0;
+
+    // decimation
+    float    m_sumRoll = 0.0;
+    uint32_t m_usFirst = 0;    // first sample of window
+    uint32_t m_sumOffsUs = 0;  // sample times relative to first sample
+    int      m_nSum = 0;
+    uint32_t m_tiPublish = 0;
+
+    // statistics, counters written by task
+    struct stStats
+    {
+        uint32_t tiStart;
+        volatile uint32_t nSamples;
+        volatile uint32_t nDropped;  // queue full
+        volatile uint32_t busUs;     // I2C reads
+        volatile uint32_t filterUs;  // AHRS update
+        volatile uint32_t maxDtUs;   // longest sample interval
+        uint32_t nPublished;
+        uint32_t sumLagUs;           // sample to publish
+    } m_stats = {};
+
+    static void imuTask(void* pParam);
+    void sample();
+    void initOrientation(float ax, float ay, float az);
+    void mahonyUpdate(float gx, float gy, float gz, float ax, float ay, float az, float dt);
 };
 
-#endif // IMUSENSORS_H
\ No newline at end of file
+#endif // IMUSENSORS_H
@@ -3,14 +3,13 @@
  *      Author: Bernd Wokoeck
  *
  *  Displays Specialized Levo 2019+ telemetry values to M5Core2 display
- *  and logs data to SD card (<date>.log and summary file <date>.txt)
+ *  and logs data to SD card (<date><ride>.log, ride index rides.idx and summary file <date>.txt)
  *  
  *  Library dependencies:
  *  https://github.com/h2zero/NimBLE-Arduino
  *  https://github.com/m5stack/M5Core2
  *  https://github.com/ropg/ezTime
  *  https://github.com/tanakamasayuki/I2C_BM8563
- *  https://github.com/adafruit/Adafruit_BMP280_Library
  *  https://github.com/Sepp62/BikePowerCalc
  * 
  *  Images converted with: https://lvgl.io/tools/imageconverter (True color, C-Array)
@@ -36,23 +35,43 @@
 #include <M5Core2.h>
 #include <Preferences.h>
 #include <LevoReadWrite.h>
+#include "Settings.h"
 #include "DisplayData.h"
 #include "SystemStatus.h"
 #include "M5System.h"
 #include "M5Screen.h"
 #include "FileLogger.h"
+#include "LogJournal.h"
+#include "M5ConfigForms.h"
 #include "M5ConfigFormTune.h"
+#include "M5MsgBox.h"
 #include "AltimeterBMP280.h"
 #include "VirtualSensors.h"
 #include "IMUSensors.h"
 #include "PowerUtil.h"
+#include "TripCheckpoint.h"
+#include "BootTimer.h"
+#include "PowerMath.h"
+#include "M5PowerMode.h"
+#include "M5Battery.h"
+#include "SysClock.h"
 
 // #define SIMULATOR
 #ifdef SIMULATOR
     #include "Simulator.h"
     Simulator SensorSimulator;
+    #define SIMULATOR_SPEED   1.0f // replay speed, 0: as fast as possible
+    #define SIMULATOR_START_S 0    // start replay at this log time in seconds
 #endif
 
+// #define LOGGER_BENCHMARK    // log formatting speed on serial
+// #define SCREEN_STATS        // display render statistics on serial every minute
+// #define SCREEN_BENCHMARK    // value draw time with and without glyph atlas on serial
+// #define ALTIMETER_STATS     // altimeter I2C bus time and noise on serial every minute
+// #define IMU_STATS           // IMU task CPU time, drops and lag on serial every minute
+// #define POWERMODE_STATS     // time and battery current per power mode on serial every minute
+// #define BATTERY_STATS       // M5 battery telemetry on serial every minute
+
 // sensor value sources
 typedef enum enValueSource
 {
@@ -64,6 +83,7 @@ typedef enum enValueSource
 };
 
 Preferences     Prefs;
+Settings        Config;
 LevoReadWrite   LevoBle;
 DisplayData     DispData;
 M5System        Core2;
@@ -74,16 +94,47 @@ AltimeterBMP280 Altimeter;
 VirtualSensors  VirtSensors;
 IMUSensors      IMU;
 PowerUtil       Power;
+TripCheckpoint  Checkpoint;
+M5PowerMode     PowerMode(IMU);
+M5Battery       Battery;
+
+// forms run from the main loop, one at a time
+M5ConfigForms    ConfigForms(&Power);
+M5ConfigFormTune TuneForm(LevoBle);
+M5MsgBox         FinishBox;
+typedef enum
+{
+    FORM_NONE = 0,
+    FORM_SETTINGS,
+    FORM_TUNE,
+    FORM_FINISH,
+} enForm;
+enForm _activeForm = FORM_NONE;
+
+// BLE stays connected while settings are open, what a visit costs is printed on close
+struct
+{
+    bool     bActive;
+    bool     bRestarted;   // pin or enable changed, wait for BLE data again
+    uint32_t pin;          // on open
+    bool     bBtEnabled;
+    uint32_t tiOpen;
+    uint32_t tiClose;
+    uint32_t tiLastValue;  // 0: no BLE data yet
+    uint32_t maxGapMs;     // longest time without BLE data
+    uint16_t nConnects;
+    uint16_t nConnectsOnClose;
+} _visit = {};
 
 // local settings
 FileLogger::enLogFormat _logFormat = FileLogger::CSV_SIMPLE;
 bool     _bBtEnabled = true;
-uint16_t _backlightTimeout = 60;
-bool     _bBacklightCharging = true;
 float    _sealevelhPa = 1013.25;
 bool     _bPwrCalibEnabled = false;
 
-M5Screen::enScreens currentScreen = M5Screen::SCREEN_A;
+volatile bool _bSdReady = false; // boot: SD card checked and logger initialized
+
+int currentScreen = 0; // index in screen layout
 
 // settings button
 Button btSettings(220, 0, 100, 60); // top right corner
@@ -107,88 +158,185 @@ void uninstallButtonHandlers()
     M5.Buttons.draw();
 }
 
-// read all settings to local settings
+// copy settings to local settings
 void readPreferences()
 {
-    _logFormat          = (FileLogger::enLogFormat)Prefs.getUChar("LogFormat");
-    _bBtEnabled         = Prefs.getUChar("BtEnabled", 1) ? true : false;
-    _backlightTimeout   = Prefs.getUShort("BacklightTo", 60);
-    _bBacklightCharging = Prefs.getUChar("BacklightChg", 1) ? true : false;
-    _sealevelhPa        = Prefs.getFloat("SealevelhPa", 1013.25);
-    _bPwrCalibEnabled   = Prefs.getUChar("PwrCalibEnabled", 0) ? true : false;
-
-    Serial.printf("Log format: %d\r\n", _logFormat);
-    Serial.printf("Bluetooth enabled: %d\r\n", _bBtEnabled);
-    Serial.printf("Backlight timeout: %d\r\n", _backlightTimeout);
-    Serial.printf("Backlight while charging: %d\r\n", _bBacklightCharging);
-    Serial.printf("SealevelPressure (hPa): %f\r\n", _sealevelhPa);
-    Serial.printf("PwrCalibEnabled: %d\r\n", _bPwrCalibEnabled);
+    _logFormat          = (FileLogger::enLogFormat)Config.GetUInt(Settings::LOG_FORMAT);
+    _bBtEnabled         = Config.GetBool(Settings::BT_ENABLED);
+    _sealevelhPa        = Config.GetFloat(Settings::SEALEVEL_HPA);
+    _bPwrCalibEnabled   = Config.GetBool(Settings::PWR_CALIB_ENABLED);
+}
+
+// a setting was changed: update only what depends on it
+void onSettingChanged(Settings::enIds id)
+{
+    switch (id)
+    {
+    case Settings::LOG_FORMAT:
+    case Settings::BT_ENABLED:
+        readPreferences();
+        break;
+    case Settings::SEALEVEL_HPA:
+        readPreferences();
+        Altimeter.SetSealevel(_sealevelhPa);
+        break;
+    case Settings::PWR_CALIB_ENABLED:
+        readPreferences();
+        Power.EnableCalibrationMode(_bPwrCalibEnabled);
+        break;
+    default:
+        Power.OnSettingChanged(Config, id);
+        Core2.OnSettingChanged(Config, id);
+        break;
+    }
 }
 
 // Read bluetooth pin from preferences
 uint32_t ReadBluetoothPin()
 {
-    uint32_t pin = Prefs.getULong("BtPin", 0);
+    uint32_t pin = Config.GetUInt(Settings::BT_PIN);
     SysStatus.bHasBtPin = (pin != 0) ? true : false;
     return pin;
 }
 
-void onBtSettings(Event& e)
+// a form takes over the LCD and touch, sensors and logging keep running
+void openForm(enForm form)
 {
-    Serial.println("Show settings");
-    LevoBle.Disconnect();
     uninstallButtonHandlers();
-    // Show menu
-    Screen.ShowConfig(Prefs);
-    // refresh settings
-    readPreferences();
-    // reinit power calc
-    Power.SysParamsInit(Prefs);
-    Power.EnableCalibrationMode(_bPwrCalibEnabled);
-    // reinit display
+    Screen.SetHidden(true);
+    _activeForm = form;
+}
+
+void closeForm()
+{
+    _activeForm = FORM_NONE;
     Core2.ResetDisplayTimer();
-    Core2.SetBacklightSettings( _backlightTimeout, _bBacklightCharging );
-    installButtonHandlers();
+    Screen.SetHidden(false);
     Screen.Init(currentScreen, DispData);
-    SysStatus.ResetBleStatus();
-    Screen.ShowSysStatus();
-    // reconnect BLE
-    if( _bBtEnabled )
-        LevoBle.Reconnect();
+    installButtonHandlers();
 }
 
-void onBtTripOrTune(Event& e)
+void onBtSettings(Event& e)
 {
-    // start: 0, stop: 1, finish: 2, tune: 3
-    // tune
-    if( e.button->userData == M5Screen::BTTUNE )
+    Serial.println("Show settings");
+    visitStart((uint32_t)SysClock::Millis());
+    openForm(FORM_SETTINGS);
+    ConfigForms.Open(Config);
+}
+
+void visitStart(uint32_t ti)
+{
+    memset(&_visit, 0, sizeof(_visit));
+    _visit.bActive     = true;
+    _visit.pin         = Config.GetUInt(Settings::BT_PIN);
+    _visit.bBtEnabled  = _bBtEnabled;
+    _visit.tiOpen      = ti;
+    _visit.tiLastValue = LevoBle.IsConnected() ? ti : 0;
+}
+
+void visitOnBleValue(uint32_t ti)
+{
+    if (!_visit.bActive)
+        return;
+    if (_visit.tiLastValue != 0 && ti - _visit.tiLastValue > _visit.maxGapMs)
+        _visit.maxGapMs = ti - _visit.tiLastValue;
+    _visit.tiLastValue = ti;
+
+    // first value after restart
+    if (_visit.bRestarted && _visit.nConnects > _visit.nConnectsOnClose)
     {
-        uninstallButtonHandlers();
-        M5ConfigFormTune form(LevoBle);
-        Core2.ResetDisplayTimer();
-        Screen.Init(currentScreen, DispData);
-        installButtonHandlers();
+        Serial.printf("Settings: BLE data %u ms after close, %u reconnects, max data gap %u ms\r\n",
+            ti - _visit.tiClose, _visit.nConnects, _visit.maxGapMs);
+        _visit.bActive = false;
     }
-    // finish
-    else if (e.button->userData == M5Screen::BTFINISH)
+}
+
+// reconnect only if pin or BT enable changed
+void visitEnd(uint32_t ti)
+{
+    _visit.tiClose = ti;
+    uint32_t pin = ReadBluetoothPin();
+    if (pin != _visit.pin || _bBtEnabled != _visit.bBtEnabled)
+    {
+        LevoBle.SetPin(pin);
+        if (_bBtEnabled && pin != 0)
+        {
+            LevoBle.Restart();
+            _visit.bRestarted = true;
+        }
+        else
+            LevoBle.Disconnect();
+    }
+
+    if (_visit.tiLastValue != 0 && LevoBle.IsConnected() && ti - _visit.tiLastValue > _visit.maxGapMs)
+        _visit.maxGapMs = ti - _visit.tiLastValue;
+    Serial.printf("Settings: open %u s, %u reconnects, max BLE data gap %u ms%s\r\n",
+        (ti - _visit.tiOpen) / 1000, _visit.nConnects, _visit.maxGapMs,
+        _visit.bRestarted ? ", BLE restarted" : "");
+    _visit.nConnectsOnClose = _visit.nConnects;
+    _visit.bActive = _visit.bRestarted;
+}
+
+// poll the open form, close it when done
+void updateForm(uint32_t ti)
+{
+    switch (_activeForm)
+    {
+    case FORM_SETTINGS:
+        if (ConfigForms.Update(ti))
+            break;
+        // changes are applied by onSettingChanged(), write them to flash at once
+        Config.Commit();
+        closeForm();
+        visitEnd(ti);
+        break;
+    case FORM_TUNE:
+        if (!TuneForm.Update(ti))
+            closeForm();
+        break;
+    case FORM_FINISH:
     {
-        uninstallButtonHandlers();
-        if (M5ConfigForms::MsgBox("Finish tour & reset trip data?", M5ConfigForms::YESNO) == M5ConfigForms::RET_YES)
+        M5MsgBox::enMsgBoxReturn ret;
+        if (!FinishBox.Update(ret))
+            break;
+        if (ret == M5MsgBox::RET_YES)
         {
             if( SysStatus.tripStatus != SystemStatus::NONE )
                     VirtSensors.WriteStatisticsSD(DispData);
             VirtSensors.ResetTrip();
             SysStatus.tripStatus = SystemStatus::NONE;
+            Checkpoint.Save();
+            Logger.NewRide();
         }
-        Core2.ResetDisplayTimer();
-        Screen.Init(currentScreen, DispData);
-        installButtonHandlers();
+        closeForm();
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void onBtTripOrTune(Event& e)
+{
+    // start: 0, stop: 1, finish: 2, tune: 3
+    // tune
+    if( e.button->userData == M5Screen::BTTUNE )
+    {
+        openForm(FORM_TUNE);
+        TuneForm.Open();
+    }
+    // finish, trip is reset in updateForm()
+    else if (e.button->userData == M5Screen::BTFINISH)
+    {
+        openForm(FORM_FINISH);
+        FinishBox.Open("Finish tour & reset trip data?", M5MsgBox::YESNO);
     }
     // start
     else if (e.button->userData == M5Screen::BTSTART)
     {
         VirtSensors.StartTrip(DispData);
         SysStatus.tripStatus = SystemStatus::STARTED;
+        Checkpoint.Save();
     }
     // stop
     else if (e.button->userData == M5Screen::BTSTOP)
@@ -197,22 +345,24 @@ void onBtTripOrTune(Event& e)
         {
             VirtSensors.StopTrip();
             SysStatus.tripStatus = SystemStatus::STOPPED;
+            Checkpoint.Save();
         }
     }
 }
 
 void onBtScreen(Event& e)
 {
-    M5Screen::enScreens newScreen = M5Screen::UNDEFINED;
+    int button = -1;
 
-    // change screen
+    // change screen, a button cycles through its screens
     if (M5.BtnA.wasPressed())
-        newScreen = M5Screen::SCREEN_A;
+        button = 0;
     else if (M5.BtnB.wasPressed())
-        newScreen = M5Screen::SCREEN_B;
+        button = 1;
     else if (M5.BtnC.wasPressed())
-        newScreen = M5Screen::SCREEN_C;
+        button = 2;
 
+    int newScreen = (button >= 0) ? Screen.NextScreen(button, currentScreen) : M5Screen::UNDEFINED;
     if (newScreen != M5Screen::UNDEFINED && newScreen != currentScreen)
     {
         currentScreen = newScreen;
@@ -225,8 +375,12 @@ void BleStatusChanged()
 {
     if (LevoBle.GetBleStatus() == LevoEsp32Ble::CONNECTED)
     {
-        // open log file
-        SysStatus.bLogging = Logger.Open();
+        BootTimer::Mark(BootTimer::BLE_CONNECT);
+        if (_visit.bActive)
+            _visit.nConnects++;
+        // open log file, as soon as the SD card is ready
+        if (_bSdReady)
+            SysStatus.bLogging = Logger.Open(_logFormat);
     }
     else
     {
@@ -322,6 +476,8 @@ void FeedForward( DisplayData::enIds id, float fVal, uint32_t timestamp, enValue
         IMU.FeedValue( id, fVal, timestamp );
     if (enSource != SRC_POWER )
         Power.FeedValue(id, fVal, timestamp);
+    if (enSource == SRC_BLE)
+        PowerMode.FeedValue(id, fVal, timestamp);
 }
 
 void CheckCalibration()
@@ -341,14 +497,14 @@ void CheckCalibration()
     float cR, cwA;
     if( Power.GetCalibrationResult( cR, cwA ) )
     {
-        Power.CalibrationSave( Prefs, cR, cwA );
+        Power.CalibrationSave( Config, cR, cwA );
     }
 
     // check compensation factor for electric power efficiency: calcPower = (motorPower * eta) + riderPower
     float eta;
     if (Power.GetEta(eta))
     {
-        Power.EtaSave( Prefs, eta );
+        Power.EtaSave( Config, eta );
     }
 }
 
@@ -361,31 +517,68 @@ void Simulate(uint32_t timestamp)
     // _bBtEnabled = true;
     // SysStatus.UpdateBleStatus(LevoEsp32Ble::CONNECTED);
     SysStatus.bHasAltimeter = false;
-    if (SensorSimulator.Update( id, fVal, timestamp ) )
+    // all due values, limited per loop for max. speed replay
+    for (int i = 0; i < 64 && SensorSimulator.Update( id, fVal, timestamp ); i++)
     {
         // Serial.printf("id: %d, val: %f\r\n", id, fVal );
+        uint32_t simTime = SensorSimulator.GetTime();
         Screen.ShowValue(id, fVal, DispData); // ouput to screen
-        VirtSensors.FeedValue(id, fVal, timestamp);
-        Power.FeedValue(id, fVal, timestamp);
+        VirtSensors.FeedValue(id, fVal, simTime);
+        Power.FeedValue(id, fVal, simTime);
     }
 }
 #endif
 
+// SD card work at boot, on core 0 while setup() and BLE continue
+void bootSdTask(void* pParam)
+{
+    // log data lost by power cut, card usage and retention
+    LogJournal::Recover();
+    Logger.Init(DispData);
+    #ifdef LOGGER_BENCHMARK
+        Logger.Benchmark(DispData);
+    #endif
+    BootTimer::Mark(BootTimer::SD_READY);
+    _bSdReady = true;
+    vTaskDelete(NULL);
+}
+
+// staged boot: settings, BLE scanning first, then display and sensors, SD card in background
 void setup ()
 {
+    Serial.begin(115200);
+    BootTimer::Mark(BootTimer::SETUP);
+
+    // get settings
     Prefs.begin("LevoEsp32", false);
+    Config.Load(Prefs);
+    readPreferences();
+    BootTimer::Mark(BootTimer::SETTINGS);
+
+    // bluetooth communication, scanning runs in the NimBLE task
+    LevoBle.Init( ReadBluetoothPin(), _bBtEnabled );
+    BootTimer::Mark(BootTimer::BLE_SCAN);
 
     // M5Core2 system init
     Core2.Init();
+    SysClock::Sync(); // the only RTC read, wall clock follows the monotonic clock
+    Battery.Init();
     Core2.CheckSDCard(SysStatus);
-    delay(500);
+    Core2.SetBacklightSettings(Config.GetUInt(Settings::BACKLIGHT_TO), Config.GetBool(Settings::BACKLIGHT_CHG));
+    // layout file is read before the SD task takes the card
+    Screen.LoadLayout(Prefs, DispData, SysStatus.bHasSDCard);
+    if (SysStatus.bHasSDCard)
+        xTaskCreatePinnedToCore(bootSdTask, "BootSD", 4096, NULL, 1, NULL, 0);
+    else
+        _bSdReady = true;
+    BootTimer::Mark(BootTimer::M5_INIT);
 
-    // get settings
-    readPreferences();
-    Core2.SetBacklightSettings(_backlightTimeout, _bBacklightCharging);
+    // lookup tables for altitude and power calculation
+    PowerMath::Init();
 
     // altimeter
     SysStatus.bHasAltimeter = Altimeter.Init();
+    Altimeter.SetSealevel(_sealevelhPa);
     if( !SysStatus.bHasAltimeter )
     {
         DispData.Hide(DisplayData::BARO_ALTIMETER );
@@ -395,42 +588,61 @@ void setup ()
     }
 
     // IMU
-    // SysStatus.bHasIMU = IMU.Init();
+    SysStatus.bHasIMU = IMU.Init(); // sampling task on core 0
+    PowerMode.Init();
     if (!SysStatus.bHasIMU)
     {
         DispData.Hide(DisplayData::GYRO_PITCH);
     }
-
-    // all screen output
-    Screen.SetButtonBarHandler( onBtTripOrTune );
-    Screen.Init(M5Screen::SCREEN_A, DispData);
-
-    // bluetooth communication
-    LevoBle.Init( ReadBluetoothPin(), _bBtEnabled );
+    BootTimer::Mark(BootTimer::SENSORS);
 
     // enable power calibration
-    Power.SysParamsInit( Prefs );
+    Power.SysParamsInit( Config );
     Power.EnableCalibrationMode( _bPwrCalibEnabled );
+    Config.AddListener( onSettingChanged );
+
+    // continue trip and energy calculation after reboot
+    Checkpoint.Init( Prefs, VirtSensors, Power, SysStatus );
+    Checkpoint.Restore( DispData );
+
+    // all screen output
+    Screen.SetButtonBarHandler( onBtTripOrTune );
+    Screen.Init(currentScreen, DispData);
+    #ifdef SCREEN_BENCHMARK
+        Screen.Benchmark();
+        Screen.Init(currentScreen, DispData);
+    #endif
+    BootTimer::Mark(BootTimer::SCREEN);
 
     // buttons
     installButtonHandlers();
+
+    #ifdef SIMULATOR
+        SensorSimulator.SetSpeed(SIMULATOR_SPEED);
+        if (SensorSimulator.Open("/simulator.txt", DispData) && SIMULATOR_START_S > 0)
+            SensorSimulator.SeekTime(SIMULATOR_START_S * 1000L);
+    #endif
+    BootTimer::Mark(BootTimer::LOOP);
 }
 
 // running on core 1: xPortGetCoreID()
 //////////////////////////////////////
 void loop ()
 {
-    static uint32_t ti50   = millis() + 50L;
-    static uint32_t ti100  = millis() + 100L;
-    static uint32_t ti1000 = millis() + 1000L;
+    static uint64_t ti50   = SysClock::Millis() + 50L;
+    static uint64_t ti100  = SysClock::Millis() + 100L;
+    static uint64_t ti1000 = SysClock::Millis() + 1000L;
 
-    // call timer once
-    uint32_t ti = millis();
+    // call timer once: 64 bit for the schedule, components get 32 bit ms and compare by difference
+    uint64_t now = SysClock::Millis();
+    uint32_t ti  = (uint32_t)now;
 
-    // bluetooth handling
+    // bluetooth handling, the tune form takes the values while it reads the assist data
     LevoEsp32Ble::stBleVal bleVal;
-    if (LevoBle.Update(bleVal))
+    if (!TuneForm.IsReading() && LevoBle.Update(bleVal))
     {
+        BootTimer::Mark(BootTimer::BLE_VALUE);
+        visitOnBleValue(ti);
         DisplayData::enIds id = ShowBleData( bleVal, ti );
         FeedForward( id, bleVal.fVal, ti, SRC_BLE );
     }
@@ -439,10 +651,10 @@ void loop ()
         Simulate( ti );
     #endif 
 
-    // do all 50ms
-    if (ti >= ti50)
+    // do all 50ms, less often in power saving modes
+    if (now >= ti50)
     {
-        ti50 = ti + 50L;
+        ti50 = now + PowerMode.GetPollInterval(50L);
         // get virtual sensor values
         DisplayData::enIds id; float fVal;
         if (VirtSensors.Update(id, fVal, ti))
@@ -450,20 +662,46 @@ void loop ()
             ShowFloatData(id, fVal, ti);
             FeedForward( id, fVal, ti, SRC_VIRT );
         }
+
+        // altimeter: forced mode conversions, altitude 4 Hz, temperature 1 Hz
+        if (SysStatus.bHasAltimeter && Altimeter.Update(id, fVal, ti))
+        {
+            ShowFloatData(id, fVal, ti);
+            FeedForward( id, fVal, ti, SRC_BARO );
+        }
     }
 
     // do all 100ms
-    if (ti >= ti100)
+    if (now >= ti100)
     {
-        ti100 = ti + 100L;
+        ti100 = now + 100L;
+        DisplayData::enIds id; float fVal;
+
+        // M5 battery, AXP192 bulk read when due, run time to screen and log
+        if (Battery.Update(id, fVal, ti))
+            ShowFloatData(id, fVal, ti);
+
         // print system status to screen
         SysStatus.UpdateBleStatus( LevoBle.GetBleStatus() );
-        Core2.CheckPowerSupply(SysStatus);
+        Core2.CheckPowerSupply(SysStatus, Battery);
         if (Screen.ShowSysStatus())
             BleStatusChanged();
 
+        // SD card ready after boot: deferred SD work, log file if already connected
+        static bool bSdStarted = false;
+        if (_bSdReady && !bSdStarted)
+        {
+            bSdStarted = true;
+            if (SysStatus.bHasSDCard)
+                Power.WriteEtaLogHeader();
+            BleStatusChanged();
+        }
+
+        // write buffered log data to SD, compression not before boot SD task is done
+        if (_bSdReady)
+            Logger.Poll(ti);
+
         // IMU
-        DisplayData::enIds id; float fVal;
         if ( SysStatus.bHasIMU && IMU.Update( id, fVal, ti ) )
         {
             ShowFloatData(id, fVal, ti);
@@ -472,23 +710,16 @@ void loop ()
 
         // dim display after some time
         Core2.DoDisplayTimer();
+        Screen.SetDimmed(Core2.IsDisplayOff());
+
+        // CPU clock and polling by display, BLE and ride activity
+        PowerMode.Update(LevoBle.IsConnected(), Core2.IsDisplayOff(), ti);
     }
 
     // do all 1000ms
-    if (ti >= ti1000)
+    if (now >= ti1000)
     {
-        ti1000 = ti + 1000L;
-        // Altimeter
-        if (SysStatus.bHasAltimeter)
-        {
-            float altitude = Altimeter.GetAltitude(_sealevelhPa);
-            ShowFloatData( DisplayData::BARO_ALTIMETER, altitude, ti );
-            FeedForward( DisplayData::BARO_ALTIMETER, altitude, ti, SRC_BARO );
-            float temp = Altimeter.GetTemp();
-            ShowFloatData(DisplayData::BARO_TEMP, temp, ti);
-            FeedForward(DisplayData::BARO_TEMP, temp, ti, SRC_BARO);
-        }
-
+        ti1000 = now + 1000L;
         // get calculated power data
         DisplayData::enIds id; float fVal;
         if (Power.Update(id, fVal, ti))
@@ -498,8 +729,68 @@ void loop ()
 
         // evaluate calibration status
         CheckCalibration();
+
+        // changed settings to flash, batched
+        Config.Poll(ti);
+
+        // trip and power state for resume after reboot
+        Checkpoint.Poll(ti);
+
+        // battery current per power mode, run time on battery
+        PowerMode.Sample(!Battery.IsExternalPower(), Battery.GetCurrent(), ti);
+
+        #ifdef SCREEN_STATS
+            static uint8_t statsCnt = 0;
+            if (++statsCnt >= 60)
+            {
+                statsCnt = 0;
+                Screen.PrintRenderStats();
+            }
+        #endif
+        #ifdef ALTIMETER_STATS
+            static uint8_t altiStatsCnt = 0;
+            if (++altiStatsCnt >= 60)
+            {
+                altiStatsCnt = 0;
+                Altimeter.PrintStats();
+            }
+        #endif
+        #ifdef IMU_STATS
+            static uint8_t imuStatsCnt = 0;
+            if (++imuStatsCnt >= 60)
+            {
+                imuStatsCnt = 0;
+                IMU.PrintStats();
+            }
+        #endif
+        #ifdef POWERMODE_STATS
+            static uint8_t pwrStatsCnt = 0;
+            if (++pwrStatsCnt >= 60)
+            {
+                pwrStatsCnt = 0;
+                PowerMode.PrintStats();
+            }
+        #endif
+        #ifdef BATTERY_STATS
+            static uint8_t battStatsCnt = 0;
+            if (++battStatsCnt >= 60)
+            {
+                battStatsCnt = 0;
+                Battery.PrintStats();
+            }
+        #endif
     }
 
+    // settings, tune or message box
+    if (_activeForm != FORM_NONE)
+        updateForm(ti);
+
+    // draw changed values at frame rate
+    Screen.Update(ti);
+
     // touch update
     M5.update();
+
+    // idle task may run or sleep in power saving modes
+    PowerMode.Yield();
 }
@@ -0,0 +1,139 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * fixed size text buffer for log lines, no heap allocations
+ *
+ */
+
+#include "LineBuffer.h"
+
+static const uint32_t s_pow10[] = { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+
+LineBuffer& LineBuffer::Append(char c)
+{
+    if (m_len < SIZE - 1)
+    {
+        m_buf[m_len++] = c;
+        m_buf[m_len] = '\0';
+    }
+    return *this;
+}
+
+LineBuffer& LineBuffer::Append(const char* str)
+{
+    return Append(str, strlen(str));
+}
+
+LineBuffer& LineBuffer::Append(const char* str, size_t len)
+{
+    len = min(len, SIZE - 1 - m_len);
+    memcpy(&m_buf[m_len], str, len);
+    m_len += len;
+    m_buf[m_len] = '\0';
+    return *this;
+}
+
+LineBuffer& LineBuffer::AppendPadded(const char* str, size_t width)
+{
+    size_t len = strlen(str);
+    Append(str, len);
+    while (len++ < width)
+        Append(' ');
+    return *this;
+}
+
+LineBuffer& LineBuffer::AppendInt(int32_t val)
+{
+    char s[12];
+    char* p = &s[sizeof(s)];
+    uint32_t u = (val < 0) ? -(uint32_t)val : val;
+    do
+    {
+        *--p = '0' + (u % 10);
+        u /= 10;
+    } while (u);
+    if (val < 0)
+        *--p = '-';
+    return Append(p, &s[sizeof(s)] - p);
+}
+
+LineBuffer& LineBuffer::AppendFloat(float val, int width, int precision)
+{
+    if (SIZE - m_len < FLOAT_SIZE)
+        return *this;
+    m_len += FormatFloat(&m_buf[m_len], val, width, precision);
+    m_buf[m_len] = '\0';
+    return *this;
+}
+
+LineBuffer& LineBuffer::AppendHex(const uint8_t* pData, size_t len)
+{
+    static const char hex[] = "0123456789abcdef";
+    for (size_t i = 0; i < len && m_len < SIZE - 4; i++)
+    {
+        m_buf[m_len++] = hex[pData[i] >> 4];
+        m_buf[m_len++] = hex[pData[i] & 0x0F];
+        m_buf[m_len++] = ' ';
+    }
+    m_buf[m_len] = '\0';
+    return *this;
+}
+
+LineBuffer& LineBuffer::AppendUnit(const char* strUnit)
+{
+    if (strUnit[0] == '&' && strUnit[1] == 'o')
+        return Append('\xb0');
+    return Append(strUnit);
+}
+
+// no printf, values beyond 32 bit range fall back to snprintf()
+size_t LineBuffer::FormatFloat(char* pDst, float val, int width, int precision)
+{
+    if (precision < 0)
+        precision = 0;
+    if (precision > 6 || isnan(val) || isinf(val) || fabsf(val) >= 4.0e9f)
+    {
+        snprintf(pDst, FLOAT_SIZE, "%*.*f", width, min(precision, 7), val);
+        return strlen(pDst);
+    }
+
+    // split first, subtracting the integer part is exact in float
+    bool     bNeg     = val < 0.0f;
+    float    absVal   = fabsf(val);
+    uint32_t intPart  = (uint32_t)absVal;
+    uint32_t fracPart = (uint32_t)((absVal - intPart) * s_pow10[precision] + 0.5f);
+    if (fracPart >= s_pow10[precision])
+    {
+        fracPart -= s_pow10[precision];
+        intPart++;
+    }
+    bool bZero = (intPart == 0 && fracPart == 0);
+
+    // build digits backwards
+    char s[FLOAT_SIZE];
+    char* p = &s[sizeof(s)];
+    for (int i = 0; i < precision; i++)
+    {
+        *--p = '0' + (fracPart % 10);
+        fracPart /= 10;
+    }
+    if (precision > 0)
+        *--p = '.';
+    do
+    {
+        *--p = '0' + (intPart % 10);
+        intPart /= 10;
+    } while (intPart);
+    if (bNeg && !bZero)
+        *--p = '-';
+
+    // right aligned like dtostrf()
+    size_t len = &s[sizeof(s)] - p;
+    size_t pad = (width > (int)len) ? min((size_t)(width - len), FLOAT_SIZE - 1 - len) : 0;
+    memset(pDst, ' ', pad);
+    memcpy(pDst + pad, p, len);
+    pDst[pad + len] = '\0';
+    return pad + len;
+}
@@ -0,0 +1,47 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * fixed size text buffer for log lines, no heap allocations
+ *
+ */
+
+#ifndef LINE_BUFFER_H
+#define LINE_BUFFER_H
+
+#include "Arduino.h"
+
+class LineBuffer
+{
+public:
+    enum
+    {
+        SIZE       = 768, // CSV_TABLE line with all dynamic values
+        FLOAT_SIZE = 24,  // max. size of a formatted float including '\0'
+    };
+
+    LineBuffer() { Clear(); }
+
+    void        Clear()            { m_len = 0; m_buf[0] = '\0'; }
+    const char* c_str() const      { return m_buf; }
+    size_t      Length() const     { return m_len; }
+
+    LineBuffer& Append(char c);
+    LineBuffer& Append(const char* str);
+    LineBuffer& Append(const char* str, size_t len);
+    LineBuffer& AppendPadded(const char* str, size_t width);         // left aligned, like %-14s
+    LineBuffer& AppendInt(int32_t val);
+    LineBuffer& AppendFloat(float val, int width, int precision);    // like dtostrf()
+    LineBuffer& AppendHex(const uint8_t* pData, size_t len);         // "xx " per byte
+    LineBuffer& AppendUnit(const char* strUnit);                     // "&o" -> degree symbol
+
+    // fixed precision float to text, right aligned to width, pDst holds FLOAT_SIZE chars, returns length
+    static size_t FormatFloat(char* pDst, float val, int width, int precision);
+
+protected:
+    char   m_buf[SIZE];
+    size_t m_len;
+};
+
+#endif // LINE_BUFFER_H
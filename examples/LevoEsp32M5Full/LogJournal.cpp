@@ -0,0 +1,255 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * crash safe journal for the log file
+ *
+ */
+
+#include <vector>
+#include <algorithm>
+#include "LogJournal.h"
+
+const char* LogJournal::s_filename = "/journal.jnl";
+
+// CRC-32 (IEEE), nibble table
+uint32_t LogJournal::crc32(const uint8_t* pData, size_t len, uint32_t crc)
+{
+    static const uint32_t table[16] =
+    {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+    };
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++)
+    {
+        crc = table[(crc ^ pData[i]) & 0x0F] ^ (crc >> 4);
+        crc = table[(crc ^ (pData[i] >> 4)) & 0x0F] ^ (crc >> 4);
+    }
+    return ~crc;
+}
+
+uint32_t LogJournal::recordCrc(const stRecord& rec, const uint8_t* pPayload)
+{
+    uint32_t crc = crc32((const uint8_t*)&rec, offsetof(stRecord, crc));
+    return crc32(pPayload, rec.len, crc);
+}
+
+uint32_t LogJournal::headerCrc(const stHeader& hdr)
+{
+    return crc32((const uint8_t*)&hdr, offsetof(stHeader, crc));
+}
+
+// journal file has a fixed size, sectors are overwritten in place
+bool LogJournal::preallocate()
+{
+    File file = SD.open(s_filename, FILE_READ);
+    bool bOk = file && file.size() == (size_t)NUM_SECTORS * SECTOR_SIZE;
+    if (file)
+        file.close();
+    if (bOk)
+        return true;
+
+    Serial.println("Journal: preallocate");
+    file = SD.open(s_filename, FILE_WRITE);
+    if (!file)
+        return false;
+    memset(m_sectorBuf, 0, SECTOR_SIZE);
+    for (int i = 0; i < NUM_SECTORS; i++)
+        file.write(m_sectorBuf, SECTOR_SIZE);
+    file.close();
+    return true;
+}
+
+bool LogJournal::Begin(const char* logFilename, uint32_t logSize)
+{
+    if (m_bOpen)
+        m_file.close();
+    m_bOpen = false;
+
+    if (!preallocate())
+        return false;
+
+    m_file = SD.open(s_filename, "r+"); // overwrite without truncation
+    if (!m_file)
+        return false;
+
+    // next generation invalidates all old records
+    stHeader old;
+    uint32_t generation = 0;
+    if (m_file.read((uint8_t*)&old, sizeof(old)) == sizeof(old) && old.crc == headerCrc(old))
+        generation = old.generation;
+
+    memset(&m_header, 0, sizeof(m_header));
+    memcpy(m_header.magic, "LVJ1", 4);
+    m_header.generation = generation + 1;
+    m_header.logSize    = logSize;
+    m_header.bClean     = 0;
+    strncpy(m_header.logFilename, logFilename, sizeof(m_header.logFilename) - 1);
+    writeHeader();
+    m_file.flush();
+
+    m_seq    = 0;
+    m_sector = 1;
+    m_bOpen  = true;
+    return true;
+}
+
+void LogJournal::writeHeader()
+{
+    m_header.crc = headerCrc(m_header);
+    memset(m_sectorBuf, 0, SECTOR_SIZE);
+    memcpy(m_sectorBuf, &m_header, sizeof(m_header));
+    m_file.seek(0);
+    m_file.write(m_sectorBuf, SECTOR_SIZE);
+}
+
+// one record per sector, a partly used sector is not continued
+bool LogJournal::Append(const uint8_t* pData, size_t len, uint32_t logOffset)
+{
+    if (!m_bOpen)
+        return false;
+
+    m_file.seek((uint32_t)m_sector * SECTOR_SIZE);
+    while (len > 0)
+    {
+        // ring is full: caller missed to Commit(), oldest data is overwritten
+        if (m_sector >= NUM_SECTORS)
+        {
+            m_sector = 1;
+            m_file.seek(SECTOR_SIZE);
+        }
+
+        stRecord rec;
+        rec.generation = m_header.generation;
+        rec.seq        = m_seq++;
+        rec.logOffset  = logOffset;
+        rec.len        = min(len, (size_t)RECORD_PAYLOAD);
+        rec.reserved   = 0;
+        rec.crc        = recordCrc(rec, pData);
+
+        memcpy(m_sectorBuf, &rec, sizeof(rec));
+        memcpy(&m_sectorBuf[RECORD_HEADER], pData, rec.len);
+        memset(&m_sectorBuf[RECORD_HEADER + rec.len], 0, RECORD_PAYLOAD - rec.len);
+        m_file.write(m_sectorBuf, SECTOR_SIZE);
+        m_sector++;
+
+        pData     += rec.len;
+        logOffset += rec.len;
+        len       -= rec.len;
+    }
+    return true;
+}
+
+void LogJournal::Sync()
+{
+    if (m_bOpen)
+        m_file.flush();
+}
+
+void LogJournal::Commit(uint32_t logSize)
+{
+    if (!m_bOpen)
+        return;
+    m_header.logSize = logSize;
+    writeHeader();
+    m_file.flush();
+    m_sector = 1;
+}
+
+void LogJournal::End(uint32_t logSize)
+{
+    if (!m_bOpen)
+        return;
+    m_header.logSize = logSize;
+    m_header.bClean  = 1;
+    writeHeader();
+    m_file.close();
+    m_bOpen = false;
+}
+
+// append journal data, which did not make it into the log file
+bool LogJournal::Recover()
+{
+    File jnl = SD.open(s_filename, FILE_READ);
+    if (!jnl)
+        return false;
+
+    stHeader hdr;
+    uint8_t  sector[SECTOR_SIZE];
+    if (jnl.read(sector, SECTOR_SIZE) != SECTOR_SIZE)
+    {
+        jnl.close();
+        return false;
+    }
+    memcpy(&hdr, sector, sizeof(hdr));
+    if (memcmp(hdr.magic, "LVJ1", 4) != 0 || hdr.crc != headerCrc(hdr) || hdr.bClean)
+    {
+        jnl.close();
+        return false;
+    }
+    hdr.logFilename[sizeof(hdr.logFilename) - 1] = '\0';
+
+    // valid records of current generation, sorted by log offset
+    struct stEntry { uint32_t logOffset; uint32_t seq; int sector; };
+    std::vector<stEntry> entries;
+    for (int i = 1; i < NUM_SECTORS; i++)
+    {
+        if (jnl.read(sector, SECTOR_SIZE) != SECTOR_SIZE)
+            break;
+        stRecord rec;
+        memcpy(&rec, sector, sizeof(rec));
+        if (rec.generation != hdr.generation || rec.len > RECORD_PAYLOAD || rec.crc != recordCrc(rec, &sector[RECORD_HEADER]))
+            continue;
+        if (rec.logOffset + rec.len <= hdr.logSize)
+            continue;
+        stEntry e = { rec.logOffset, rec.seq, i };
+        entries.push_back(e);
+    }
+    std::sort(entries.begin(), entries.end(), [](const stEntry& a, const stEntry& b) { return a.logOffset < b.logOffset || (a.logOffset == b.logOffset && a.seq > b.seq); });
+
+    File log = SD.open(hdr.logFilename, FILE_APPEND);
+    if (!log)
+    {
+        jnl.close();
+        return false;
+    }
+
+    // FAT size may be behind the journal header or in between: continue at current end of log file
+    uint32_t logSize = log.size();
+    uint32_t recovered = 0;
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        jnl.seek((uint32_t)entries[i].sector * SECTOR_SIZE);
+        jnl.read(sector, SECTOR_SIZE);
+        stRecord rec;
+        memcpy(&rec, sector, sizeof(rec));
+        if (rec.logOffset > logSize)
+            break; // gap, data is lost
+        if (rec.logOffset + rec.len <= logSize)
+            continue;
+        uint32_t skip = logSize - rec.logOffset;
+        log.write(&sector[RECORD_HEADER + skip], rec.len - skip);
+        logSize   += rec.len - skip;
+        recovered += rec.len - skip;
+    }
+    log.close();
+    jnl.close();
+
+    // mark journal clean
+    hdr.logSize = logSize;
+    hdr.bClean  = 1;
+    hdr.crc     = headerCrc(hdr);
+    jnl = SD.open(s_filename, "r+");
+    if (jnl)
+    {
+        memset(sector, 0, SECTOR_SIZE);
+        memcpy(sector, &hdr, sizeof(hdr));
+        jnl.write(sector, SECTOR_SIZE);
+        jnl.close();
+    }
+
+    Serial.printf("Journal: %lu bytes recovered to %s\r\n", (unsigned long)recovered, hdr.logFilename);
+    return recovered > 0;
+}
@@ -0,0 +1,82 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * crash safe journal for the log file
+ *
+ * The log file itself is synced only every MAIN_SYNC_MS, a sync of a growing
+ * FAT file is expensive. All data written since the last sync is also written
+ * to /journal.jnl, a preallocated file of fixed size that never grows. Each
+ * sector carries generation, sequence, log file offset and CRC. After a
+ * power cut Recover() appends the valid sectors to the log file at boot.
+ *
+ * sector 0: header (log file name, synced log size, clean flag)
+ * sector 1..NUM_SECTORS-1: ring of data records
+ *
+ */
+
+#ifndef LOG_JOURNAL_H
+#define LOG_JOURNAL_H
+
+#include <M5Core2.h>
+
+class LogJournal
+{
+public:
+    enum
+    {
+        SECTOR_SIZE    = 512,
+        NUM_SECTORS    = 512,                         // 256 KB journal file
+        RECORD_HEADER  = 20,
+        RECORD_PAYLOAD = SECTOR_SIZE - RECORD_HEADER,
+        MAIN_SYNC_MS   = 30000,                       // max. time between log file syncs
+    };
+
+    bool Begin(const char* logFilename, uint32_t logSize); // new log file opened
+    bool Append(const uint8_t* pData, size_t len, uint32_t logOffset);
+    void Sync();                    // journal data is on card after return
+    void Commit(uint32_t logSize);  // log file is synced up to logSize, ring restarts
+    void End(uint32_t logSize);     // log file closed
+    bool NearlyFull() { return m_sector >= (NUM_SECTORS * 3) / 4; }
+
+    static bool Recover();          // call once at boot before logging
+    static uint32_t crc32(const uint8_t* pData, size_t len, uint32_t crc = 0); // also for other persistent records
+
+protected:
+    struct stHeader
+    {
+        char     magic[4];
+        uint32_t generation;
+        uint32_t logSize;  // log file is complete up to here
+        uint32_t bClean;   // log file was closed
+        char     logFilename[32];
+        uint32_t crc;
+    };
+
+    struct stRecord
+    {
+        uint32_t generation;
+        uint32_t seq;
+        uint32_t logOffset;
+        uint16_t len;
+        uint16_t reserved;
+        uint32_t crc; // header fields before crc and payload
+    };
+
+    File     m_file;
+    bool     m_bOpen = false;
+    stHeader m_header;
+    uint32_t m_seq = 0;
+    int      m_sector = 1;
+    uint8_t  m_sectorBuf[SECTOR_SIZE];
+
+    void writeHeader();
+    bool preallocate();
+
+    static const char* s_filename;
+    static uint32_t recordCrc(const stRecord& rec, const uint8_t* pPayload);
+    static uint32_t headerCrc(const stHeader& hdr);
+};
+
+#endif // LOG_JOURNAL_H
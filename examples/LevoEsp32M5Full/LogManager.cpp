@@ -0,0 +1,430 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * log file rotation, ride index and retention on SD card
+ *
+ */
+
+#include "LogManager.h"
+#include "FileLogger.h"
+#include "SysClock.h"
+
+const char* LogManager::s_indexFile = "/rides.idx";
+const char* LogManager::s_tempFile  = "/rides.tmp";
+
+bool LogManager::LineReader::Open(const char* pFilename)
+{
+    m_pos = m_len = 0;
+    m_file = SD.open(pFilename, FILE_READ);
+    return m_file ? true : false;
+}
+
+bool LogManager::LineReader::ReadLine(char* pLine, size_t size)
+{
+    size_t n = 0;
+    bool bAny = false;
+    for (;;)
+    {
+        if (m_pos >= m_len)
+        {
+            int len = m_file.read(m_buf, sizeof(m_buf));
+            m_pos = 0;
+            m_len = (len > 0) ? len : 0;
+            if (m_len == 0)
+                break;
+        }
+        char c = m_buf[m_pos++];
+        bAny = true;
+        if (c == '\n')
+            break;
+        if (c != '\r' && n < size - 1)
+            pLine[n++] = c;
+    }
+    pLine[n] = '\0';
+    return bAny;
+}
+
+// the only full scan of the FAT
+bool LogManager::Init(DisplayData* pDispData)
+{
+    m_pDispData = pDispData;
+    m_totalBytes = m_usedBytes = 0;
+
+    sdcard_type_t Type = SD.cardType();
+    if (Type == CARD_UNKNOWN || Type == CARD_NONE)
+        return false;
+
+    // card size last: HasCard() is the ready flag
+    m_usedBytes  = SD.usedBytes();
+    m_totalBytes = SD.totalBytes();
+    Serial.printf("SD card free: %lu KB, %d %% used\r\n", (unsigned long)(FreeBytes() / 1000), (int)PercentFull());
+
+    EnforceRetention();
+    return true;
+}
+
+int8_t LogManager::PercentFull(uint32_t pendingBytes)
+{
+    if (!HasCard())
+        return -1;
+    uint64_t used = m_usedBytes + pendingBytes;
+    if (used == 0)
+        used = (uint64_t)1;
+    return (int8_t)min((uint64_t)100, (used * (uint64_t)100) / m_totalBytes);
+}
+
+bool LogManager::isTextFormat(int format)
+{
+    return format == FileLogger::CSV_SIMPLE || format == FileLogger::CSV_KNOWN || format == FileLogger::CSV_KNOWNCHANGED;
+}
+
+void LogManager::nameOf(char* pFilename, const char* pLine)
+{
+    int i = 0;
+    for (; i < FILENAME_SIZE - 1 && pLine[i] && pLine[i] != '\t'; i++)
+        pFilename[i] = pLine[i];
+    pFilename[i] = '\0';
+}
+
+// /DDMMYYnn.log or /DDMMYYnn.bin
+void LogManager::GetFilename(char* pFilename, bool bBinary, int format)
+{
+    RTC_DateTypeDef RTC_Date;
+    SysClock::GetDate(&RTC_Date);
+    uint8_t year = (uint8_t)(RTC_Date.Year - 2000);
+
+    if (m_bNewFile || format != m_format || RTC_Date.Date != m_day)
+    {
+        // next free number of today, the last number is appended to when all are taken
+        char logName[FILENAME_SIZE], binName[FILENAME_SIZE];
+        int rideNo;
+        for (rideNo = 0; rideNo < MAX_RIDE_NO; rideNo++)
+        {
+            snprintf(logName, sizeof(logName), "/%02d%02d%02d%02d.log", RTC_Date.Date, RTC_Date.Month, year, rideNo);
+            snprintf(binName, sizeof(binName), "/%02d%02d%02d%02d.bin", RTC_Date.Date, RTC_Date.Month, year, rideNo);
+            if (!SD.exists(logName) && !SD.exists(binName))
+                break;
+        }
+        if (rideNo == MAX_RIDE_NO)
+            Serial.printf("LogManager: no free log number today, appending to %02d\r\n", rideNo);
+        m_rideNo   = rideNo;
+        m_bNewFile = false;
+        m_format   = format;
+        m_day      = RTC_Date.Date;
+    }
+
+    snprintf(pFilename, FILENAME_SIZE, "/%02d%02d%02d%02d.%s", RTC_Date.Date, RTC_Date.Month, year, m_rideNo, bBinary ? "bin" : "log");
+    strcpy(m_current, pFilename);
+}
+
+void LogManager::OnClosed(const char* pFilename, const RTC_DateTypeDef& date, const RTC_TimeTypeDef& time,
+                          uint32_t durationS, float km, int format, uint32_t bytes)
+{
+    m_usedBytes += bytes;
+    if (m_cmpState == CMP_DONE)
+        m_cmpState = CMP_IDLE; // new candidate for compression
+
+    File index = SD.open(s_indexFile, FILE_APPEND);
+    if (index)
+    {
+        char line[LINE_SIZE];
+        snprintf(line, sizeof(line), "%s\t%02d.%02d.%04d\t%02d:%02d:%02d\t%lu\t%.2f\t%d\r\n", pFilename,
+            date.Date, date.Month, date.Year, time.Hours, time.Minutes, time.Seconds, (unsigned long)durationS, km, format);
+        index.write((const uint8_t*)line, strlen(line));
+        index.close();
+    }
+
+    EnforceRetention();
+}
+
+// oldest indexed file first, current log file is kept
+bool LogManager::EnforceRetention()
+{
+    bool bDeleted = false;
+    while (HasCard() && PercentFull() > 100 - MIN_FREE_PERCENT)
+    {
+        LineReader index;
+        if (!index.Open(s_indexFile))
+            break;
+        char name[FILENAME_SIZE] = "";
+        while (index.ReadLine(m_line, LINE_SIZE))
+        {
+            nameOf(name, m_line);
+            if (name[0] && strcmp(name, m_current) != 0 && strcmp(name, m_cmpSrcName) != 0)
+                break;
+            name[0] = '\0';
+        }
+        index.Close();
+        if (!name[0] || !deleteLog(name))
+            break;
+        bDeleted = true;
+    }
+    return bDeleted;
+}
+
+bool LogManager::deleteLog(const char* pFilename)
+{
+    uint32_t size = 0;
+    File file = SD.open(pFilename, FILE_READ);
+    if (file)
+    {
+        size = file.size();
+        file.close();
+        if (!SD.remove(pFilename))
+            return false;
+    }
+    m_usedBytes -= min((uint64_t)size, m_usedBytes);
+    Serial.printf("LogManager: %s deleted, %lu KB\r\n", pFilename, (unsigned long)(size / 1000));
+
+    // missing files are removed from index, too
+    return rewriteIndex(pFilename, NULL, 0);
+}
+
+// index is small, a rewrite is cheap
+bool LogManager::rewriteIndex(const char* pFilename, const char* pNewFilename, int newFormat)
+{
+    LineReader index;
+    if (!index.Open(s_indexFile))
+        return false;
+    File temp = SD.open(s_tempFile, FILE_WRITE);
+    if (!temp)
+    {
+        index.Close();
+        return false;
+    }
+
+    char name[FILENAME_SIZE];
+    while (index.ReadLine(m_line, LINE_SIZE))
+    {
+        nameOf(name, m_line);
+        if (strcmp(name, pFilename) == 0)
+        {
+            if (pNewFilename == NULL)
+                continue;
+            // new name and format, other columns are kept
+            const char* pFirst = strchr(m_line, '\t');
+            const char* pLast  = strrchr(m_line, '\t');
+            if (pFirst == NULL)
+                continue;
+            temp.write((const uint8_t*)pNewFilename, strlen(pNewFilename));
+            temp.write((const uint8_t*)pFirst, pLast - pFirst + 1);
+            temp.printf("%d\r\n", newFormat);
+        }
+        else if (m_line[0])
+        {
+            temp.write((const uint8_t*)m_line, strlen(m_line));
+            temp.write((const uint8_t*)"\r\n", 2);
+        }
+    }
+    index.Close();
+    temp.close();
+
+    SD.remove(s_indexFile);
+    return SD.rename(s_tempFile, s_indexFile);
+}
+
+// oldest text log followed by at least KEEP_UNCOMPRESSED newer files
+bool LogManager::findCompressCandidate(char* pFilename)
+{
+    LineReader index;
+    if (!index.Open(s_indexFile))
+        return false;
+
+    // count files, sessions of one file are consecutive lines
+    char name[FILENAME_SIZE], last[FILENAME_SIZE] = "";
+    int nFiles = 0;
+    while (index.ReadLine(m_line, LINE_SIZE))
+    {
+        nameOf(name, m_line);
+        if (name[0] && strcmp(name, last) != 0)
+        {
+            nFiles++;
+            strcpy(last, name);
+        }
+    }
+    index.Close();
+
+    if (!index.Open(s_indexFile))
+        return false;
+    last[0] = '\0';
+    int iFile = 0;
+    bool bFound = false;
+    while (!bFound && index.ReadLine(m_line, LINE_SIZE))
+    {
+        nameOf(name, m_line);
+        if (!name[0] || strcmp(name, last) == 0)
+            continue;
+        strcpy(last, name);
+        if (nFiles - ++iFile < KEEP_UNCOMPRESSED)
+            break;
+        const char* pFormat = strrchr(m_line, '\t');
+        bFound = pFormat && isTextFormat(atoi(pFormat + 1)) && strcmp(name, m_current) != 0;
+    }
+    index.Close();
+
+    if (bFound)
+        strcpy(pFilename, name);
+    return bFound;
+}
+
+bool LogManager::writeDst(void* pCtx, const void* pData, size_t len)
+{
+    LogManager* pThis = (LogManager*)pCtx;
+    if (pThis->m_cmpDst.write((const uint8_t*)pData, len) != len)
+        pThis->m_cmpError = true; // card full
+    return !pThis->m_cmpError;
+}
+
+bool LogManager::beginCompress()
+{
+    if (m_pDispData == NULL || !findCompressCandidate(m_cmpSrcName))
+        return false;
+
+    if (!m_cmpSrc.Open(m_cmpSrcName))
+    {
+        rewriteIndex(m_cmpSrcName, NULL, 0); // deleted by user
+        m_cmpSrcName[0] = '\0';
+        return true;
+    }
+
+    // a left over from an interrupted run is overwritten
+    strcpy(m_cmpDstName, m_cmpSrcName);
+    strcpy(strrchr(m_cmpDstName, '.'), ".bin");
+    SD.remove(m_cmpDstName);
+    m_cmpDst = SD.open(m_cmpDstName, FILE_WRITE);
+    if (!m_cmpDst)
+    {
+        m_cmpSrc.Close();
+        m_cmpSrcName[0] = '\0';
+        return false;
+    }
+
+    Serial.printf("LogManager: compressing %s\r\n", m_cmpSrcName);
+    m_encoder.SetOutput(writeDst, this);
+    m_cmpHeader = false;
+    m_cmpError  = false;
+    m_cmpState  = CMP_RUNNING;
+    return true;
+}
+
+// one line of CSV_SIMPLE, CSV_KNOWN or CSV_KNOWNCHANGED
+bool LogManager::compressLine(const char* pLine)
+{
+    // session start: date, time
+    RTC_DateTypeDef date;
+    RTC_TimeTypeDef time;
+    int d, mo, y, h, mi, s;
+    if (sscanf(pLine, "%d.%d.%d, %d:%d:%d", &d, &mo, &y, &h, &mi, &s) == 6)
+    {
+        date.Date = d; date.Month = mo; date.Year = y; date.WeekDay = 0;
+        time.Hours = h; time.Minutes = mi; time.Seconds = s;
+        m_encoder.WriteHeader(*m_pDispData, date, time);
+        m_cmpHeader = true;
+        return true;
+    }
+
+    // time  km  id  label  value  unit
+    char* p;
+    double seconds = strtod(pLine, &p);
+    if (p == pLine)
+        return true; // head lines
+    strtod(p, &p);
+    long id = strtol(p, &p, 10);
+
+    if (!m_cmpHeader)
+    {
+        memset(&date, 0, sizeof(date));
+        memset(&time, 0, sizeof(time));
+        m_encoder.WriteHeader(*m_pDispData, date, time);
+        m_cmpHeader = true;
+    }
+
+    uint32_t timestamp = (uint32_t)(seconds * 1000.0 + 0.5);
+    if (id < 0)
+    {
+        // hex dump
+        uint8_t raw[20];
+        size_t len = 0;
+        while (len < sizeof(raw))
+        {
+            char* pEnd;
+            unsigned long val = strtoul(p, &pEnd, 16);
+            if (pEnd == p)
+                break;
+            raw[len++] = (uint8_t)val;
+            p = pEnd;
+        }
+        m_encoder.AddRaw(raw, len, timestamp);
+        return !m_cmpError;
+    }
+
+    const DisplayData::stDisplayData* pDesc = m_pDispData->GetDescription((DisplayData::enIds)id);
+    p = strchr(p + 1, '\t'); // skip label
+    if (pDesc == NULL || p == NULL)
+        return true;
+    float fVal = strtod(p, NULL);
+    m_encoder.AddValue((uint8_t)id, fVal, pDesc->nLogPrecision, timestamp);
+    return !m_cmpError;
+}
+
+void LogManager::endCompress(bool bOk)
+{
+    m_encoder.FlushBlock();
+    uint32_t srcSize = m_cmpSrc.Size();
+    uint32_t dstSize = m_cmpDst.size();
+    m_cmpSrc.Close();
+    m_cmpDst.close();
+
+    if (bOk)
+    {
+        SD.remove(m_cmpSrcName);
+        rewriteIndex(m_cmpSrcName, m_cmpDstName, FileLogger::BIN_DELTA);
+        m_usedBytes += dstSize;
+        m_usedBytes -= min((uint64_t)srcSize, m_usedBytes);
+        Serial.printf("LogManager: %s -> %s, %lu KB -> %lu KB\r\n", m_cmpSrcName, m_cmpDstName, (unsigned long)(srcSize / 1000), (unsigned long)(dstSize / 1000));
+    }
+    else
+        SD.remove(m_cmpDstName);
+
+    m_cmpSrcName[0] = '\0';
+    m_cmpState = bOk ? CMP_IDLE : CMP_DONE;
+}
+
+// a few ms per call
+void LogManager::Poll()
+{
+    if (!HasCard())
+        return;
+
+    switch (m_cmpState)
+    {
+    case CMP_IDLE:
+        if (!beginCompress())
+            m_cmpState = CMP_DONE;
+        break;
+
+    case CMP_RUNNING:
+    {
+        uint32_t tiStart = millis();
+        while (millis() - tiStart < 10)
+        {
+            if (!m_cmpSrc.ReadLine(m_line, LINE_SIZE))
+            {
+                endCompress(true);
+                break;
+            }
+            if (!compressLine(m_line))
+            {
+                endCompress(false);
+                break;
+            }
+        }
+        break;
+    }
+
+    case CMP_DONE:
+        break;
+    }
+}
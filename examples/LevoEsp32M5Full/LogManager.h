@@ -0,0 +1,117 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * log file rotation, ride index and retention on SD card
+ *
+ * Log files are named /DDMMYYnn.log or /DDMMYYnn.bin, a new number is used
+ * for each ride (boot or finished tour), when a file exceeds MAX_LOG_SIZE
+ * or when the log format changes. Every closed log session adds one line
+ * to /rides.idx:
+ *
+ *   file  date  time  duration(s)  distance(km)  format
+ *
+ * Retention: when free space drops below MIN_FREE_PERCENT, the oldest
+ * indexed files are deleted. Text logs older than the newest
+ * KEEP_UNCOMPRESSED files are transcoded to BIN_DELTA in the background
+ * while no log file is open. Files which are not in the index are never
+ * touched.
+ *
+ * Card usage is measured once in Init(), later on only updated with the
+ * number of bytes written and deleted. SD.usedBytes() walks the whole FAT.
+ *
+ */
+
+#ifndef LOG_MANAGER_H
+#define LOG_MANAGER_H
+
+#include <M5Core2.h>
+#include "DisplayData.h"
+#include "BinLogEncoder.h"
+
+class LogManager
+{
+public:
+    enum
+    {
+        MAX_LOG_SIZE      = 16 * 1024 * 1024, // rotate larger files
+        MIN_FREE_PERCENT  = 10,
+        KEEP_UNCOMPRESSED = 3,                // newest text logs are kept as they are
+        FILENAME_SIZE     = 20,
+        MAX_RIDE_NO       = 99,
+    };
+
+    bool   Init(DisplayData* pDispData);       // call once at boot, measures card usage
+    bool   HasCard() { return m_totalBytes > 0; }
+
+    // filename for the next log file
+    void   GetFilename(char* pFilename, bool bBinary, int format);
+    void   NewFile() { m_bNewFile = true; }    // next log file gets a new number
+
+    // log session closed, bytes written since open
+    void   OnClosed(const char* pFilename, const RTC_DateTypeDef& date, const RTC_TimeTypeDef& time,
+                    uint32_t durationS, float km, int format, uint32_t bytes);
+
+    int8_t PercentFull(uint32_t pendingBytes = 0); // from cache, -1: no card
+    uint64_t FreeBytes()  { return (m_usedBytes < m_totalBytes) ? m_totalBytes - m_usedBytes : 0; }
+
+    bool   EnforceRetention();                 // delete oldest files until enough free space
+    void   Poll();                             // background compression, call while no log file is open
+
+protected:
+    // buffered line reading from SD
+    class LineReader
+    {
+    public:
+        bool  Open(const char* pFilename);
+        void  Close()        { if (m_file) m_file.close(); }
+        bool  ReadLine(char* pLine, size_t size);       // false at end of file
+        uint32_t Size()      { return m_file ? m_file.size() : 0; }
+    protected:
+        File    m_file;
+        uint8_t m_buf[512];
+        size_t  m_pos = 0;
+        size_t  m_len = 0;
+    };
+
+    enum { LINE_SIZE = 160 };
+
+    DisplayData* m_pDispData = NULL;
+    uint64_t m_totalBytes = 0;
+    uint64_t m_usedBytes  = 0;
+
+    bool     m_bNewFile  = true;
+    int      m_rideNo    = 0;
+    int      m_format    = -1;
+    uint8_t  m_day       = 0;
+    char     m_current[FILENAME_SIZE] = ""; // open or last log file
+
+    // transcoding of one text log to binary
+    enum enCompress { CMP_IDLE = 0, CMP_RUNNING, CMP_DONE };
+    enCompress    m_cmpState = CMP_IDLE;
+    bool          m_cmpHeader = false;
+    bool          m_cmpError  = false;
+    LineReader    m_cmpSrc;
+    File          m_cmpDst;
+    char          m_cmpSrcName[FILENAME_SIZE] = "";
+    char          m_cmpDstName[FILENAME_SIZE];
+    BinLogEncoder m_encoder;
+    char          m_line[LINE_SIZE];
+
+    static const char* s_indexFile;
+    static const char* s_tempFile;
+
+    bool  findCompressCandidate(char* pFilename);
+    bool  beginCompress();
+    bool  compressLine(const char* pLine);
+    void  endCompress(bool bOk);
+    bool  rewriteIndex(const char* pFilename, const char* pNewFilename, int newFormat); // NULL: remove entries
+    bool  deleteLog(const char* pFilename);
+
+    static bool writeDst(void* pCtx, const void* pData, size_t len);
+    static bool isTextFormat(int format);
+    static void nameOf(char* pFilename, const char* pLine); // first column of an index line
+};
+
+#endif // LOG_MANAGER_H
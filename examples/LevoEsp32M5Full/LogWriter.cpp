@@ -0,0 +1,205 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * buffered asynchronous writer for log files
+ *
+ */
+
+#include <algorithm>
+#include "LogWriter.h"
+
+bool LogWriter::Open(const char* filename)
+{
+    // writer task runs on core 0, main loop on core 1
+    if (m_hTask == NULL)
+    {
+        m_hQueue   = xQueueCreate(2, sizeof(stJob));
+        m_hFreeSem = xSemaphoreCreateCounting(1, 1);
+        xTaskCreatePinnedToCore(writerTask, "LogWriter", 4096, this, 1, &m_hTask, 0);
+    }
+
+    m_file = SD.open(filename, FILE_APPEND);
+    if (!m_file)
+        return false;
+
+    m_active  = 0;
+    m_fill    = 0;
+    m_filePos = m_file.size();
+    alignLimit();
+
+    // without journal each commit syncs the log file
+    m_bJournal   = m_journal.Begin(filename, m_filePos);
+    m_tiMainSync = millis();
+    m_nMainSyncs = 0;
+    if (!m_bJournal)
+        Serial.println("LogWriter: no journal");
+
+    m_nWrites = m_bytesWritten = m_bytesDropped = m_maxBlockMain = 0;
+    m_nLatency = 0;
+
+    m_bOpen = true;
+    return true;
+}
+
+void LogWriter::Close()
+{
+    if (!m_bOpen)
+        return;
+
+    // hand over rest of data and wait for the task to finish
+    submit(true, portMAX_DELAY);
+    xSemaphoreTake(m_hFreeSem, portMAX_DELAY);
+    m_file.close();
+    if (m_bJournal)
+        m_journal.End(m_filePos);
+    xSemaphoreGive(m_hFreeSem);
+
+    m_bOpen = false;
+}
+
+// first buffer after open or partial commit ends on a sector boundary of the file
+void LogWriter::alignLimit()
+{
+    m_limit = BUFFER_SIZE - (m_filePos % SECTOR_SIZE);
+}
+
+bool LogWriter::Write(const char* pData, size_t len)
+{
+    if (!m_bOpen)
+        return false;
+
+    bool bRet = true;
+    while (len > 0)
+    {
+        if (m_fill == 0)
+            m_tiFirst = millis();
+
+        size_t n = min(len, m_limit - m_fill);
+        memcpy(&m_buffer[m_active][m_fill], pData, n);
+        m_fill += n;
+        pData  += n;
+        len    -= n;
+
+        // writer still busy: buffer content is dropped in submit()
+        if (m_fill >= m_limit && !submit(false, m_maxBlockMs))
+            bRet = false;
+    }
+    return bRet;
+}
+
+// pass current buffer to the writer task, wait max. maxWaitMs for the other buffer
+bool LogWriter::submit(bool bFlush, uint32_t maxWaitMs)
+{
+    if (m_fill == 0 && !bFlush)
+        return true;
+
+    uint32_t tiStart = millis();
+    if (xSemaphoreTake(m_hFreeSem, (maxWaitMs == portMAX_DELAY) ? portMAX_DELAY : pdMS_TO_TICKS(maxWaitMs)) != pdTRUE)
+    {
+        // buffer is full and can't be handed over: discard its content
+        if (m_fill >= m_limit)
+        {
+            m_bytesDropped += m_fill;
+            m_fill = 0;
+        }
+        m_maxBlockMain = max(m_maxBlockMain, millis() - tiStart);
+        return false;
+    }
+    m_maxBlockMain = max(m_maxBlockMain, millis() - tiStart);
+
+    stJob job = { m_active, m_fill, m_filePos, bFlush };
+    xQueueSend(m_hQueue, &job, portMAX_DELAY); // never waits, max. one job in queue
+
+    m_filePos += m_fill;
+    m_active   = 1 - m_active;
+    m_fill     = 0;
+    alignLimit();
+    return true;
+}
+
+void LogWriter::Flush()
+{
+    if (m_bOpen)
+        submit(true, m_maxBlockMs);
+}
+
+void LogWriter::Poll(uint32_t timestamp)
+{
+    // group commit: all lines of the last interval go to SD with one write
+    if (m_bOpen && m_fill > 0 && timestamp - m_tiFirst >= m_flushIntervalMs)
+        submit(true, 0);
+}
+
+void LogWriter::writerTask(void* pParam)
+{
+    LogWriter* pThis = (LogWriter*)pParam;
+    stJob job;
+    while (1)
+    {
+        if (xQueueReceive(pThis->m_hQueue, &job, portMAX_DELAY) == pdTRUE)
+        {
+            pThis->writeJob(job);
+            xSemaphoreGive(pThis->m_hFreeSem);
+        }
+    }
+}
+
+void LogWriter::writeJob(const stJob& job)
+{
+    uint32_t tiStart = millis();
+    if (job.len > 0)
+    {
+        m_file.write((const uint8_t*)m_buffer[job.buffer], job.len);
+        if (m_bJournal)
+            m_journal.Append((const uint8_t*)m_buffer[job.buffer], job.len, job.offset);
+    }
+
+    // sync log file seldom or when journal runs full, else only journal
+    bool bMainSync = !m_bJournal || m_journal.NearlyFull() || (job.bFlush && tiStart - m_tiMainSync >= LogJournal::MAIN_SYNC_MS);
+    if (bMainSync)
+    {
+        m_file.flush();
+        m_tiMainSync = tiStart;
+        m_nMainSyncs++;
+        if (m_bJournal)
+            m_journal.Commit(job.offset + job.len);
+    }
+    else if (job.bFlush)
+        m_journal.Sync();
+
+    m_latency[m_nLatency % NUM_LATENCY] = millis() - tiStart;
+    m_nLatency++;
+    m_nWrites++;
+    m_bytesWritten += job.len;
+}
+
+void LogWriter::GetStats(stStats& stats)
+{
+    // sort a copy of the recent latencies
+    uint32_t sorted[NUM_LATENCY];
+    int n = min((uint32_t)m_nLatency, (uint32_t)NUM_LATENCY);
+    memcpy(sorted, m_latency, n * sizeof(uint32_t));
+    std::sort(sorted, sorted + n);
+
+    stats.nWrites      = m_nWrites;
+    stats.bytesWritten = m_bytesWritten;
+    stats.bytesDropped = m_bytesDropped;
+    stats.writeP50     = n ? sorted[(n * 50) / 100] : 0;
+    stats.writeP95     = n ? sorted[(n * 95) / 100] : 0;
+    stats.writeP99     = n ? sorted[(n * 99) / 100] : 0;
+    stats.writeMax     = n ? sorted[n - 1] : 0;
+    stats.maxBlockMain = m_maxBlockMain;
+    stats.nMainSyncs   = m_nMainSyncs;
+}
+
+void LogWriter::PrintStats()
+{
+    stStats stats;
+    GetStats(stats);
+    Serial.printf("LogWriter: %lu writes, %lu bytes, %lu dropped, latency p50 %lu p95 %lu p99 %lu max %lu ms, main blocked max %lu ms, %lu log syncs\r\n",
+        (unsigned long)stats.nWrites, (unsigned long)stats.bytesWritten, (unsigned long)stats.bytesDropped,
+        (unsigned long)stats.writeP50, (unsigned long)stats.writeP95, (unsigned long)stats.writeP99, (unsigned long)stats.writeMax,
+        (unsigned long)stats.maxBlockMain, (unsigned long)stats.nMainSyncs);
+}
@@ -0,0 +1,106 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * buffered asynchronous writer for log files
+ *
+ * Lines are collected in one of two RAM buffers, full buffers are written
+ * to SD by a background task. The main loop is never blocked longer than
+ * m_maxBlockMs, data that does not fit in time is dropped and counted.
+ *
+ * Group commits go to the journal, the log file is synced less often.
+ * On a power cut at most m_flushIntervalMs of data is lost.
+ *
+ */
+
+#ifndef LOG_WRITER_H
+#define LOG_WRITER_H
+
+#include <M5Core2.h>
+#include "LogJournal.h"
+
+class LogWriter
+{
+public:
+    enum
+    {
+        BUFFER_SIZE  = 8192, // per buffer, multiple of sector size
+        SECTOR_SIZE  = 512,
+        NUM_LATENCY  = 64,   // write latencies kept for percentiles
+    };
+
+    struct stStats
+    {
+        uint32_t nWrites;        // buffers written to SD
+        uint32_t bytesWritten;
+        uint32_t bytesDropped;   // lost because writer was busy for longer than max. block time
+        uint32_t writeP50;       // SD write latency percentiles (ms)
+        uint32_t writeP95;
+        uint32_t writeP99;
+        uint32_t writeMax;
+        uint32_t maxBlockMain;   // longest time main loop waited for a free buffer (ms)
+        uint32_t nMainSyncs;     // log file syncs, all other commits went to the journal
+    };
+
+    bool   Open(const char* filename);
+    void   Close();
+    bool   IsOpen() { return m_bOpen; }
+
+    bool   Write(const char* pData, size_t len); // copy data to buffer, never blocks longer than max. block time
+    void   Flush();                              // commit current buffer now
+    void   Poll(uint32_t timestamp);             // commit buffer when older than flush interval, call from loop
+
+    void   SetMaxBlockTime(uint32_t ms)      { m_maxBlockMs = ms; }
+    void   SetFlushInterval(uint32_t ms)     { m_flushIntervalMs = ms; }
+    void   GetStats(stStats& stats);
+    void   PrintStats();
+
+protected:
+    File     m_file;
+    bool     m_bOpen = false;
+
+    // double buffer, m_active is filled by main loop, the other one may be written by the task
+    char     m_buffer[2][BUFFER_SIZE];
+    int      m_active  = 0;
+    size_t   m_fill    = 0;
+    size_t   m_limit   = BUFFER_SIZE; // fill limit to keep SD writes sector aligned
+    uint32_t m_filePos = 0;           // file position after all submitted buffers
+    uint32_t m_tiFirst = 0;           // time of first byte in current buffer
+
+    uint32_t m_maxBlockMs      = 5;
+    uint32_t m_flushIntervalMs = 2000;
+
+    struct stJob
+    {
+        int      buffer;
+        size_t   len;
+        uint32_t offset; // log file position
+        bool     bFlush; // data must be on card after write
+    };
+
+    // used by writer task after Open()
+    LogJournal m_journal;
+    bool       m_bJournal   = false;
+    uint32_t   m_tiMainSync = 0;
+    uint32_t   m_nMainSyncs = 0;
+
+    TaskHandle_t      m_hTask     = NULL;
+    QueueHandle_t     m_hQueue    = NULL;
+    SemaphoreHandle_t m_hFreeSem  = NULL; // given when the task has finished a buffer
+
+    static void writerTask(void* pParam);
+    void   writeJob(const stJob& job);
+    bool   submit(bool bFlush, uint32_t maxWaitMs);
+    void   alignLimit();
+
+    // statistics
+    volatile uint32_t m_nWrites      = 0;
+    volatile uint32_t m_bytesWritten = 0;
+    uint32_t          m_bytesDropped = 0;
+    uint32_t          m_maxBlockMain = 0;
+    uint32_t          m_latency[NUM_LATENCY] = { 0 };
+    volatile uint32_t m_nLatency     = 0;
+};
+
+#endif // LOG_WRITER_H
@@ -0,0 +1,162 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * battery telemetry of the M5Core2 unit from AXP192
+ *
+ */
+
+#include "M5Battery.h"
+#include "SysClock.h"
+
+#define AXP192_ADDR          0x34
+#define AXP192_REG_COULOMBCTL 0xB8
+
+// bulk read range
+#define AXP192_REG_FIRST     0x56
+#define AXP192_REG_LAST      0xB7
+#define AXP192_REG_ACINV     0x56 // 12 bit, 1.7 mV
+#define AXP192_REG_VBUSV     0x5A // 12 bit, 1.7 mV
+#define AXP192_REG_BATV      0x78 // 12 bit, 1.1 mV
+#define AXP192_REG_BATCHGI   0x7A // 13 bit, 0.5 mA
+#define AXP192_REG_BATDISI   0x7C // 13 bit, 0.5 mA
+#define AXP192_REG_COULOMBC  0xB0 // 32 bit charge counter
+#define AXP192_REG_COULOMBD  0xB4 // 32 bit discharge counter
+
+// 65536 * 0.5 mA / 3600 s / 25 Hz ADC rate
+#define COULOMB_MAH   0.36409f
+
+#define ALPHA_VOLTAGE ((float)SAMPLE_MS / 30000.0f) // 30 s
+#define ALPHA_CURRENT ((float)SAMPLE_MS / 60000.0f) // 60 s
+#define R_INTERNAL    0.15f                         // Ohm, voltage drop under load
+
+bool M5Battery::readRegs(uint8_t reg, uint8_t* pData, size_t len)
+{
+    uint32_t us = micros();
+    m_pWire->beginTransmission(AXP192_ADDR);
+    m_pWire->write(reg);
+    bool bOk = m_pWire->endTransmission() == 0 && m_pWire->requestFrom((uint8_t)AXP192_ADDR, (uint8_t)len) == len;
+    for (size_t i = 0; bOk && i < len; i++)
+        pData[i] = m_pWire->read();
+    m_busUs = micros() - us;
+    return bOk;
+}
+
+bool M5Battery::Init()
+{
+    m_pWire->beginTransmission(AXP192_ADDR);
+    m_pWire->write(AXP192_REG_COULOMBCTL);
+    m_pWire->write(0x80); // enable, keep count
+    return m_pWire->endTransmission() == 0;
+}
+
+bool M5Battery::Update(DisplayData::enIds& id, float& fVal, uint32_t timestamp)
+{
+    if (!SysClock::IsDue(timestamp, m_tiSample))
+        return false;
+    m_tiSample = timestamp + SAMPLE_MS;
+
+    bool bFirst = !m_bValid;
+    bool bWasExternal = m_bExternal;
+    if (!sample(timestamp))
+        return false;
+
+    // run time on battery, 0 once on external power
+    if (m_bExternal && bWasExternal && !bFirst)
+        return false;
+    id   = DisplayData::SYS_RUNTIME;
+    fVal = round(m_runtime);
+    return true;
+}
+
+bool M5Battery::sample(uint32_t timestamp)
+{
+    uint8_t buf[AXP192_REG_LAST - AXP192_REG_FIRST + 1];
+    if (!readRegs(AXP192_REG_FIRST, buf, sizeof(buf)))
+        return false;
+
+    #define REG(r)    buf[(r) - AXP192_REG_FIRST]
+    #define ADC12(r)  ((REG(r) << 4) | (REG((r) + 1) & 0x0F))
+    #define ADC13(r)  ((REG(r) << 5) | (REG((r) + 1) & 0x1F))
+    #define CNT32(r)  (((uint32_t)REG(r) << 24) | ((uint32_t)REG((r) + 1) << 16) | ((uint32_t)REG((r) + 2) << 8) | REG((r) + 3))
+
+    float acin    = ADC12(AXP192_REG_ACINV) * 0.0017f;
+    float vbus    = ADC12(AXP192_REG_VBUSV) * 0.0017f;
+    float voltage = ADC12(AXP192_REG_BATV) * 0.0011f;
+    float current = (ADC13(AXP192_REG_BATDISI) - ADC13(AXP192_REG_BATCHGI)) * 0.5f;
+    float mAh     = (int32_t)(CNT32(AXP192_REG_COULOMBC) - CNT32(AXP192_REG_COULOMBD)) * COULOMB_MAH;
+
+    m_bExternal = acin > 4.0f || vbus > 4.0f;
+    if (!m_bValid)
+    {
+        m_voltage = voltage;
+        m_current = current;
+        m_bValid  = true;
+    }
+    else
+    {
+        m_voltage += ALPHA_VOLTAGE * (voltage - m_voltage);
+        m_current += ALPHA_CURRENT * (current - m_current);
+    }
+    m_percent = chargePercent(m_voltage + max(m_current, 0.0f) / 1000.0f * R_INTERNAL);
+    updateTrend(mAh, timestamp);
+
+    // trend when available, filtered current before
+    float drain = (m_trendMa > 0.0f) ? m_trendMa : m_current;
+    if (m_bExternal || drain < 1.0f)
+        m_runtime = 0.0;
+    else
+        m_runtime = CAPACITY_MAH * m_percent / 100.0f / drain * 60.0f;
+    return true;
+}
+
+// mean discharge current over a window, smoothed with the previous windows
+void M5Battery::updateTrend(float mAh, uint32_t timestamp)
+{
+    if (m_bExternal)
+    {
+        m_tiTrend = 0;
+        m_trendMa = 0.0;
+        return;
+    }
+    if (m_tiTrend == 0)
+    {
+        m_tiTrend  = timestamp;
+        m_mAhTrend = mAh;
+        return;
+    }
+    if (timestamp - m_tiTrend < TREND_MS)
+        return;
+
+    float mA = (m_mAhTrend - mAh) * 3600000.0f / (timestamp - m_tiTrend);
+    m_trendMa  = (m_trendMa == 0.0f) ? mA : (m_trendMa + mA) / 2.0f;
+    m_tiTrend  = timestamp;
+    m_mAhTrend = mAh;
+}
+
+// LiPo open circuit voltage to charge state
+int M5Battery::chargePercent(float volt)
+{
+    static const float curve[][2] =
+    {
+        { 3.30f,   0.0f }, { 3.50f,   5.0f }, { 3.60f,  10.0f }, { 3.70f,  25.0f },
+        { 3.75f,  40.0f }, { 3.80f,  55.0f }, { 3.85f,  65.0f }, { 3.90f,  75.0f },
+        { 4.00f,  85.0f }, { 4.10f,  95.0f }, { 4.15f, 100.0f },
+    };
+    const int n = sizeof(curve) / sizeof(curve[0]);
+    if (volt <= curve[0][0])
+        return 0;
+    for (int i = 1; i < n; i++)
+    {
+        if (volt < curve[i][0])
+            return (int)(curve[i - 1][1] + (volt - curve[i - 1][0]) * (curve[i][1] - curve[i - 1][1]) / (curve[i][0] - curve[i - 1][0]));
+    }
+    return 100;
+}
+
+void M5Battery::PrintStats()
+{
+    Serial.printf("M5 battery: %.2f V, %.0f mA, trend %.0f mA, %d%%, %.0f min, %s, I2C %u us\r\n",
+        m_voltage, m_current, m_trendMa, m_percent, m_runtime, m_bExternal ? "external" : "battery", m_busUs);
+}
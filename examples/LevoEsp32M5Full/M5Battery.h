@@ -0,0 +1,69 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * battery telemetry of the M5Core2 unit from AXP192
+ *
+ * Every SAMPLE_MS one I2C transaction reads ACIN/VBUS voltage, battery
+ * voltage, charge/discharge current and the coulomb counters (registers
+ * 0x56..0xB7). Voltage and current are low pass filtered. Charge state comes
+ * from the load compensated voltage, the discharge trend from the coulomb
+ * counter over TREND_MS windows. Remaining run time is published as
+ * SYS_RUNTIME.
+ *
+ */
+
+#ifndef M5BATTERY_H
+#define M5BATTERY_H
+
+#include <Wire.h>
+#include "DisplayData.h"
+
+class M5Battery
+{
+public:
+    enum
+    {
+        SAMPLE_MS    = 2000,
+        TREND_MS     = 300000, // coulomb counter window, 0.36 mAh per count
+        CAPACITY_MAH = 390,    // M5Core2 internal battery
+    };
+
+    M5Battery( TwoWire* tw = &Wire1 ) : m_pWire(tw) {}
+
+    bool  Init(); // enables coulomb counter
+    bool  Update(DisplayData::enIds& id, float& fVal, uint32_t timestamp); // SYS_RUNTIME when due
+
+    bool  IsExternalPower() { return m_bExternal; }
+    float GetVoltage()      { return m_voltage; }  // filtered, V
+    float GetCurrent()      { return m_current; }  // filtered discharge current, mA
+    int   GetPercent()      { return m_percent; }
+    float GetRuntime()      { return m_runtime; }  // minutes, 0 on external power
+    void  PrintStats();
+
+protected:
+    TwoWire* m_pWire;
+    bool     m_bValid = false;  // first sample done
+    uint32_t m_tiSample = 0;
+    uint32_t m_busUs = 0;       // last bulk read
+
+    // filtered values
+    bool     m_bExternal = false;
+    float    m_voltage = 0.0;
+    float    m_current = 0.0;
+    int      m_percent = 0;
+    float    m_runtime = 0.0;
+
+    // discharge trend
+    float    m_trendMa = 0.0;     // 0: no window yet
+    float    m_mAhTrend = 0.0;    // coulomb counter at window start
+    uint32_t m_tiTrend = 0;
+
+    bool  readRegs(uint8_t reg, uint8_t* pData, size_t len);
+    bool  sample(uint32_t timestamp);
+    void  updateTrend(float mAh, uint32_t timestamp);
+    static int chargePercent(float volt);
+};
+
+#endif // M5BATTERY_H
@@ -0,0 +1,82 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * Pool of touch buttons for forms, message boxes and the keyboard
+ *
+ */
+
+#include "M5ButtonPool.h"
+
+Button*  M5ButtonPool::s_pButtons[POOL_SIZE] = { NULL };
+uint32_t M5ButtonPool::s_usedMask = 0;
+
+static const ButtonColors noDraw = { NODRAW, NODRAW, NODRAW };
+
+void M5ButtonPool::reset(Button* pButton)
+{
+    pButton->delHandlers();
+    pButton->hide();
+    pButton->set(0, 0, 0, 0);
+    pButton->setLabel("");
+    pButton->off = noDraw;
+    pButton->on  = noDraw;
+    pButton->userData = 0;
+}
+
+Button* M5ButtonPool::Get(int16_t x, int16_t y, int16_t w, int16_t h, const char* label, ButtonColors off, ButtonColors on,
+                          uint8_t datum, int16_t dx, int16_t dy, uint8_t r)
+{
+    for (int i = 0; i < POOL_SIZE; i++)
+    {
+        if (s_usedMask & (1UL << i))
+            continue;
+
+        // created on first use, never deleted
+        if (s_pButtons[i] == NULL)
+        {
+            s_pButtons[i] = new Button(0, 0, 0, 0, false, "", noDraw, noDraw);
+            reset(s_pButtons[i]);
+        }
+        Button* pButton = s_pButtons[i];
+        pButton->set(x, y, w, h);
+        pButton->setLabel(label);
+        pButton->off   = off;
+        pButton->on    = on;
+        pButton->datum = datum;
+        pButton->dx    = dx;
+        pButton->dy    = dy;
+        pButton->r     = r;
+        pButton->setFreeFont(BUTTON_FREEFONT);
+        pButton->setTextSize(BUTTON_TEXTSIZE);
+        s_usedMask |= (1UL << i);
+        return pButton;
+    }
+    Serial.println("M5ButtonPool: no free button");
+    return NULL;
+}
+
+void M5ButtonPool::Release(Button*& pButton)
+{
+    if (pButton == NULL)
+        return;
+    for (int i = 0; i < POOL_SIZE; i++)
+    {
+        if (s_pButtons[i] == pButton)
+        {
+            reset(pButton);
+            s_usedMask &= ~(1UL << i);
+            break;
+        }
+    }
+    pButton = NULL;
+}
+
+int M5ButtonPool::GetNumUsed()
+{
+    int n = 0;
+    for (uint32_t mask = s_usedMask; mask; mask &= mask - 1)
+        n++;
+    return n;
+}
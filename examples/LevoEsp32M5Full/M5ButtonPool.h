@@ -0,0 +1,35 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * Pool of touch buttons for forms, message boxes and the keyboard
+ *
+ * Buttons are created once and reused. A free button has zero size, no
+ * label and no colors, so it neither draws nor receives touches.
+ *
+ */
+
+#ifndef M5BUTTON_POOL_H
+#define M5BUTTON_POOL_H
+
+#include <M5Core2.h>
+
+class M5ButtonPool
+{
+public:
+    enum { POOL_SIZE = 28 }; // largest user: keyboard 4 x 7 keys
+
+    static Button* Get(int16_t x, int16_t y, int16_t w, int16_t h, const char* label, ButtonColors off, ButtonColors on,
+                       uint8_t datum = TC_DATUM, int16_t dx = 0, int16_t dy = 0, uint8_t r = 0xFF);
+    static void    Release(Button*& pButton); // sets pointer to NULL
+    static int     GetNumUsed();
+
+protected:
+    static Button*  s_pButtons[POOL_SIZE];
+    static uint32_t s_usedMask;
+
+    static void reset(Button* pButton);
+};
+
+#endif // M5BUTTON_POOL_H
@@ -10,9 +10,9 @@
 
 #include <M5Core2.h>
 #include <Fonts/EVA_20px.h>
-#include "M5ConfigForms.h"
-#include "M5Keyboard.h"
 #include "M5ConfigFormTune.h"
+#include "SysClock.h"
+#include "M5ButtonPool.h"
 
 /* Screen layout
 * <Peak Eco>  <Peak Trail>  <Peak Turbo>
@@ -57,7 +57,7 @@ void M5ConfigFormTune::writeAssistValue(Button& button)
 // check if assist level has been changed on bike
 void M5ConfigFormTune::updateAssistChanged()
 {
-    if (millis() > tiUpdateAssist)
+    if (SysClock::IsDue((uint32_t)SysClock::Millis(), tiUpdateAssist))
     {
         levoBle.ReadAsync( LevoEsp32Ble::MOT_ASSISTLEVEL, false );
         LevoEsp32Ble::stBleVal bleVal;
@@ -70,7 +70,7 @@ void M5ConfigFormTune::updateAssistChanged()
                     onAssistLevelChanged( (LevoReadWrite::enAssistLevel)newAssistLevel );
             }
         }
-        tiUpdateAssist = millis() + 500L;
+        tiUpdateAssist = (uint32_t)SysClock::Millis() + 500L;
     }
 }
 
@@ -99,7 +99,7 @@ void M5ConfigFormTune::onAssistLevelChanged(LevoReadWrite::enAssistLevel newLeve
     }
 }
 
-bool M5ConfigFormTune::onBtPress(Button & button )
+void M5ConfigFormTune::onBtPress(Button & button )
 {
     // assist level
     if (button.userData == IDX_ASSISTLEV1 && assistLevel != LevoReadWrite::enAssistLevel::ASSIST_ECO)
@@ -109,65 +109,124 @@ bool M5ConfigFormTune::onBtPress(Button & button )
     else if (button.userData == IDX_ASSISTLEV3 && assistLevel != LevoReadWrite::enAssistLevel::ASSIST_TURBO)
         onAssistLevelChanged(LevoReadWrite::enAssistLevel::ASSIST_TURBO );
 
-    // assistance data
+    // assistance data: keyboard needs all pooled buttons
     int controlIdx = button.userData;
     if( controls[controlIdx].type == BUTTON && controlIdx > 0 )
     {
-        String text;
-        M5Keyboard keyb;
-        if ( keyb.Show( text, controls[controlIdx - 1].text, M5Keyboard::KEY_MODE_NUMERIC ) )
-        {
-            if (controls[controlIdx].pValue)
-            {
-                // validate range
-                int8_t value = atoi( text.c_str() );
-                if( value < 0 )
-                    value = 0;
-                else if( value > 100 )
-                    value = 0;
-                // set value in write buffer
-                *controls[controlIdx].pValue = value;
-                // adapt button display
-                setButtonLabel( controlIdx, button );
-                // mark color as changed and redraw
-                ButtonColors off = button.off;
-                off.text = TFT_GREEN;
-                button.off = off;
-                drawLabels();
-                // write changes back
-                M5.Buttons.draw();
-                writeAssistValue( button );
-            }
-        }
+        m_editIdx = controlIdx;
+        releaseButtons();
+        m_keyboard.Open( String(), controls[controlIdx - 1].text, M5Keyboard::KEY_MODE_NUMERIC );
+        m_state = ST_KEYBOARD;
+    }
+}
+
+void M5ConfigFormTune::onKeyboardDone(bool bOk, const String& text)
+{
+    M5.Lcd.setFreeFont(NULL); // set to built in GLCD font
+    M5.Lcd.setTextDatum(TC_DATUM);
+    createButtons();
+
+    Button* pButton = NULL;
+    for (int i = 0; i < nButtons; i++)
+        if (pButtons[i] && pButtons[i]->userData == m_editIdx)
+            pButton = pButtons[i];
+
+    if (bOk && pButton && controls[m_editIdx].pValue)
+    {
+        // validate range
+        int8_t value = atoi( text.c_str() );
+        if( value < 0 )
+            value = 0;
+        else if( value > 100 )
+            value = 0;
+        // set value in write buffer
+        *controls[m_editIdx].pValue = value;
+        // adapt button display
+        setButtonLabel( m_editIdx, *pButton );
+        // mark color as changed and redraw
+        ButtonColors off = pButton->off;
+        off.text = TFT_GREEN;
+        pButton->off = off;
         drawLabels();
+        // write changes back
         M5.Buttons.draw();
+        writeAssistValue( *pButton );
     }
+    drawLabels();
+    M5.Buttons.draw();
 }
 
-bool M5ConfigFormTune::readAssistData()
+// one read request per call, a field that times out is requested again
+void M5ConfigFormTune::readAssistStep(uint32_t timestamp)
 {
-    if (levoBle.ReadAssistDataFields( assistData) )
-    {
-        controls[IDX_PEAK_ECO].pValue   = &assistData.peakAssist[0];
-        controls[IDX_PEAK_TRAIL].pValue = &assistData.peakAssist[1];
-        controls[IDX_PEAK_TURBO].pValue = &assistData.peakAssist[2];
+    LevoEsp32Ble::enLevoBleDataType field = (m_readIdx < LevoReadWrite::NUM_ASSIST_FIELDS) ?
+        levoBle.GetAssistDataField(m_readIdx) : LevoEsp32Ble::MOT_ASSISTLEVEL;
 
-        controls[IDX_ASSIST_ECO].pValue   = &assistData.assist[0];
-        controls[IDX_ASSIST_TRAIL].pValue = &assistData.assist[1];
-        controls[IDX_ASSIST_TURBO].pValue = &assistData.assist[2];
+    if (!m_bReadPending)
+    {
+        m_bReadPending  = levoBle.ReadAsync(field, true);
+        m_tiReadTimeout = timestamp + READ_TIMEOUT_MS;
+        return;
+    }
 
-        controls[IDX_SHUTTLE].pValue      = &assistData.shuttle;
-        controls[IDX_ACCELERATION].pValue = &assistData.accelSens;
+    LevoEsp32Ble::stBleVal bleVal;
+    if (levoBle.Update(bleVal) && bleVal.dataType == field)
+    {
+        m_bReadPending = false;
+        m_readRetries  = 0;
+        if (field != LevoEsp32Ble::MOT_ASSISTLEVEL)
+        {
+            levoBle.SetAssistDataField(assistData, bleVal);
+            m_readIdx++;
+            return;
+        }
 
-        assistLevel = levoBle.GetAssistLevel();
-        controls[IDX_ASSISTLEV1].pValue = &assistLevel; // all 3 buttons share the same value
-        controls[IDX_ASSISTLEV2].pValue = &assistLevel;
-        controls[IDX_ASSISTLEV3].pValue = &assistLevel;
+        // all fields read: live data again while the form is open
+        assistLevel = (int8_t)bleVal.fVal;
+        if (m_bResubscribe)
+            levoBle.Subscribe();
+        m_bResubscribe = false;
 
-        return true;
+        if (levoBle.IsValidAssistData(assistData))
+            showAssistData();
+        else
+            exitMessage("Error reading data!");
     }
+    else if (SysClock::IsDue(timestamp, m_tiReadTimeout))
+    {
+        m_bReadPending = false;
+        if (++m_readRetries > READ_RETRIES)
+            exitMessage("Error reading data!");
+    }
+}
+
+void M5ConfigFormTune::showAssistData()
+{
+    controls[IDX_PEAK_ECO].pValue   = &assistData.peakAssist[0];
+    controls[IDX_PEAK_TRAIL].pValue = &assistData.peakAssist[1];
+    controls[IDX_PEAK_TURBO].pValue = &assistData.peakAssist[2];
+
+    controls[IDX_ASSIST_ECO].pValue   = &assistData.assist[0];
+    controls[IDX_ASSIST_TRAIL].pValue = &assistData.assist[1];
+    controls[IDX_ASSIST_TURBO].pValue = &assistData.assist[2];
+
+    controls[IDX_SHUTTLE].pValue      = &assistData.shuttle;
+    controls[IDX_ACCELERATION].pValue = &assistData.accelSens;
+
+    controls[IDX_ASSISTLEV1].pValue = &assistLevel; // all 3 buttons share the same value
+    controls[IDX_ASSISTLEV2].pValue = &assistLevel;
+    controls[IDX_ASSISTLEV3].pValue = &assistLevel;
+
+    M5.Lcd.clear(TFT_BLACK);
+
+    // create buttons
+    createButtons();
+    drawLabels();
+    M5.Buttons.draw();
 
-  return false;
+    // reset poll time for assist data
+    tiUpdateAssist = 0L;
+    m_state = ST_RUNNING;
 }
 
 void M5ConfigFormTune::setButtonLabel(int i, Button & button )
@@ -219,7 +278,7 @@ void M5ConfigFormTune::drawLabels()
     M5.Lcd.setTextDatum(TC_DATUM);
 
     int i;
-    for (i < 0; i < nElements; i++)
+    for (i = 0; i < nElements; i++)
     {
         M5.Lcd.setTextSize(controls[i].textSize);
         // draw label
@@ -231,28 +290,79 @@ void M5ConfigFormTune::drawLabels()
     }
 }
 
-M5ConfigFormTune::M5ConfigFormTune(LevoReadWrite& LevoBle) : levoBle( LevoBle )
+void M5ConfigFormTune::createButtons()
 {
-    // wait for TAP end
-    while (M5.Touch.ispressed())
-        M5.update();
+    int i, btIdx;
+    for (i = 0, btIdx = 0; i < nElements; i++)
+    {
+        // draw button
+        M5.Lcd.setTextSize(controls[i].textSize);
+        if(controls[i].type == BUTTON )
+        {
+            if( btIdx < nButtons )
+            {
+                pButtons[btIdx] = M5ButtonPool::Get( controls[i].z.x, controls[i].z.y, controls[i].z.w, controls[i].z.h, "", off_clrs, on_clrs, TC_DATUM, 0, 3, 0xFF );
+                if (pButtons[btIdx])
+                {
+                    pButtons[btIdx]->userData = i; // remember control array idx 
+                    setButtonLabel(i, *pButtons[btIdx]);
+                }
+                btIdx++;
+            }
+        }
+        else if ( controls[i].type == RADIO)
+        {
+            if (btIdx < nButtons)
+            {
+                pButtons[btIdx] = M5ButtonPool::Get(controls[i].z.x, controls[i].z.y, controls[i].z.w, controls[i].z.h, "", off_clrs, on_clrs, TC_DATUM, 0, 3, 0);
+                if (pButtons[btIdx])
+                {
+                    pButtons[btIdx]->userData = i; // remember control array idx 
+                    setRadioState(i, *pButtons[btIdx]);
+                }
+                btIdx++;
+            }
+        }
+    }
+    m_bWaitRelease = true;
+}
+
+void M5ConfigFormTune::releaseButtons()
+{
+    for (int i = 0; i < nButtons; i++)
+    {
+        if( pButtons[i] )
+            pButtons[i]->erase();
+        M5ButtonPool::Release(pButtons[i]);
+    }
+}
 
-    bool bDone = false;
+// show message, form is closed after confirm
+void M5ConfigFormTune::exitMessage(const char* msg)
+{
+    releaseButtons();
+    M5.Lcd.popState();
+    M5.Lcd.clear(TFT_BLACK);
+    m_msgBox.Open(msg);
+    m_state = ST_MSGBOX;
+}
 
+void M5ConfigFormTune::Open()
+{
     M5.Lcd.pushState();
     M5.Lcd.clear(TFT_BLACK);
     M5.Lcd.setFreeFont(NULL); // set to built in GLCD font
     M5.Lcd.setTextDatum(TC_DATUM);
 
+    m_bResubscribe = false;
     if (!levoBle.IsConnected())
     {
-        M5ConfigForms::MsgBox("Connect your bike!");
-        M5.Lcd.popState();
+        exitMessage("Connect your bike!");
         return;
     }
 
     // prepare for reading
-    bool bResubscribe = levoBle.IsSubscribed();
+    m_bResubscribe = levoBle.IsSubscribed();
     levoBle.Unsubscribe();
 
     //show message
@@ -261,102 +371,90 @@ M5ConfigFormTune::M5ConfigFormTune(LevoReadWrite& LevoBle) : levoBle( LevoBle )
     M5.Lcd.setTextSize( 2 );
     M5.Lcd.drawString("Reading data...", x, y );
 
-    // read assist data from levo
-    if (!readAssistData())
+    // read assist data from levo, polled by Update()
+    levoBle.ResetAssistData(assistData);
+    m_readIdx      = 0;
+    m_readRetries  = 0;
+    m_bReadPending = false;
+    m_state = ST_READING;
+}
+
+bool M5ConfigFormTune::Update(uint32_t timestamp)
+{
+    switch (m_state)
     {
-        M5ConfigForms::MsgBox("Error reading data!");
-        M5.Lcd.popState();
-        return;
+    case ST_MSGBOX:
+    {
+        M5MsgBox::enMsgBoxReturn ret;
+        if (!m_msgBox.Update(ret))
+            return true;
+        if (m_bResubscribe)
+            levoBle.Subscribe();
+        m_state = ST_CLOSED;
+        return false;
     }
-
-    M5.Lcd.clear(TFT_BLACK);
-
-    // create buttons
-    int i, btIdx;
-    for (i < 0, btIdx = 0; i < nElements; i++)
+    case ST_READING:
+        if (!levoBle.IsConnected())
+            exitMessage("Connection lost!");
+        else
+            readAssistStep(timestamp);
+        return true;
+    case ST_KEYBOARD:
     {
-        // draw button
-        M5.Lcd.setTextSize(controls[i].textSize);
-        if(controls[i].type == BUTTON )
+        M5Keyboard::kb_result_t ret = m_keyboard.Update();
+        if (ret != M5Keyboard::KB_RUNNING)
         {
-            if( btIdx < nButtons )
-            {
-                pButtons[btIdx] = new Button( controls[i].z.x, controls[i].z.y, controls[i].z.w, controls[i].z.h, false, "", off_clrs, on_clrs, TC_DATUM, 0, 3, 0xFF );
-                pButtons[btIdx]->userData = i; // remember control array idx 
-                setButtonLabel(i, *pButtons[btIdx]);
-                btIdx++;
-            }
-        }
-        else if ( controls[i].type == RADIO)
-        {
-            if (btIdx < nButtons)
-            {
-                pButtons[btIdx] = new Button(controls[i].z.x, controls[i].z.y, controls[i].z.w, controls[i].z.h, false, "", off_clrs, on_clrs, TC_DATUM, 0, 3, 0);
-                pButtons[btIdx]->userData = i; // remember control array idx 
-                setRadioState(i, *pButtons[btIdx]);
-                btIdx++;
-            }
+            m_state = ST_RUNNING;
+            onKeyboardDone(ret == M5Keyboard::KB_DONE, m_keyboard.GetText());
         }
+        return true;
+    }
+    case ST_RUNNING:
+        break;
+    default:
+        return false;
     }
-    drawLabels();
-    M5.Buttons.draw();
 
-    // reset poll time for assist data
-    tiUpdateAssist = 0L;
+    // exit w/o BT connection
+    if( !levoBle.IsConnected() )
+    {
+        exitMessage("Connection lost!");
+        return true;
+    }
 
-    // check buttons pressed
-    while (!bDone)
+    // wait for TAP end
+    if (m_bWaitRelease)
     {
-        M5.update();
+        m_bWaitRelease = M5.Touch.ispressed();
+        return true;
+    }
 
-        if (M5.Touch.ispressed())
+    // check buttons pressed
+    if (M5.Touch.ispressed())
+    {
+        for (int i = 0; i < nButtons; i++)
         {
-            for (i = 0; i < nButtons; i++)
+            if (pButtons[i] && pButtons[i]->wasPressed())
             {
-                if (pButtons[i] && pButtons[i]->wasPressed())
+                if(pButtons[i]->userData == IDX_BACK )  // back button
                 {
-                    if(pButtons[i]->userData == IDX_BACK )  // back button
-                    {
-                        bDone = true;
-                        break;
-                    }
-                    else
-                        onBtPress( *pButtons[i] );  // all other buttons
+                    releaseButtons();
+                    M5.Buttons.draw();
+                    M5.Lcd.popState();
+                    M5.Lcd.clear(TFT_BLACK);
+                    if (m_bResubscribe)
+                        levoBle.Subscribe();
+                    m_state = ST_CLOSED;
+                    return false;
                 }
+                onBtPress( *pButtons[i] );  // all other buttons
+                break;
             }
         }
-        else
-        {
-            // updateAssistChanged(); // needs too much time and makes GUI laggy (mean loop time: 110us instead of 50us)
-        }
-
-        if( !levoBle.IsConnected() ) // exit w/o BT connection
-            break;
     }
-
-    // wait till there is no touch anymore
-    while (M5.Touch.ispressed())
-        M5.update();
-
-    // cleanup
-    for (i = 0; i < nButtons; i++)
+    else
     {
-        if( pButtons[i] )
-        {
-            pButtons[i]->erase();
-            delete pButtons[i];
-            pButtons[i] = NULL;
-        }
+        // updateAssistChanged(); // needs too much time and makes GUI laggy (mean loop time: 110us instead of 50us)
     }
-
-    M5.Buttons.draw();
-    M5.Lcd.popState();
-
-    M5.Lcd.clear(TFT_BLACK);
-
-    if( !bDone )
-        M5ConfigForms::MsgBox("Connection lost!");
-
-    if(bResubscribe )
-        levoBle.Subscribe();
+    return true;
 }
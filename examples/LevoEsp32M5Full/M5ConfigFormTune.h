@@ -11,17 +11,40 @@
 #define M5CONFIG_FORMTUNE_H
 
 #include <LevoReadWrite.h>
-#include "M5ConfigForms.h"
+#include "M5MsgBox.h"
+#include "M5Keyboard.h"
 
 class M5ConfigFormTune
 {
 public:
-    M5ConfigFormTune( LevoReadWrite& LevoBle);
+    M5ConfigFormTune( LevoReadWrite& LevoBle) : levoBle( LevoBle ) {}
+
+    // non-blocking: Open(), then Update() from main loop until it returns false
+    void Open();
+    bool Update(uint32_t timestamp);
+    bool IsReading() { return m_state == ST_READING; } // form polls BLE values itself
 
 protected:
     
     // reference to bt communication
     LevoReadWrite& levoBle;
+
+    // form state
+    typedef enum
+    {
+        ST_CLOSED = 0,
+        ST_READING, // one assist data field per request, notifications unsubscribed
+        ST_RUNNING,
+        ST_KEYBOARD,
+        ST_MSGBOX, // closes form
+    } enState;
+
+    enState    m_state        = ST_CLOSED;
+    bool       m_bWaitRelease = false;
+    bool       m_bResubscribe = false;
+    int        m_editIdx      = 0;  // control edited with keyboard
+    M5MsgBox   m_msgBox;
+    M5Keyboard m_keyboard;
     
     typedef enum
     {
@@ -89,7 +112,14 @@ protected:
     LevoReadWrite::stLevoAssist assistData;
     int8_t assistLevel = (int8_t)LevoReadWrite::enAssistLevel::INVALID;
 
-    bool readAssistData();
+    // reading assist data fields, assist level last
+    enum { READ_TIMEOUT_MS = 1000, READ_RETRIES = 2 };
+    int      m_readIdx       = 0;
+    int      m_readRetries   = 0;
+    bool     m_bReadPending  = false;
+    uint32_t m_tiReadTimeout = 0L;
+    void readAssistStep(uint32_t timestamp);
+    void showAssistData();
     void setButtonLabel( int i, Button & button );
     void setRadioState(int i, Button& button);
     void updateRadioButtons();
@@ -100,7 +130,11 @@ protected:
     uint32_t tiUpdateAssist = 0L;
     void updateAssistChanged();
 
-    bool onBtPress(Button & button );
+    void createButtons();
+    void releaseButtons();
+    void exitMessage(const char* msg);
+    void onBtPress(Button & button );
+    void onKeyboardDone(bool bOk, const String& text);
     void onAssistLevelChanged(LevoReadWrite::enAssistLevel newLevel );
 };
 
@@ -9,19 +9,18 @@
 
 #include <WiFi.h>
 #include "M5ConfigFormWifi.h"
+#include "SysClock.h"
+#include "M5ButtonPool.h"
 
-bool M5ConfigFormWifi::SelectAccessPointPage( String & ssid )
+void M5ConfigFormWifi::Open()
 {
-    int i = 0;
-    const int NBUTTONS = 5;
-    const int LIST_Y = 25;
-    bool bDone = false;
-    int nScanCycles = 0;
+    int i;
 
     M5.Lcd.pushState();
     M5.Lcd.clear(TFT_BLACK);
 
-    bool hasFirstResult = false;
+    m_hasFirstResult = false;
+    m_nScanCycles = 0;
     WiFi.mode(WIFI_STA);
     WiFi.disconnect();
 
@@ -34,21 +33,40 @@ bool M5ConfigFormWifi::SelectAccessPointPage( String & ssid )
     M5.Lcd.drawString( "Select Wifi network:", 2, 2 );
     M5.Lcd.setTextSize(2);
 
-    String ssids[NBUTTONS];
-    Button* pButtons[NBUTTONS] = { NULL, NULL, NULL, NULL, NULL };
     const int cx = M5.Lcd.width() - 10, cy = M5.Lcd.fontHeight();
 
     // 5 button list
     for( i = 0; i < NBUTTONS; i++ )
-        pButtons[i] = new Button(2, i * cy + LIST_Y, cx, cy, false, "", off_clrs, on_clrs, TL_DATUM, 0, 3, 0);
-    
+    {
+        m_ssids[i] = "";
+        m_pButtons[i] = M5ButtonPool::Get(2, i * cy + LIST_Y, cx, cy, "", off_clrs, on_clrs, TL_DATUM, 0, 3, 0);
+    }
+
     // back button
-    Button btBack( M5.Lcd.width()/2 - 50, M5.Lcd.height() - 35, 100, cy - 5, false, "Back", off_clrs2, on_clrs2, TC_DATUM, 0, 3 );
+    m_pBtBack = M5ButtonPool::Get( M5.Lcd.width()/2 - 50, M5.Lcd.height() - 35, 100, cy - 5, "Back", off_clrs2, on_clrs2, TC_DATUM, 0, 3 );
+    if (m_pBtBack)
+        m_pBtBack->draw();
+
+    // first scan result after some time
+    m_tiScan = (uint32_t)SysClock::Millis() + 100;
+    m_bWaitRelease = true;
+}
+
+M5ConfigFormWifi::enResult M5ConfigFormWifi::Update( String & ssid )
+{
+    int i;
+
+    // wait for TAP end
+    if (m_bWaitRelease)
+    {
+        m_bWaitRelease = M5.Touch.ispressed();
+        return RUNNING;
+    }
 
-    // do scan
-    delay(100);
-    while (1)
+    // poll scan
+    if (SysClock::IsDue((uint32_t)SysClock::Millis(), m_tiScan))
     {
+        m_tiScan = (uint32_t)SysClock::Millis() + 10;
         int scanCount = WiFi.scanComplete();
         if (scanCount == WIFI_SCAN_FAILED )
         {
@@ -57,9 +75,9 @@ bool M5ConfigFormWifi::SelectAccessPointPage( String & ssid )
         else if (scanCount == WIFI_SCAN_RUNNING)
         {
             // Serial.println("Wifi scanning");
-            if (!hasFirstResult)
+            if (!m_hasFirstResult)
             {
-                nScanCycles++;
+                m_nScanCycles++;
                 // show scanning... animation since we have no hits 
                 M5.Lcd.setFreeFont(FF1);
                 M5.Lcd.setTextSize(1);
@@ -67,7 +85,7 @@ bool M5ConfigFormWifi::SelectAccessPointPage( String & ssid )
                 M5.Lcd.setCursor( 100, 110 );
                 M5.Lcd.print("Scanning");
                 M5.Lcd.fillRect(M5.Lcd.getCursorX(), 110, 50, 30, TFT_BLACK);
-                for( int z = 0; z < ((nScanCycles/20) % 4); z++)
+                for( int z = 0; z < ((m_nScanCycles/20) % 4); z++)
                     M5.Lcd.print(".");
             }
         }
@@ -79,10 +97,10 @@ bool M5ConfigFormWifi::SelectAccessPointPage( String & ssid )
         else
         {
             // draw network names (ssid)
-            for (int i = 0; i < min( scanCount, NBUTTONS); i++)
+            for (i = 0; i < min( scanCount, (int)NBUTTONS); i++)
             {
                 String SSIDStr = WiFi.SSID(i);
-                ssids[i] = SSIDStr;
+                m_ssids[i] = SSIDStr;
                 // limit display name length
                 if (SSIDStr.length() > 45)
                 {
@@ -100,47 +118,48 @@ bool M5ConfigFormWifi::SelectAccessPointPage( String & ssid )
                 SSIDStr += ssidBar;
 
                 // set network name as button label
-                pButtons[i]->setLabel(SSIDStr.c_str());
+                if (m_pButtons[i])
+                    m_pButtons[i]->setLabel(SSIDStr.c_str());
             }
             M5.Buttons.draw();
 
             WiFi.scanDelete();
             WiFi.scanNetworks(true);
-            hasFirstResult = true;
+            m_hasFirstResult = true;
         }
+    }
 
-        // check pressed
-        M5.update();
-        for (i = 0; i < NBUTTONS; i++)
+    // check pressed
+    for (i = 0; i < NBUTTONS; i++)
+    {
+        if( m_pButtons[i] && m_pButtons[i]->wasPressed() && !m_ssids[i].isEmpty() )
         {
-            if( pButtons[i]->wasPressed() )
-            {
-                ssid = ssids[i];
-                bDone = true;
-                break;
-            }
+            ssid = m_ssids[i];
+            close();
+            return SELECTED;
         }
+    }
 
-        if (btBack.wasPressed())
-            break;
-
-        if( bDone )
-            break;
-
-        delay(10);
+    if (m_pBtBack && m_pBtBack->wasPressed())
+    {
+        close();
+        return BACK;
     }
+    return RUNNING;
+}
 
-    // wait till there is no touch anymore
-    while (M5.Touch.ispressed())
-        M5.update();
+void M5ConfigFormWifi::close()
+{
+    WiFi.scanDelete();
 
     // cleanup
-    for ( i = 0; i < NBUTTONS; i++)
+    for (int i = 0; i < NBUTTONS; i++)
     {
-        pButtons[i]->erase();
-        delete pButtons[i];
+        if (m_pButtons[i])
+            m_pButtons[i]->erase();
+        M5ButtonPool::Release(m_pButtons[i]);
     }
+    M5ButtonPool::Release(m_pBtBack);
 
     M5.Lcd.popState();
-    return !ssid.isEmpty();
 }
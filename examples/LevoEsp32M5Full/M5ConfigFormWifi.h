@@ -15,9 +15,30 @@
 class M5ConfigFormWifi
 {
 public:
-    bool SelectAccessPointPage(String& ssid);
+    typedef enum
+    {
+        RUNNING = 0,
+        SELECTED,
+        BACK,
+    } enResult;
+
+    // non-blocking: Open(), then Update() from main loop until it returns SELECTED or BACK
+    void     Open();
+    enResult Update(String& ssid);
 
 protected:
+    enum { NBUTTONS = 5, LIST_Y = 25 };
+
+    String   m_ssids[NBUTTONS];
+    Button*  m_pButtons[NBUTTONS] = { NULL, NULL, NULL, NULL, NULL };
+    Button*  m_pBtBack       = NULL;
+    bool     m_hasFirstResult = false;
+    bool     m_bWaitRelease  = false;
+    int      m_nScanCycles   = 0;
+    uint32_t m_tiScan        = 0;
+
+    void close();
+
     ButtonColors on_clrs = { GREEN, WHITE, BLACK };
     ButtonColors off_clrs = { BLACK, WHITE, BLACK };
 
@@ -3,148 +3,123 @@
  *      Author: Bernd Wokoeck
  *
  *  Configuration forms for settings
- * 
+ *
  * https://docs.m5stack.com/#/en/arduino/arduino_home_page?id=m5core2_api
 */
 
 #include <M5Core2.h>
-#include <Fonts/EVA_20px.h>
 #include "M5ConfigForms.h"
+#include "SysClock.h"
+#include "M5ButtonPool.h"
+#include "PowerUtil.h"
 #include "M5NTPTime.h"
-#include "M5Keyboard.h"
-#include "M5ConfigFormWifi.h"
 #include "FileLogger.h"
 #include "AltimeterBMP280.h"
 
 ButtonColors M5ConfigForms::on_clrs = { GREEN, WHITE, WHITE };
 ButtonColors M5ConfigForms::off_clrs = { BLACK, WHITE, WHITE };
 
-// simple full screen centered two line message
-M5ConfigForms::enMsgBoxReturn M5ConfigForms::MsgBox(const char* msg, enMsgBoxButtons type)
+void M5ConfigForms::Open(Settings& settings)
 {
-    enMsgBoxReturn ret = RET_CANCEL;
-
-    // wait till there is no touch anymore
-    while (M5.Touch.ispressed())
-        M5.update();
-
-    // print message
-    M5.Lcd.clear(TFT_BLACK);
+    m_pSettings = &settings;
+    m_depth  = 0;
+    m_dialog = DLG_NONE;
     M5.Lcd.pushState();
+    pushPage(PAGE_MAIN);
+}
 
-    TFT_eSprite lcdbuff = TFT_eSprite(&M5.Lcd);
-    lcdbuff.createSprite(320, 240);
-    lcdbuff.setFreeFont(&EVA_20px);
-    lcdbuff.setTextSize(1);
-    lcdbuff.setTextColor(TFT_WHITE, TFT_BLACK);
-    lcdbuff.setTextDatum(TC_DATUM);
-    int x = M5.Lcd.width() / 2;
-    int y = M5.Lcd.height() / 2 - 10;
-    lcdbuff.drawString( msg, x, y, GFXFF);
-    lcdbuff.pushSprite(0, 0);
+bool M5ConfigForms::Update(uint32_t timestamp)
+{
+    if (m_depth == 0)
+        return false;
 
-    // show buttons
-    Button * b1 = NULL, * b2 = NULL;
-    const int cx = 100, cy = 35;
-    const int bx = M5.Lcd.width()/4 - cx/2;
-    const int by = M5.Lcd.height()/4 * 3;
-    switch (type)
+    switch (m_dialog)
     {
-    case CONFIRM:
-        b1 = new Button(x - cx / 2, by, cx, cy, false, "OK", off_clrs, on_clrs, TC_DATUM, 0, 3);
-        break;
-    case OKCANCEL:
-        b1 = new Button(bx, by, cx, cy, false, "OK", off_clrs, on_clrs, TC_DATUM, 0, 3);
-        b2 = new Button((bx + cx / 2) * 3 - cx / 2, by, cx, cy, false, "Cancel", off_clrs, on_clrs, TC_DATUM, 0, 3);
-        break;
-    case YESNO:
-        b1 = new Button(bx, by, cx, cy, false, "Yes", off_clrs, on_clrs, TC_DATUM, 0, 3);
-        b2 = new Button((bx + cx / 2) * 3 - cx / 2, by, cx, cy, false, "No", off_clrs, on_clrs, TC_DATUM, 0, 3);
-        break;
-    }
-    M5.Buttons.draw();
-
-    // check pressed
-    while (1)
+    case DLG_MSGBOX:
     {
-        M5.update();
-        if ( b1 && b1->wasPressed() )
+        M5MsgBox::enMsgBoxReturn ret;
+        if (m_msgBox.Update(ret))
         {
-            if( type == CONFIRM ||type == OKCANCEL)
-                ret = RET_OK;
-            else
-                ret = RET_YES;
-            break;
+            m_dialog = DLG_NONE;
+            onMsgBoxDone(ret);
         }
-        else if (b2 && b2->wasPressed())
+        break;
+    }
+    case DLG_KEYBOARD:
+    {
+        M5Keyboard::kb_result_t ret = m_keyboard.Update();
+        if (ret != M5Keyboard::KB_RUNNING)
         {
-            if ( type == OKCANCEL)
-                ret = RET_CANCEL;
-            else
-                ret = RET_NO;
-            break;
+            m_dialog = DLG_NONE;
+            onKeyboardDone(ret == M5Keyboard::KB_DONE, m_keyboard.GetText());
         }
+        break;
     }
-
-    // wait till there is no touch anymore
-    while (M5.Touch.ispressed())
-        M5.update();
-
-    // cleanup
-    if( b1 )
+    case DLG_WIFISCAN:
     {
-        b1->erase();
-        delete b1;
+        M5ConfigFormWifi::enResult ret = m_wifiForm.Update(m_ssid);
+        if (ret != M5ConfigFormWifi::RUNNING)
+        {
+            m_dialog = DLG_NONE;
+            wifiSelected(ret == M5ConfigFormWifi::SELECTED);
+        }
+        break;
     }
-    if( b2 )
-    {
-        b2->erase();
-        delete b2;
+    case DLG_WIFICONNECT:
+        wifiPollConnect(timestamp);
+        break;
+    case DLG_ROUTE:
+        routeStep();
+        break;
+    default:
+        updatePage();
+        break;
     }
 
-    M5.Lcd.popState();
+    // back from a dialog
+    if (m_depth > 0 && m_dialog == DLG_NONE && !m_bPageShown)
+        showPage();
 
-    return ret;
+    return m_depth > 0;
 }
 
-// set button colors due to check state
-void M5ConfigForms::CheckButtons(int nPressed, stItem* pItems, int nItems, Button* pButtons[])
+void M5ConfigForms::pushPage(enPage page)
 {
-    int i;
-    for (i = 0; i < nItems; i++)
-    {
-        if (pItems[i].type == CHECKBOX || pItems[i].type == RADIO)
-        {
-            if (nPressed >= 0) // not during initialization
-            {
-                if (i == nPressed)
-                    pItems[i].bChecked = pItems[i].bChecked ? false : true; // toggle state
-                else if (pItems[i].type == RADIO)
-                    pItems[i].bChecked = false;   // uncheck other radio buttons
-            }
+    if (m_depth >= MAX_DEPTH)
+        return;
+    releaseButtons();
+    stPage& pg = m_pages[m_depth++];
+    pg.page = page;
+    initPage(pg);
+}
 
-            if (pButtons[i])
-            {
-                if (pItems[i].bChecked)
-                    pButtons[i]->off = { GREEN, BLACK, DARKGREY }; // bg text outline
-                else
-                    pButtons[i]->off = { BLACK, WHITE, DARKGREY }; // bg text outline
-            }
-        }
+// leave page, write its values to settings
+void M5ConfigForms::popPage()
+{
+    releaseButtons();
+    exitPage(m_pages[--m_depth]);
+    if (m_depth == 0)
+    {
+        M5.Lcd.popState();
+        M5.Lcd.clear(TFT_BLACK);
     }
 }
 
-// show check item page (max. 6 items)
-int M5ConfigForms::PageCheckMenu(stItem* pItems, int nItems)
+void M5ConfigForms::releaseButtons()
 {
-    int cmd = 0;
-    bool bDone = false;
+    for (int i = 0; i < MAX_ITEMS; i++)
+        M5ButtonPool::Release(m_pButtons[i]);
+    m_bPageShown = false;
+}
 
-    // wait for TAP end
-    while (M5.Touch.ispressed())
-        M5.update();
+// show check item page (max. 6 items)
+void M5ConfigForms::showPage()
+{
+    stPage& pg = m_pages[m_depth - 1];
+    stItem* pItems = pg.items;
+    int nItems = min(pg.nItems, (int)MAX_ITEMS);
 
-    M5.Lcd.pushState();
+    releaseButtons();
     M5.Lcd.clear(TFT_BLACK);
 
     // buttons/menu items
@@ -152,7 +127,6 @@ int M5ConfigForms::PageCheckMenu(stItem* pItems, int nItems)
     int cx = 250, cy = 35;
     int yinc = 200 / nItems;  // 50 pixel @4 buttons
     int x = M5.lcd.width() / 2 - cx / 2, y = 32;
-    const int maxButtons = 6;
 
     if( nItems == 6 ) // todo quick and dirty
     {
@@ -160,544 +134,640 @@ int M5ConfigForms::PageCheckMenu(stItem* pItems, int nItems)
         yinc = 40;
     }
 
-    nItems = min(nItems, maxButtons);
-    Button* pButtons[maxButtons] = { NULL,NULL,NULL,NULL,NULL,NULL };
     for (i = 0; i < nItems; i++)
     {
         if (pItems[i].type == BUTTON)
         {
-            pButtons[i] = new Button(x, y + (i * yinc), cx, cy, false, "", off_clrs, on_clrs, TC_DATUM, 0, 3);
-            pButtons[i]->setLabel(pItems[i].label);
+            m_pButtons[i] = M5ButtonPool::Get(x, y + (i * yinc), cx, cy, pItems[i].label, off_clrs, on_clrs, TC_DATUM, 0, 3);
         }
         else if (pItems[i].type == CHECKBOX || pItems[i].type == RADIO)
         {
-            pButtons[i] = new Button(x, y + (i * yinc), cx, cy, false, "", off_clrs, on_clrs, TC_DATUM, 0, 3, 0);
-            pButtons[i]->setLabel(pItems[i].label);
-            CheckButtons(-1, pItems, nItems, pButtons);
+            m_pButtons[i] = M5ButtonPool::Get(x, y + (i * yinc), cx, cy, pItems[i].label, off_clrs, on_clrs, TC_DATUM, 0, 3, 0);
         }
         else if (pItems[i].type == NUMINPUT || pItems[i].type == TXTINPUT)
         {
-            pButtons[i] = new Button(x, y + (i * yinc), cx, cy, false, "", off_clrs, on_clrs, TC_DATUM, 0, 3);
             char label[51];
             snprintf(label, sizeof(label), "%s: %s", pItems[i].label, pItems[i].value);
-            pButtons[i]->setLabel(label);
+            m_pButtons[i] = M5ButtonPool::Get(x, y + (i * yinc), cx, cy, label, off_clrs, on_clrs, TC_DATUM, 0, 3);
         }
     }
+    CheckButtons(-1, pItems, nItems, m_pButtons);
     M5.Buttons.draw();
 
-    // check pressed
-    while (!bDone)
-    {
-        M5.update();
-        for (i = 0; i < nItems; i++)
-        {
-            if (pButtons[i]->wasPressed())
-            {
-                if (pItems[i].type == BUTTON)
-                {
-                    cmd = pItems[i].cmdId;
-                    bDone = true;
-                    break;
-                }
-                else if (pItems[i].type == CHECKBOX || pItems[i].type == RADIO)
-                {
-                    CheckButtons(i, pItems, nItems, pButtons);
-                    M5.Buttons.draw();
-                    break;
-                }
-                else if (pItems[i].type == NUMINPUT || pItems[i].type == TXTINPUT)
-                {
-                    String text;
-                    M5Keyboard::key_mode_t keyMode = (pItems[i].type == NUMINPUT) ? M5Keyboard::KEY_MODE_FNUMERIC : M5Keyboard::KEY_MODE_LETTER;
-                    M5Keyboard keyb;
-                    if (keyb.Show(text, pItems[i].label, keyMode))
-                    {
-                        char label[51];
-                        snprintf(label, sizeof(label), "%s: %s", pItems[i].label, text.c_str());
-                        snprintf(pItems[i].value, pItems[i].lenValue, "%s", text.c_str());
-                        pButtons[i]->setLabel(label);
-                    }
-                    M5.Buttons.draw();
-                }
-            }
-        }
-    }
-
-    // wait till there is no touch anymore
-    while (M5.Touch.ispressed())
-        M5.update();
+    m_bPageShown   = true;
+    m_bWaitRelease = true;
+}
 
-    // cleanup
-    for (i = 0; i < nItems; i++)
+// check pressed
+void M5ConfigForms::updatePage()
+{
+    // wait for TAP end
+    if (m_bWaitRelease)
     {
-        pButtons[i]->erase();
-        delete pButtons[i];
+        m_bWaitRelease = M5.Touch.ispressed();
+        return;
     }
 
-    M5.Lcd.popState();
-    M5.Lcd.clear(TFT_BLACK);
-
-    return cmd;
-}
+    stPage& pg = m_pages[m_depth - 1];
+    stItem* pItems = pg.items;
+    for (int i = 0; i < pg.nItems; i++)
+    {
+        if (m_pButtons[i] == NULL || !m_pButtons[i]->wasPressed())
+            continue;
 
-// enter bluetooth pin
-void M5ConfigForms::OnCmdBtPin(Preferences& prefs)
-{
-    // wait till there is no touch anymore
-    while (M5.Touch.ispressed())
-        M5.update();
-
-    Serial.println("btPin...");
-    String str = "";
-    M5Keyboard keyb;
-    bool ret = keyb.Show( str, "Enter bluetooth pin:", M5Keyboard::KEY_MODE_NUMERIC );
-    Serial.println( str );
-    if ( ret )
-    {
-        uint32_t pin = atol(str.c_str());
-        if( pin )
+        if (pItems[i].type == BUTTON)
         {
-            Serial.println("...written to prefs");
-            prefs.putULong("BtPin", atol(str.c_str()));
+            if (pItems[i].cmdId == 0)
+                popPage();
+            else
+                onCommand(pg.page, pItems[i].cmdId);
         }
-        else
+        else if (pItems[i].type == CHECKBOX || pItems[i].type == RADIO)
         {
-            Serial.println("...deleted from prefs");
-            prefs.remove("BtPin");
+            CheckButtons(i, pItems, pg.nItems, m_pButtons);
+            M5.Buttons.draw();
         }
-        // show restart message
-        MsgBox("Bluetooth pin changed. Restart!");
-
-        prefs.end();
-        ESP.restart(); // brute force
+        else if (pItems[i].type == NUMINPUT || pItems[i].type == TXTINPUT)
+        {
+            m_editItem = i;
+            openKeyboard(pItems[i].label, (pItems[i].type == NUMINPUT) ? M5Keyboard::KEY_MODE_FNUMERIC : M5Keyboard::KEY_MODE_LETTER, ACT_EDITITEM);
+        }
+        break;
     }
 }
 
-// clear preferences
-void M5ConfigForms::OnCmdClearAll(Preferences& prefs)
+// set button colors due to check state
+void M5ConfigForms::CheckButtons(int nPressed, stItem* pItems, int nItems, Button* pButtons[])
 {
-    if( MsgBox("*REALLY* delete all settings?", YESNO ) == RET_YES )
+    int i;
+    for (i = 0; i < nItems; i++)
     {
-        prefs.clear();
-        prefs.end();
-        ESP.restart(); // brute force
+        if (pItems[i].type == CHECKBOX || pItems[i].type == RADIO)
+        {
+            if (nPressed >= 0) // not during initialization
+            {
+                if (i == nPressed)
+                    pItems[i].bChecked = pItems[i].bChecked ? false : true; // toggle state
+                else if (pItems[i].type == RADIO)
+                    pItems[i].bChecked = false;   // uncheck other radio buttons
+            }
+
+            if (pButtons[i])
+            {
+                if (pItems[i].bChecked)
+                    pButtons[i]->off = { GREEN, BLACK, DARKGREY }; // bg text outline
+                else
+                    pButtons[i]->off = { BLACK, WHITE, DARKGREY }; // bg text outline
+            }
+        }
     }
 }
 
-// set RTC from NTP server (Wifi internet connection)
-void M5ConfigForms::OnCmdClockWifi(Preferences& prefs)
+void M5ConfigForms::openMsgBox(const char* msg, M5MsgBox::enMsgBoxButtons type, enAction action)
 {
-    String ssid;
-    String pwd;
-    bool bPwdChanged = false;
+    releaseButtons();
+    m_msgBox.Open(msg, type);
+    m_dialog = (type == M5MsgBox::NOBUTTON) ? DLG_NONE : DLG_MSGBOX;
+    m_action = action;
+}
 
-    // read preferences for ssid and pwd
-    ssid = prefs.getString("SSID");
-    if( !ssid.isEmpty())
-        pwd = prefs.getString( "WifiPwd" );
-
-RETRY:
-    // if there is no ssid and pwd, select it
-    if( pwd.isEmpty() )
-    {
-      M5ConfigFormWifi configWifi;
-      if (configWifi.SelectAccessPointPage(ssid))
-      {
-          // Serial.println( ssid );
-          if (!ssid.isEmpty())
-          {
-              pwd = prefs.getString("WifiPwd");
-              if (!pwd.isEmpty())
-              {
-                  if (MsgBox("Use stored password?", YESNO) == RET_NO)
-                      pwd = "";
-              }
-              if (pwd.isEmpty())
-              {
-                  String text;
-                  M5Keyboard keyb;
-                  if (keyb.Show(text, "Enter Wifi password:"))
-                  {
-                      pwd = text;
-                      bPwdChanged = true;
-                  }
-              }
-          }
-      }
-    }
+void M5ConfigForms::openKeyboard(const char* title, M5Keyboard::key_mode_t keyMode, enAction action)
+{
+    releaseButtons();
+    m_keyboard.Open(String(), title, keyMode);
+    m_dialog = DLG_KEYBOARD;
+    m_action = action;
+}
 
-    // credentials missing
-    if (ssid.isEmpty() || pwd.isEmpty())
+void M5ConfigForms::onMsgBoxDone(M5MsgBox::enMsgBoxReturn ret)
+{
+    Settings& settings = *m_pSettings;
+    switch (m_action)
     {
-        if (MsgBox("No credentials. Retry?", YESNO) == RET_YES)
-            goto RETRY;
+    case ACT_CLEARALL:
+        if (ret == M5MsgBox::RET_YES)
+        {
+            settings.Clear();
+            settings.GetPrefs().end();
+            ESP.restart(); // brute force
+        }
+        break;
+    case ACT_WIFI_STOREDPWD:
+        if (ret == M5MsgBox::RET_NO)
+            m_pwd = "";
+        if (m_pwd.isEmpty())
+            openKeyboard("Enter Wifi password:", M5Keyboard::KEY_MODE_LETTER, ACT_WIFI_PWD);
         else
-            return;
+            wifiCheckCredentials();
+        break;
+    case ACT_WIFI_RETRY:
+        if (ret == M5MsgBox::RET_YES)
+            wifiSelect();
+        break;
+    case ACT_WIFI_TEST:
+        wifiConnect();
+        break;
+    case ACT_WIFI_FAILED:
+        if (ret == M5MsgBox::RET_YES)
+        {
+            m_pwd = "";
+            wifiSelect();
+        }
+        break;
+    case ACT_WIFI_STOREPWD:
+        if (ret == M5MsgBox::RET_YES)
+            settings.GetPrefs().putString("WifiPwd", m_pwd);
+        wifiSetTime();
+        break;
+    default:
+        break;
     }
+}
 
-    // now we can test
-    Serial.println("Testing wifi");
-    MsgBox( "Start testing Wifi connection");
-    WiFi.begin(ssid.c_str(), pwd.c_str());
-    uint32_t to = millis() + 10000L;
-    while (WiFi.status() != WL_CONNECTED)
+void M5ConfigForms::onKeyboardDone(bool bOk, const String& text)
+{
+    Settings& settings = *m_pSettings;
+    switch (m_action)
     {
-        if( millis() > to )
+    case ACT_EDITITEM:
+        if (bOk)
         {
-            if( MsgBox("Failed! Select another one?", YESNO ) == RET_YES )
+            stItem& item = m_pages[m_depth - 1].items[m_editItem];
+            snprintf(item.value, item.lenValue, "%s", text.c_str());
+        }
+        break;
+    case ACT_BTPIN:
+        Serial.println(text);
+        if (bOk)
+        {
+            uint32_t pin = atol(text.c_str());
+            Serial.println( pin ? "...written to prefs" : "...deleted from prefs" ); // 0: no pin
+            settings.SetUInt(Settings::BT_PIN, pin);
+            // BLE reconnects when settings are closed
+            openMsgBox("Bluetooth pin changed. Reconnect on exit.");
+        }
+        break;
+    case ACT_ALTIMETER:
+        Serial.println(text);
+        if (bOk)
+        {
+            uint32_t altitude = atol(text.c_str());
+            if (altitude)
             {
-                pwd = "";
-                goto RETRY;
+                float sealevelhPa = AltimeterBMP280::GetCurrentSealevelhPa((float)altitude);
+                if(sealevelhPa != 0.0 )
+                {
+                    settings.SetFloat(Settings::SEALEVEL_HPA, sealevelhPa);
+                    Serial.printf("SealevelPressure (hPa): %f\r\n", sealevelhPa);
+                }
             }
-            else
-              return;
         }
-        delay( 100 );
+        break;
+    case ACT_WIFI_PWD:
+        if (bOk)
+        {
+            m_pwd = text;
+            m_bPwdChanged = true;
+        }
+        wifiCheckCredentials();
+        break;
+    default:
+        break;
     }
-
-    // connected, write prefs
-    prefs.putString("SSID", ssid);
-    if( bPwdChanged && MsgBox("Store Wifi Pwd?", YESNO ) == RET_YES )
-        prefs.putString("WifiPwd", pwd );
-
-    Serial.println("Set NTP time");
-
-    // finally set time
-    M5NTPTime NtpTime;
-    if( NtpTime.SetTime(ssid.c_str(), pwd.c_str() ) )
-        MsgBox( "Internet time set!" );
-    else
-        MsgBox("Error setting time!");
 }
 
-void M5ConfigForms::OnCmdPowerMore(Preferences& prefs)
+// command handler for menu buttons
+void M5ConfigForms::onCommand(enPage page, int cmd)
 {
-    int cmd = 0;
-
-    stItem items[5] =
-    {
-        { 1, NUMINPUT, false, "# of calibration runs", NULL, 0 },
-        { 2, NUMINPUT, false, "Average rider power",   NULL, 0 },
-        { 3, NUMINPUT, false, "Default air temp",      NULL, 0 },
-        { 4, NUMINPUT, false, "Default altitude",      NULL, 0 },
-        { 0, BUTTON,   false, "Back",                  NULL, 0 },
-    };
-
-    // number of calibration runs
-    char strnRuns[10];
-    uint16_t nRuns = prefs.getUChar("Sp_nRuns", 4);
-    snprintf(strnRuns, sizeof(strnRuns), "%d", nRuns);
-    items[0].value = strnRuns;
-    items[0].lenValue = sizeof(strnRuns);
-
-    // avgRiderPower
-    char strAvgRiderPower[10];
-    float avgRiderPower = prefs.getFloat("Sp_avgRdPower", 100.0);
-    dtostrf(avgRiderPower, 3, 0, strAvgRiderPower);
-    items[1].value = strAvgRiderPower;
-    items[1].lenValue = sizeof(strAvgRiderPower);
-
-    // default air temp
-    char strDefaultAirTemp[10];
-    float defaultAirTemp = prefs.getFloat("Sp_defAirTemp", 18.0);
-    dtostrf(defaultAirTemp, 3, 1, strDefaultAirTemp);
-    items[2].value = strDefaultAirTemp;
-    items[2].lenValue = sizeof(strDefaultAirTemp);
-
-    // default altitude
-    char strDefaultAltitude[10];
-    float defaultAltitude = prefs.getFloat("Sp_defAlt", 100.0);
-    dtostrf(defaultAltitude, 4, 0, strDefaultAltitude);
-    items[3].value = strDefaultAltitude;
-    items[3].lenValue = sizeof(strDefaultAltitude);
-
-    while ((cmd = PageCheckMenu(items, N_ELE(items))) != 0)
-    {
-        ;
-    }
-
-    // number of calibration runs
-    uint8_t nRuns2 = atoi(items[0].value);
-    if (nRuns != nRuns2 && nRuns2 > 0 && nRuns2 < 16)
-        prefs.putUChar("Sp_nRuns", nRuns2);
-
-    // avgRiderPower
-    float avgRiderPower2 = atof(items[1].value);
-    if (avgRiderPower != avgRiderPower2 && avgRiderPower2 > 10.0 && avgRiderPower2 < 400.0)
-        prefs.putFloat("Sp_avgRdPower", avgRiderPower2);
-
-    // default air temp
-    float defaultAirTemp2 = atof(items[2].value);
-    if (defaultAirTemp != defaultAirTemp2 && defaultAirTemp2 > -20.0 && defaultAirTemp2 < 40.0)
-        prefs.putFloat("Sp_defAirTemp", defaultAirTemp2);
-
-    // default altitude
-    float defaultAltitude2 = atof(items[3].value);
-    if (defaultAltitude != defaultAltitude2 && defaultAltitude2 > 0.0 && defaultAltitude2 < 5000.0)
-        prefs.putFloat("Sp_defAlt", defaultAltitude2);
-}
-
-void M5ConfigForms::OnCmdPower(Preferences& prefs)
-{
-    int cmd = 0;
-
-    stItem items[6] =
-    {
-        { 1, CHECKBOX, false, "Enable calibration", NULL, 0 },
-        { 2, NUMINPUT, false, "System mass (kg)", NULL, 0 },
-        { 3, NUMINPUT, false, "Roll resist", NULL, 0 },
-        { 4, NUMINPUT, false, "Air resist", NULL, 0 },
-        { 5, BUTTON,   false, "More...", NULL, 0 },
-        { 0, BUTTON,   false, "Back", NULL, 0 },
-    };
-
-    // power calibration mode
-    bool bCalib = items[0].bChecked = prefs.getUChar("PwrCalibEnabled", 0) ? true : false;
-
-    // mass
-    char strMass[10];
-    float mass = prefs.getFloat("Sp_mass", 110.0);
-    dtostrf( mass, 3, 0, strMass);
-    items[1].value = strMass;
-    items[1].lenValue = sizeof(strMass);
-
-    // cR
-    char strcR[10];
-    float cR = prefs.getFloat("Sp_cR", 0.0);
-    dtostrf( cR, 9, 7, strcR);
-    items[2].value = strcR;
-    items[2].lenValue = sizeof(strcR);
-
-    // cwA
-    char strcwA[10];
-    float cwA = prefs.getFloat("Sp_cwA", 0.0);
-    dtostrf( cwA, 9, 7, strcwA);
-    items[3].value = strcwA;
-    items[3].lenValue = sizeof(strcwA);
-
-    while ((cmd = PageCheckMenu(items, N_ELE(items))) != 0)
+    switch (page)
     {
+    case PAGE_MAIN:
         switch (cmd)
         {
-        case 5: OnCmdPowerMore(prefs); break;
+        case 2: pushPage(PAGE_LOGGING);   break;
+        case 3: pushPage(PAGE_POWER);     break;
+        case 4: pushPage(PAGE_MORE);      break;
         }
+        break;
+    case PAGE_POWER:
+        if (cmd == 5)
+            pushPage(PAGE_POWERMORE);
+        break;
+    case PAGE_POWERMORE:
+        if (cmd == 5)
+            OnCmdPlanRoute();
+        break;
+    case PAGE_MORE:
+        switch (cmd)
+        {
+        case 1:
+            Serial.println("btPin...");
+            openKeyboard("Enter bluetooth pin:", M5Keyboard::KEY_MODE_NUMERIC, ACT_BTPIN);
+            break;
+        case 2: OnCmdAltimeter();         break;
+        case 3: pushPage(PAGE_SCREEN);    break;
+        case 4: pushPage(PAGE_MORE2);     break;
+        }
+        break;
+    case PAGE_MORE2:
+        switch (cmd)
+        {
+        case 1: wifiStart(); break;
+        case 2: openMsgBox("*REALLY* delete all settings?", M5MsgBox::YESNO, ACT_CLEARALL); break;
+        }
+        break;
+    default:
+        break;
     }
-
-    // write power calibration enabled state
-    if (items[0].bChecked != bCalib);
-        prefs.putUChar("PwrCalibEnabled", items[0].bChecked ? 1 : 0);
-
-    // system mass
-    float mass2 = atof(items[1].value);
-    if ( mass != mass2 && mass2 > 50.0 && mass2 < 200.0 )
-        prefs.putFloat("Sp_mass", mass2);
-
-    // cR
-    float cR2 = atof(items[2].value);
-    if ( cR2 != cR && cR2 < 1.0 && cR2 > 0.0001 )
-        prefs.putFloat("Sp_cR", cR2);
-
-    // cwA
-    float cwA2 = atof(items[3].value);
-    if (cwA2 != cwA && cwA2 < 1.0 && cwA2 > 0.1)
-        prefs.putFloat("Sp_cwA", cwA2);
 }
 
-void M5ConfigForms::OnCmdScreen(Preferences& prefs)
+void M5ConfigForms::setItems(stPage& pg, const stItem* pItems, int nItems)
 {
-    int cmd = 0;
-
-    stItem items[3] =
+    pg.nItems = min(nItems, (int)MAX_ITEMS);
+    for (int i = 0; i < pg.nItems; i++)
     {
-        { 1, NUMINPUT, false, "Backlight timeout", NULL, 0 },
-        { 2, CHECKBOX, false, "Backlight on while charging", NULL, 0 },
-        { 0, BUTTON,   false, "Back", NULL, 0 },
-    };
-
-    // backlight timeout
-    char blTo[10];
-    uint16_t to = prefs.getUShort( "BacklightTo", 60 );
-    snprintf(blTo, sizeof( blTo), "%d", to );
-    items[0].value = blTo;
-    items[0].lenValue = sizeof( blTo );
-
-    // backlight on charging
-    bool blChg = items[1].bChecked = prefs.getUChar("BacklightChg", 1) ? true : false;
+        pg.items[i] = pItems[i];
+        pg.values[i][0] = '\0';
+        pg.items[i].value = pg.values[i];
+        pg.items[i].lenValue = LEN_VALUE;
+    }
+}
 
-    while ((cmd = PageCheckMenu(items, N_ELE(items))) != 0)
+// page items with current settings
+void M5ConfigForms::initPage(stPage& pg)
+{
+    Settings& settings = *m_pSettings;
+    switch (pg.page)
     {
-        ;
+    case PAGE_MAIN:
+    {
+        static const stItem items[5] =
+        {
+            { 1, CHECKBOX, false, "Bluetooth on", NULL, 0 },
+            { 2, BUTTON,   false, "Log file format", NULL, 0 },
+            { 3, BUTTON,   false, "Power & Range", NULL, 0 },
+            { 4, BUTTON,   false, "More...", NULL, 0 },
+            { 0, BUTTON,   false, "Back", NULL, 0 },
+        };
+        setItems(pg, items, N_ELE(items));
+
+        // bluetooth enabled
+        pg.items[0].bChecked = settings.GetBool( Settings::BT_ENABLED );
+        break;
+    }
+    case PAGE_LOGGING:
+    {
+        static const stItem items[6] =
+        {
+            // { FileLogger::SIMPLE,     RADIO,  false, "Text (complete)", NULL, 0 },
+            { FileLogger::CSV_SIMPLE,        RADIO,  false, "CSV (complete)", NULL, 0 },
+            { FileLogger::CSV_KNOWN,         RADIO,  false, "CSV (known data only)", NULL, 0 },
+            { FileLogger::CSV_KNOWNCHANGED,  RADIO,  false, "CSV (changed & known)", NULL, 0 },
+            { FileLogger::CSV_TABLE,         RADIO,  false, "CSV all values per line", NULL, 0 },
+            { FileLogger::BIN_DELTA,         RADIO,  false, "Binary (compact)", NULL, 0 },
+            { 0,                             BUTTON, false, "Back", NULL, 0 },
+        };
+        setItems(pg, items, N_ELE(items));
+
+        // get stored format
+        uint8_t logFormat = settings.GetUInt( Settings::LOG_FORMAT );
+        if( logFormat >= FileLogger::NUM_FORMATS || logFormat == FileLogger::NONE )
+            logFormat = FileLogger::CSV_SIMPLE;
+
+        Serial.printf("Log format from preferences: %d\r\n", logFormat);
+
+        // check item (cmdId coresponds to log format constant)
+        for (int i = 0; i < pg.nItems; i++)
+        {
+            if (pg.items[i].cmdId == logFormat )
+            {
+                pg.items[ i ].bChecked = true;
+                break;
+            }
+        }
+        break;
+    }
+    case PAGE_POWER:
+    {
+        static const stItem items[6] =
+        {
+            { 1, CHECKBOX, false, "Enable calibration", NULL, 0 },
+            { 2, NUMINPUT, false, "System mass (kg)", NULL, 0 },
+            { 3, NUMINPUT, false, "Roll resist", NULL, 0 },
+            { 4, NUMINPUT, false, "Air resist", NULL, 0 },
+            { 5, BUTTON,   false, "More...", NULL, 0 },
+            { 0, BUTTON,   false, "Back", NULL, 0 },
+        };
+        setItems(pg, items, N_ELE(items));
+
+        pg.items[0].bChecked = settings.GetBool(Settings::PWR_CALIB_ENABLED);
+        dtostrf(settings.GetFloat(Settings::SP_MASS), 3, 0, pg.values[1]);
+        dtostrf(settings.GetFloat(Settings::SP_CR), 9, 7, pg.values[2]);
+        dtostrf(settings.GetFloat(Settings::SP_CWA), 9, 7, pg.values[3]);
+        break;
+    }
+    case PAGE_POWERMORE:
+    {
+        static const stItem items[6] =
+        {
+            { 1, NUMINPUT, false, "# of calibration runs", NULL, 0 },
+            { 2, NUMINPUT, false, "Average rider power",   NULL, 0 },
+            { 3, NUMINPUT, false, "Default air temp",      NULL, 0 },
+            { 4, NUMINPUT, false, "Default altitude",      NULL, 0 },
+            { 5, BUTTON,   false, "Plan route.gpx",        NULL, 0 },
+            { 0, BUTTON,   false, "Back",                  NULL, 0 },
+        };
+        setItems(pg, items, N_ELE(items));
+
+        snprintf(pg.values[0], LEN_VALUE, "%d", settings.GetUInt(Settings::SP_NRUNS));
+        dtostrf(settings.GetFloat(Settings::SP_AVG_RDPOWER), 3, 0, pg.values[1]);
+        dtostrf(settings.GetFloat(Settings::SP_DEF_AIRTEMP), 3, 1, pg.values[2]);
+        dtostrf(settings.GetFloat(Settings::SP_DEF_ALT), 4, 0, pg.values[3]);
+        break;
+    }
+    case PAGE_MORE:
+    {
+        static const stItem items[5] =
+        {
+            { 1, BUTTON, false, "Bluetooth Pin", NULL, 0 },
+            { 2, BUTTON, false, "Altimeter", NULL, 0 },
+            { 3, BUTTON, false, "Screen", NULL, 0 },
+            { 4, BUTTON, false, "More...", NULL, 0 },
+            { 0, BUTTON, false, "Back", NULL, 0 },
+        };
+        setItems(pg, items, N_ELE(items));
+        break;
+    }
+    case PAGE_MORE2:
+    {
+        static const stItem items[3] =
+        {
+            { 1, BUTTON, false, "Set clock/Wifi", NULL, 0 },
+            { 2, BUTTON, false, "Clear settings", NULL, 0 },
+            { 0, BUTTON, false, "Back", NULL, 0 },
+        };
+        setItems(pg, items, N_ELE(items));
+        break;
+    }
+    case PAGE_SCREEN:
+    {
+        static const stItem items[3] =
+        {
+            { 1, NUMINPUT, false, "Backlight timeout", NULL, 0 },
+            { 2, CHECKBOX, false, "Backlight on while charging", NULL, 0 },
+            { 0, BUTTON,   false, "Back", NULL, 0 },
+        };
+        setItems(pg, items, N_ELE(items));
+
+        snprintf(pg.values[0], LEN_VALUE, "%d", settings.GetUInt(Settings::BACKLIGHT_TO));
+        pg.items[1].bChecked = settings.GetBool(Settings::BACKLIGHT_CHG);
+        break;
     }
-
-    // backlight timeout
-    uint16_t to2 = atoi( items[0].value );
-    if( to != to2 )
-    { 
-        if( to2 > 3600 ) to2 = 3600;
-        if( to2 < 10 ) to2 = 10;
-        prefs.putUShort("BacklightTo", to2 );
     }
-
-    // backlight on charging
-    if( items[1].bChecked != blChg )
-        prefs.putUChar("BacklightChg", items[1].bChecked ? 1 : 0 );
 }
 
-void M5ConfigForms::OnCmdLogging(Preferences& prefs)
+// write changed and valid page values to settings
+void M5ConfigForms::exitPage(stPage& pg)
 {
-    int i;
-    stItem items[5] =
+    Settings& settings = *m_pSettings;
+    stItem* items = pg.items;
+    switch (pg.page)
     {
-        // { FileLogger::SIMPLE,     RADIO,  false, "Text (complete)", NULL, 0 },
-        { FileLogger::CSV_SIMPLE,        RADIO,  false, "CSV (complete)", NULL, 0 },
-        { FileLogger::CSV_KNOWN,         RADIO,  false, "CSV (known data only)", NULL, 0 },
-        { FileLogger::CSV_KNOWNCHANGED,  RADIO,  false, "CSV (changed & known)", NULL, 0 },
-        { FileLogger::CSV_TABLE,         RADIO,  false, "CSV all values per line", NULL, 0 },
-        { 0,                             BUTTON, false, "Back", NULL, 0 },
-    };
-
-    // get stored format
-    uint8_t logFormat = prefs.getUChar( "LogFormat" );
-    if( logFormat >= FileLogger::NUM_FORMATS || logFormat == FileLogger::NONE )
-        logFormat = FileLogger::CSV_SIMPLE;
-
-    Serial.printf("Log format from preferences: %d\r\n", logFormat);
-
-    // check item (cmdId coresponds to log format constant)
-    for (i = 0; i < N_ELE(items); i++)
+    case PAGE_MAIN:
+        // write  bluetooth enabled state
+        if( items[0].bChecked != settings.GetBool( Settings::BT_ENABLED ) )
+            settings.SetBool(Settings::BT_ENABLED, items[0].bChecked );
+        break;
+    case PAGE_LOGGING:
     {
-        if (items[i].cmdId == logFormat )
+        // write checked item to preferences
+        uint8_t logFormat = settings.GetUInt( Settings::LOG_FORMAT );
+        for( int i = 0; i < pg.nItems; i++ )
         {
-            items[ i ].bChecked = true;
-            break;
+            if( items[i].bChecked && logFormat != items[i].cmdId )
+            {
+                settings.SetUInt(Settings::LOG_FORMAT, items[i].cmdId );
+                break;
+            }
         }
+        break;
     }
-
-    // show radio buttons
-    PageCheckMenu(items, N_ELE(items));
-
-    // write checked item to preferences
-    for( i = 0; i < N_ELE(items); i++ )
+    case PAGE_POWER:
     {
-        if( items[i].bChecked && logFormat != items[i].cmdId )
+        // write power calibration enabled state
+        if (items[0].bChecked != settings.GetBool(Settings::PWR_CALIB_ENABLED))
+            settings.SetBool(Settings::PWR_CALIB_ENABLED, items[0].bChecked);
+
+        // system mass
+        float mass2 = atof(items[1].value);
+        if ( settings.GetFloat(Settings::SP_MASS) != mass2 && mass2 > 50.0 && mass2 < 200.0 )
+            settings.SetFloat(Settings::SP_MASS, mass2);
+
+        // cR
+        float cR2 = atof(items[2].value);
+        if ( cR2 != settings.GetFloat(Settings::SP_CR) && cR2 < 1.0 && cR2 > 0.0001 )
+            settings.SetFloat(Settings::SP_CR, cR2);
+
+        // cwA
+        float cwA2 = atof(items[3].value);
+        if (cwA2 != settings.GetFloat(Settings::SP_CWA) && cwA2 < 1.0 && cwA2 > 0.1)
+            settings.SetFloat(Settings::SP_CWA, cwA2);
+        break;
+    }
+    case PAGE_POWERMORE:
+    {
+        // number of calibration runs
+        uint8_t nRuns2 = atoi(items[0].value);
+        if (settings.GetUInt(Settings::SP_NRUNS) != nRuns2 && nRuns2 > 0 && nRuns2 < 16)
+            settings.SetUInt(Settings::SP_NRUNS, nRuns2);
+
+        // avgRiderPower
+        float avgRiderPower2 = atof(items[1].value);
+        if (settings.GetFloat(Settings::SP_AVG_RDPOWER) != avgRiderPower2 && avgRiderPower2 > 10.0 && avgRiderPower2 < 400.0)
+            settings.SetFloat(Settings::SP_AVG_RDPOWER, avgRiderPower2);
+
+        // default air temp
+        float defaultAirTemp2 = atof(items[2].value);
+        if (settings.GetFloat(Settings::SP_DEF_AIRTEMP) != defaultAirTemp2 && defaultAirTemp2 > -20.0 && defaultAirTemp2 < 40.0)
+            settings.SetFloat(Settings::SP_DEF_AIRTEMP, defaultAirTemp2);
+
+        // default altitude
+        float defaultAltitude2 = atof(items[3].value);
+        if (settings.GetFloat(Settings::SP_DEF_ALT) != defaultAltitude2 && defaultAltitude2 > 0.0 && defaultAltitude2 < 5000.0)
+            settings.SetFloat(Settings::SP_DEF_ALT, defaultAltitude2);
+        break;
+    }
+    case PAGE_SCREEN:
+    {
+        // backlight timeout
+        uint16_t to2 = atoi( items[0].value );
+        if( settings.GetUInt( Settings::BACKLIGHT_TO ) != to2 )
         {
-            prefs.putUChar("LogFormat", items[i].cmdId );
-            break;
+            if( to2 > 3600 ) to2 = 3600;
+            if( to2 < 10 ) to2 = 10;
+            settings.SetUInt(Settings::BACKLIGHT_TO, to2 );
         }
+
+        // backlight on charging
+        if( items[1].bChecked != settings.GetBool(Settings::BACKLIGHT_CHG) )
+            settings.SetBool(Settings::BACKLIGHT_CHG, items[1].bChecked );
+        break;
+    }
+    default:
+        break;
     }
 }
 
-// altimeter calibration
-void M5ConfigForms::OnCmdAltimeter(Preferences& prefs)
+// energy prediction for /route.gpx, calculated in steps from Update(), result to SD
+void M5ConfigForms::OnCmdPlanRoute()
 {
-    // wait till there is no touch anymore
-    while (M5.Touch.ispressed())
-        M5.update();
+    if (!m_pPower)
+        return;
 
-    if (!AltimeterBMP280::CanCalculateSealevel())
+    m_pPower->GetRouteParams(m_routeParams);
+    m_pPlanner     = new RoutePlanner;
+    m_pRouteResult = new RoutePlanner::stResult;
+    if (!m_pPlanner->Begin("/route.gpx", m_routeParams, *m_pRouteResult))
     {
-        MsgBox( "No altimeter hardware found!" );
+        delete m_pPlanner;
+        delete m_pRouteResult;
+        m_pPlanner     = NULL;
+        m_pRouteResult = NULL;
+        openMsgBox("Can't read route.gpx!");
         return;
     }
+    openMsgBox("Calculating route...", M5MsgBox::NOBUTTON);
+    m_dialog = DLG_ROUTE;
+}
 
-    String str = "";
-    M5Keyboard keyb;
-    bool ret = keyb.Show(str, "Enter current altitude (m):", M5Keyboard::KEY_MODE_NUMERIC);
-    Serial.println(str);
-    if (ret)
+void M5ConfigForms::routeStep()
+{
+    if (m_pPlanner->Step(ROUTE_STEP_MS))
+        return;
+
+    const RoutePlanner::stResult& r = *m_pRouteResult;
+    if (r.nSegments > 0)
     {
-        uint32_t altitude = atol(str.c_str());
-        if (altitude)
-        {
-            float sealevelhPa = AltimeterBMP280::GetCurrentSealevelhPa((float)altitude);
-            if(sealevelhPa != 0.0 )
-            {
-                prefs.putFloat("SealevelhPa", sealevelhPa);
-                Serial.printf("SealevelPressure (hPa): %f\r\n", sealevelhPa);
-            }
-        }
+        m_pPlanner->WriteResultSD("/route.txt", r);
+        char msg[64];
+        if (r.bBatteryEmpty)
+            snprintf(msg, sizeof(msg), "%.0f km, %.0f Wh, empty at %.0f km", r.distance, r.energyWh, r.emptyDistance);
+        else
+            snprintf(msg, sizeof(msg), "%.0f km, %.0f Wh, range %.0f km", r.distance, r.energyWh, r.range);
+        openMsgBox(msg);
     }
+    else
+        openMsgBox("No track points in route.gpx!");
+
+    delete m_pPlanner;
+    delete m_pRouteResult;
+    m_pPlanner     = NULL;
+    m_pRouteResult = NULL;
 }
 
-// command handler for 2nd more menu buttons
-void M5ConfigForms::OnCmdMore2(Preferences& prefs)
+// altimeter calibration
+void M5ConfigForms::OnCmdAltimeter()
 {
-    int cmd = 0;
+    if (!AltimeterBMP280::CanCalculateSealevel())
+        openMsgBox( "No altimeter hardware found!" );
+    else
+        openKeyboard("Enter current altitude (m):", M5Keyboard::KEY_MODE_NUMERIC, ACT_ALTIMETER);
+}
 
-    stItem items[3] =
+// set RTC from NTP server (Wifi internet connection)
+void M5ConfigForms::wifiStart()
+{
+    // read preferences for ssid and pwd
+    Preferences& prefs = m_pSettings->GetPrefs();
+    m_ssid = prefs.getString("SSID");
+    m_pwd = "";
+    if( !m_ssid.isEmpty())
+        m_pwd = prefs.getString( "WifiPwd" );
+    m_bPwdChanged = false;
+    wifiSelect();
+}
+
+// if there is no ssid and pwd, select it
+void M5ConfigForms::wifiSelect()
+{
+    if (m_pwd.isEmpty())
     {
-        { 1, BUTTON, false, "Set clock/Wifi", NULL, 0 },
-        { 2, BUTTON, false, "Clear settings", NULL, 0 },
-        { 0, BUTTON, false, "Back", NULL, 0 },
-    };
+        releaseButtons();
+        m_ssid = "";
+        m_wifiForm.Open();
+        m_dialog = DLG_WIFISCAN;
+    }
+    else
+        wifiCheckCredentials();
+}
 
-    while ((cmd = PageCheckMenu(items, N_ELE(items))) != 0)
+void M5ConfigForms::wifiSelected(bool bSelected)
+{
+    if (bSelected && !m_ssid.isEmpty())
     {
-        // Serial.println(cmd);
-        switch (cmd)
+        m_pwd = m_pSettings->GetPrefs().getString("WifiPwd");
+        if (!m_pwd.isEmpty())
         {
-        case 1: OnCmdClockWifi(prefs); break;
-        case 2: OnCmdClearAll(prefs);  break;
+            openMsgBox("Use stored password?", M5MsgBox::YESNO, ACT_WIFI_STOREDPWD);
+            return;
         }
+        openKeyboard("Enter Wifi password:", M5Keyboard::KEY_MODE_LETTER, ACT_WIFI_PWD);
+        return;
     }
+    wifiCheckCredentials();
 }
 
-// command handler for more menu buttons
-void M5ConfigForms::OnCmdMore(Preferences& prefs)
+void M5ConfigForms::wifiCheckCredentials()
 {
-    int cmd = 0;
+    // credentials missing
+    if (m_ssid.isEmpty() || m_pwd.isEmpty())
+        openMsgBox("No credentials. Retry?", M5MsgBox::YESNO, ACT_WIFI_RETRY);
+    else
+        openMsgBox( "Start testing Wifi connection", M5MsgBox::CONFIRM, ACT_WIFI_TEST);
+}
 
-    stItem items[5] =
-    {
-        { 1, BUTTON, false, "Bluetooth Pin", NULL, 0 },
-        { 2, BUTTON, false, "Altimeter", NULL, 0 },
-        { 3, BUTTON, false, "Screen", NULL, 0 },
-        { 4, BUTTON, false, "More...", NULL, 0 },
-        { 0, BUTTON, false, "Back", NULL, 0 },
-    };
+// now we can test
+void M5ConfigForms::wifiConnect()
+{
+    Serial.println("Testing wifi");
+    openMsgBox("Connecting Wifi...", M5MsgBox::NOBUTTON);
+    WiFi.begin(m_ssid.c_str(), m_pwd.c_str());
+    m_tiWifiTimeout = (uint32_t)SysClock::Millis() + 10000L;
+    m_dialog = DLG_WIFICONNECT;
+}
 
-    while ((cmd = PageCheckMenu( items, N_ELE( items ))) != 0)
+void M5ConfigForms::wifiPollConnect(uint32_t timestamp)
+{
+    if (WiFi.status() == WL_CONNECTED)
     {
-        // Serial.println(cmd);
-        switch (cmd)
-        {
-        case 1: OnCmdBtPin(prefs);     break;
-        case 2: OnCmdAltimeter(prefs); break;
-        case 3: OnCmdScreen(prefs);    break;
-        case 4: OnCmdMore2(prefs);     break;
-        }
+        m_dialog = DLG_NONE;
+        wifiConnected();
     }
+    else if (SysClock::IsDue(timestamp, m_tiWifiTimeout))
+        openMsgBox("Failed! Select another one?", M5MsgBox::YESNO, ACT_WIFI_FAILED);
 }
 
-// entry point and command handler for menu buttons
-void M5ConfigForms::ShowMenu(Preferences& prefs)
+// connected, write prefs
+void M5ConfigForms::wifiConnected()
 {
-    int cmd = 0;
-
-    stItem items[5] =
-    {
-        { 1, CHECKBOX, false, "Bluetooth on", NULL, 0 },
-        { 2, BUTTON,   false, "Log file format", NULL, 0 },
-        { 3, BUTTON,   false, "Power & Range", NULL, 0 },
-        { 4, BUTTON,   false, "More...", NULL, 0 },
-        { 0, BUTTON,   false, "Back", NULL, 0 },
-    };
+    m_pSettings->GetPrefs().putString("SSID", m_ssid);
+    if (m_bPwdChanged)
+        openMsgBox("Store Wifi Pwd?", M5MsgBox::YESNO, ACT_WIFI_STOREPWD);
+    else
+        wifiSetTime();
+}
 
-    // bluetooth enabled
-    bool bBtEnabled = items[0].bChecked = prefs.getUChar( "BtEnabled", 1 ) ? true : false;
+// finally set time, NTP request blocks for a moment
+void M5ConfigForms::wifiSetTime()
+{
+    Serial.println("Set NTP time");
 
-    while ((cmd = PageCheckMenu(items, N_ELE(items))) != 0)
+    M5NTPTime NtpTime;
+    if( NtpTime.SetTime(m_ssid.c_str(), m_pwd.c_str() ) )
     {
-        // Serial.println(cmd);
-        switch (cmd)
-        {
-        case 2: OnCmdLogging(prefs);     break;
-        case 3: OnCmdPower(prefs);       break;
-        case 4: OnCmdMore( prefs );      break;
-        }
+        SysClock::Sync(); // cached wall clock from new RTC time
+        openMsgBox( "Internet time set!" );
     }
-
-    // write  bluetooth enabled state
-    if( items[0].bChecked != bBtEnabled );
-        prefs.putUChar("BtEnabled", items[0].bChecked ? 1 : 0 );
+    else
+        openMsgBox("Error setting time!");
 }
@@ -4,39 +4,39 @@
  *
  *  Configuration forms for settings
  *
+ *  Non-blocking: Open() shows the main menu, Update() is called from the
+ *  main loop and polls the buttons of the current page or dialog. Sub pages
+ *  are kept on a page stack, keyboard and message boxes are dialogs with an
+ *  action that handles their result.
+ *
 */
 
 #ifndef M5CONFIG_FORMS_H
 #define M5CONFIG_FORMS_H
 
 #include <M5Core2.h>
-#include <Preferences.h>
+#include "Settings.h"
+#include "M5MsgBox.h"
+#include "M5Keyboard.h"
+#include "M5ConfigFormWifi.h"
+#include "RoutePlanner.h"
+
+class PowerUtil;
 
 class M5ConfigForms
 {
 public:
-    typedef enum
-    {
-        CONFIRM = 0,
-        OKCANCEL,
-        YESNO,
-    } enMsgBoxButtons;
-
-    typedef enum
-    {
-        RET_OK = 0,
-        RET_CANCEL,
-        RET_YES,
-        RET_NO,
-    } enMsgBoxReturn;
+    M5ConfigForms(PowerUtil* pPower = NULL) : m_pPower(pPower) {}
 
     // main entry point for config menues
-    void ShowMenu(Preferences & prefs);
-
-    // Message box
-    static enMsgBoxReturn MsgBox(const char* msg, enMsgBoxButtons type = CONFIRM);
+    void Open(Settings& settings);
+    bool Update(uint32_t timestamp); // false: menu closed
+    bool IsOpen() { return m_depth > 0; }
 
 protected:
+    PowerUtil* m_pPower; // for route planning
+    Settings*  m_pSettings = NULL;
+
     static ButtonColors on_clrs;
     static ButtonColors off_clrs;
 
@@ -61,21 +61,116 @@ protected:
     } stItem;
     #define N_ELE(a) (sizeof(a)/sizeof( stItem ))
 
-    int PageCheckMenu(stItem* pItems, int nItems);
+    // menu pages
+    typedef enum
+    {
+        PAGE_MAIN = 0,
+        PAGE_LOGGING,
+        PAGE_POWER,
+        PAGE_POWERMORE,
+        PAGE_MORE,
+        PAGE_MORE2,
+        PAGE_SCREEN,
+    } enPage;
+
+    enum
+    {
+        MAX_ITEMS = 6,
+        MAX_DEPTH = 4,
+        LEN_VALUE = 12,
+    };
+
+    typedef struct
+    {
+        enPage page;
+        int    nItems;
+        stItem items[MAX_ITEMS];
+        char   values[MAX_ITEMS][LEN_VALUE];
+    } stPage;
+
+    stPage   m_pages[MAX_DEPTH];
+    int      m_depth = 0;
+    Button*  m_pButtons[MAX_ITEMS] = { NULL, NULL, NULL, NULL, NULL, NULL };
+    bool     m_bPageShown   = false;
+    bool     m_bWaitRelease = false;
+
+    // dialog on top of the page and what to do with its result
+    typedef enum
+    {
+        DLG_NONE = 0,
+        DLG_MSGBOX,
+        DLG_KEYBOARD,
+        DLG_WIFISCAN,
+        DLG_WIFICONNECT,
+        DLG_ROUTE,
+    } enDialog;
+
+    typedef enum
+    {
+        ACT_NONE = 0,
+        ACT_EDITITEM,
+        ACT_BTPIN,
+        ACT_CLEARALL,
+        ACT_ALTIMETER,
+        ACT_WIFI_STOREDPWD,
+        ACT_WIFI_PWD,
+        ACT_WIFI_RETRY,
+        ACT_WIFI_TEST,
+        ACT_WIFI_FAILED,
+        ACT_WIFI_STOREPWD,
+    } enAction;
+
+    enDialog         m_dialog   = DLG_NONE;
+    enAction         m_action   = ACT_NONE;
+    int              m_editItem = 0;
+    M5MsgBox         m_msgBox;
+    M5Keyboard       m_keyboard;
+    M5ConfigFormWifi m_wifiForm;
+
+    // clock/wifi credentials
+    String   m_ssid;
+    String   m_pwd;
+    bool     m_bPwdChanged  = false;
+    uint32_t m_tiWifiTimeout = 0;
+
+    // route planning in time slices, planner holds read buffer and segment blocks
+    enum { ROUTE_STEP_MS = 10 };
+    RoutePlanner*           m_pPlanner = NULL;
+    RoutePlanner::stParams  m_routeParams;
+    RoutePlanner::stResult* m_pRouteResult = NULL;
+
+    // pages
+    void pushPage(enPage page);
+    void popPage();
+    void showPage();
+    void releaseButtons();
+    void updatePage();
+    void setItems(stPage& pg, const stItem* pItems, int nItems);
+    void initPage(stPage& pg);
+    void exitPage(stPage& pg);
+    void onCommand(enPage page, int cmd);
     void CheckButtons( int nPressed, stItem* pItems, int nItems, Button * pButtons[] );
 
-    // subPages
-    void OnCmdLogging(Preferences& prefs);
-    void OnCmdMore(Preferences& prefs);
-    void OnCmdMore2(Preferences& prefs);
-    void OnCmdPowerMore(Preferences& prefs);
-
-    void OnCmdBtPin(Preferences& prefs);
-    void OnCmdClockWifi(Preferences& prefs);
-    void OnCmdScreen(Preferences& prefs);
-    void OnCmdClearAll(Preferences& prefs);
-    void OnCmdAltimeter(Preferences& prefs);
-    void OnCmdPower(Preferences& prefs);
+    // dialogs
+    void openMsgBox(const char* msg, M5MsgBox::enMsgBoxButtons type = M5MsgBox::CONFIRM, enAction action = ACT_NONE);
+    void openKeyboard(const char* title, M5Keyboard::key_mode_t keyMode, enAction action);
+    void onMsgBoxDone(M5MsgBox::enMsgBoxReturn ret);
+    void onKeyboardDone(bool bOk, const String& text);
+
+    // commands
+    void OnCmdPlanRoute();
+    void routeStep();
+    void OnCmdAltimeter();
+
+    // set clock by NTP
+    void wifiStart();
+    void wifiSelect();
+    void wifiSelected(bool bSelected);
+    void wifiCheckCredentials();
+    void wifiConnect();
+    void wifiPollConnect(uint32_t timestamp);
+    void wifiConnected();
+    void wifiSetTime();
 };
 
-#endif // M5CONFIG_FORMS_H
\ No newline at end of file
+#endif // M5CONFIG_FORMS_H
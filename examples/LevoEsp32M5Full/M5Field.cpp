@@ -10,46 +10,123 @@
 
 #include "M5Field.h"
 
-void M5Field::printSpecialChar(const char* pStr)
+#ifdef M5FIELD_SPRITE
+// one sprite per field size, shared by all fields of that size
+TFT_eSprite* M5Field::getSprite()
 {
-    // degree symbol
-    if (pStr[0] == 'o')
+    if (m_bSpriteFailed)
+        return NULL;
+    if (m_pSprite == NULL)
     {
-        M5.Lcd.setTextSize(1);
-        M5.Lcd.setCursor(M5.Lcd.getCursorX(), M5.Lcd.getCursorY() - 2 );
-        M5.Lcd.print( "o" );
+        m_pSprite = new TFT_eSprite(&M5.Lcd);
+        m_pSprite->setColorDepth(16);
+        if (m_pSprite->createSprite(GetMetrics().rcBoundWidth - 2, GetMetrics().txtHeightVal) == NULL)
+        {
+            Serial.printf("M5Field: no memory for %dx%d sprite, drawing directly\n", GetMetrics().rcBoundWidth - 2, GetMetrics().txtHeightVal);
+            m_bSpriteFailed = true;
+            return NULL;
+        }
     }
-    else
-        M5.Lcd.print( pStr );
+    return m_pSprite;
 }
+#endif
+
+// value glyphs per style, shared by all fields
+static M5GlyphAtlas s_atlas[2];
+static bool s_bUseAtlas = true;
 
-void M5Field::RenderValue(char * strVal, int orgPointX, int orgPointY, const DisplayData::stDisplayData* pDesc, enStyle style)
+void M5Field::SetUseAtlas(bool bUseAtlas)
 {
-    // delete background
-    int cx = GetMetrics().rcBoundWidth - 2;
-    M5.Lcd.fillRect(orgPointX + 1, orgPointY + GetMetrics().txtHeightLabel + 7, cx, GetMetrics().txtHeightVal, BLACK);
+    s_bUseAtlas = bUseAtlas;
+}
 
-    // print value
-    M5.Lcd.setTextFont(1);
-    M5.Lcd.setTextSize(2);
-    M5.Lcd.setTextColor( (style == NORMAL) ? GetColors().colValue : GetColors().colUnit );
-    M5.Lcd.setCursor(orgPointX + 3, orgPointY + GetMetrics().txtHeightLabel + 7);
-    M5.Lcd.print(strVal);
+M5Field::stUnit M5Field::ParseUnit(const char* strUnit)
+{
+    stUnit unit = { strUnit, UNIT_NORMAL };
+    if (strUnit[0] == '&')
+    {
+        unit.pText++;
+        if (unit.pText[0] == 'o')
+            unit.type = UNIT_DEGREE;
+    }
+    else if (strUnit[0] == '^')
+    {
+        unit.pText++;
+        unit.type = UNIT_SMALL;
+    }
+    return unit;
+}
+
+// chars first..last of a value, x/y is the top left corner of the value text
+void M5Field::drawGlyphs(TFT_eSPI& gfx, const char* strVal, int first, int last, int x, int y, enStyle style)
+{
+    M5GlyphAtlas& atlas = s_atlas[style == NORMAL ? 0 : 1];
+    if (s_bUseAtlas && !atlas.IsValid())
+        atlas.Init((style == NORMAL) ? GetColors().colValue : GetColors().colUnit, BLACK);
 
-    // print label
-    M5.Lcd.setCursor(M5.Lcd.getCursorX() + 4, M5.Lcd.getCursorY());
-    M5.Lcd.setTextColor(GetColors().colUnit);
-    if (pDesc->strUnit[0] == '&')
+    bool bFont = false;
+    for (int i = first; i <= last; i++)
     {
-        printSpecialChar( (pDesc->strUnit + 1 ) );
+        uint16_t* pGlyph = s_bUseAtlas ? atlas.Get(strVal[i]) : NULL;
+        if (pGlyph)
+        {
+            gfx.pushImage(x + i * VAL_CHAR_WIDTH, y, M5GlyphAtlas::CHAR_W, M5GlyphAtlas::CHAR_H, pGlyph);
+            continue;
+        }
+
+        // not in atlas
+        if (!bFont)
+        {
+            gfx.setTextFont(1);
+            gfx.setTextSize(2);
+            gfx.setTextColor( (style == NORMAL) ? GetColors().colValue : GetColors().colUnit, BLACK );
+            bFont = true;
+        }
+        gfx.setCursor(x + i * VAL_CHAR_WIDTH, y);
+        gfx.print(strVal[i]);
     }
-    else if(pDesc->strUnit[0] == '^')
+}
+
+// unit behind the value, only drawn when the value length changes
+void M5Field::drawUnit(TFT_eSPI& gfx, const stUnit& unit, int x, int y)
+{
+    gfx.setTextFont(1);
+    gfx.setTextColor(GetColors().colUnit);
+    gfx.setTextSize(unit.type == UNIT_NORMAL ? 2 : 1);
+    gfx.setCursor(x, (unit.type == UNIT_DEGREE) ? y - 2 : y);
+    gfx.print(unit.pText);
+}
+
+void M5Field::RenderValue(char * strVal, int orgPointX, int orgPointY, const stUnit& unit, enStyle style)
+{
+    int len = strlen(strVal);
+    int cx = GetMetrics().rcBoundWidth - 2;
+    int cy = GetMetrics().txtHeightVal;
+    int x  = orgPointX + 1;
+    int y  = orgPointY + GetMetrics().txtHeightLabel + 7;
+
+#ifdef M5FIELD_SPRITE
+    TFT_eSprite* pSprite = getSprite();
+    if (pSprite)
     {
-        M5.Lcd.setTextSize(1);
-        M5.Lcd.print(pDesc->strUnit + 1);
+        pSprite->fillRect(0, 0, cx, cy, BLACK);
+        drawGlyphs(*pSprite, strVal, 0, len - 1, VAL_OFFSET_X - 1, 0, style);
+        drawUnit(*pSprite, unit, VAL_OFFSET_X - 1 + len * VAL_CHAR_WIDTH + 4, 0);
+        pSprite->pushSprite(x, y);
+        return;
     }
-    else
-        M5.Lcd.print(pDesc->strUnit);
+#endif
+
+    // delete background
+    M5.Lcd.fillRect(x, y, cx, cy, BLACK);
+    drawGlyphs(M5.Lcd, strVal, 0, len - 1, orgPointX + VAL_OFFSET_X, y, style);
+    drawUnit(M5.Lcd, unit, orgPointX + VAL_OFFSET_X + len * VAL_CHAR_WIDTH + 4, y);
+}
+
+// glyphs with background color overwrite their own cell, no fillRect needed
+void M5Field::RenderValueSpan(const char* strVal, int first, int last, int orgPointX, int orgPointY, enStyle style)
+{
+    drawGlyphs(M5.Lcd, strVal, first, last, orgPointX + VAL_OFFSET_X, orgPointY + GetMetrics().txtHeightLabel + 7, style);
 }
 
 void M5Field::RenderFrame(int orgPointX, int orgPointY, const DisplayData::stDisplayData* pDesc)
@@ -61,7 +138,7 @@ void M5Field::RenderFrame(int orgPointX, int orgPointY, const DisplayData::stDis
     M5.Lcd.setTextColor(GetColors().colLabel);
     M5.Lcd.setTextSize(1);
     M5.Lcd.setCursor(orgPointX + 3, orgPointY + 2 );
-    M5.Lcd.print(String(pDesc->strLabel));
+    M5.Lcd.print(pDesc->strLabel);
 
     // touch button triangle
     /*
@@ -76,3 +153,142 @@ void M5Field::RenderFrame(int orgPointX, int orgPointY, const DisplayData::stDis
         M5.Lcd.drawTriangle( x0, y0, x1, y1, x2, y2, GetColors().colFrame);
     }*/
 }
+
+void M5FieldBig::drawBig(const char* strVal, int orgPointX, int orgPointY, enStyle style)
+{
+    // 7 segment font has no fixed width, background by text padding
+    M5.Lcd.pushState();
+    M5.Lcd.setTextFont(7);
+    M5.Lcd.setTextSize(1);
+    M5.Lcd.setTextDatum(TL_DATUM);
+    M5.Lcd.setTextColor( (style == NORMAL) ? GetColors().colValue : GetColors().colUnit, BLACK );
+    M5.Lcd.setTextPadding(metrics.rcBoundWidth - UNIT_WIDTH - VAL_OFFSET_X);
+    M5.Lcd.drawString(strVal, orgPointX + VAL_OFFSET_X, orgPointY + metrics.txtHeightLabel + 6);
+    M5.Lcd.setTextPadding(0);
+    M5.Lcd.popState();
+}
+
+void M5FieldBig::RenderValue(char* strVal, int orgPointX, int orgPointY, const stUnit& unit, enStyle style)
+{
+    drawBig(strVal, orgPointX, orgPointY, style);
+
+    // unit right aligned
+    M5.Lcd.pushState();
+    M5.Lcd.setTextFont(4);
+    M5.Lcd.setTextSize(1);
+    M5.Lcd.setTextDatum(BR_DATUM);
+    M5.Lcd.setTextColor(GetColors().colUnit, BLACK);
+    M5.Lcd.drawString(unit.pText, orgPointX + metrics.rcBoundWidth - 6, orgPointY + metrics.rcBoundHeight - 6);
+    M5.Lcd.popState();
+}
+
+void M5FieldBig::RenderValueSpan(const char* strVal, int first, int last, int orgPointX, int orgPointY, enStyle style)
+{
+    drawBig(strVal, orgPointX, orgPointY, style);
+}
+
+void M5FieldGraph::RenderValue(char* strVal, int orgPointX, int orgPointY, const stUnit& unit, enStyle style)
+{
+    M5.Lcd.setTextFont(1);
+    M5.Lcd.setTextSize(1);
+    M5.Lcd.setTextColor( (style == NORMAL) ? GetColors().colValue : GetColors().colUnit, BLACK );
+    M5.Lcd.setCursor(orgPointX + TEXT_X, orgPointY + 2);
+    M5.Lcd.print(strVal);
+    M5.Lcd.setTextColor(GetColors().colUnit, BLACK);
+    M5.Lcd.print(" ");
+    M5.Lcd.print(unit.pText);
+}
+
+void M5FieldGraph::RenderValueSpan(const char* strVal, int first, int last, int orgPointX, int orgPointY, enStyle style)
+{
+    M5.Lcd.setTextFont(1);
+    M5.Lcd.setTextSize(1);
+    M5.Lcd.setTextColor( (style == NORMAL) ? GetColors().colValue : GetColors().colUnit, BLACK );
+    M5.Lcd.setCursor(orgPointX + TEXT_X + first * TEXT_WIDTH, orgPointY + 2);
+    for (int i = first; i <= last; i++)
+        M5.Lcd.print(strVal[i]);
+}
+
+void M5FieldGauge::RenderGraph(int orgPointX, int orgPointY, float val, stGraph& graph, bool bFull)
+{
+    int x  = orgPointX + 2;
+    int y  = orgPointY + GRAPH_Y + 2;
+    int cx = GraphWidth() - 2;
+    int cy = GraphHeight() - 4;
+
+    float range = graph.rangeMax - graph.rangeMin;
+    int pos = (range > 0.0f) ? (int)((val - graph.rangeMin) / range * cx) : 0;
+    pos = constrain(pos, 0, cx);
+
+    if (bFull || graph.lastPos < 0)
+    {
+        M5.Lcd.fillRect(x, y, pos, cy, GetColors().colLabel);
+        M5.Lcd.fillRect(x + pos, y, cx - pos, cy, BLACK);
+    }
+    else if (pos > graph.lastPos)
+        M5.Lcd.fillRect(x + graph.lastPos, y, pos - graph.lastPos, cy, GetColors().colLabel);
+    else if (pos < graph.lastPos)
+        M5.Lcd.fillRect(x + pos, y, graph.lastPos - pos, cy, BLACK);
+    graph.lastPos = pos;
+}
+
+int M5FieldChart::sampleHeight(float val, const stGraph& graph)
+{
+    float range = graph.rangeMax - graph.rangeMin;
+    int h = (range > 0.0f) ? (int)((val - graph.rangeMin) / range * GraphHeight() + 0.5f) : 0;
+    return constrain(h, 0, GraphHeight());
+}
+
+void M5FieldChart::drawColumn(TFT_eSprite* pSprite, int x, float val, const stGraph& graph)
+{
+    int h = sampleHeight(val, graph);
+    pSprite->drawFastVLine(x, 0, GraphHeight() - h, BLACK);
+    if (h > 0)
+        pSprite->drawFastVLine(x, GraphHeight() - h, h, GetColors().colLabel);
+}
+
+// new samples scroll the plot area in RAM, only one column is drawn per sample
+void M5FieldChart::RenderGraph(int orgPointX, int orgPointY, float val, stGraph& graph, bool bFull)
+{
+    const ValueHistory* pHistory = graph.pHistory;
+    TFT_eSprite* pSprite = graph.pSprite;
+    if (pHistory == NULL || pSprite == NULL)
+        return;
+
+    uint32_t nNew = pHistory->NumAdded() - graph.nSamples;
+    if (!bFull && nNew == 0)
+        return;
+
+    // auto range grows with the history, full redraw on change
+    if (graph.bAutoRange && pHistory->Count() > 0)
+    {
+        float fMax = pHistory->Max();
+        if (fMax > graph.rangeMax || graph.rangeMax == graph.rangeMin)
+        {
+            graph.rangeMin = 0.0f;
+            graph.rangeMax = max(1.0f, fMax * 1.2f);
+            bFull = true;
+        }
+    }
+
+    int w = GraphWidth();
+    int n = pHistory->Count();
+    if (bFull || nNew >= (uint32_t)w || nNew > (uint32_t)n)
+    {
+        pSprite->fillSprite(BLACK);
+        int first = max(0, n - w);
+        for (int i = first; i < n; i++)
+            drawColumn(pSprite, w - (n - i), pHistory->Get(i), graph);
+    }
+    else
+    {
+        for (int i = n - (int)nNew; i < n; i++)
+        {
+            pSprite->scroll(-1, 0);
+            drawColumn(pSprite, w - 1, pHistory->Get(i), graph);
+        }
+    }
+    graph.nSamples = pHistory->NumAdded();
+
+    pSprite->pushSprite(orgPointX + 1, orgPointY + GRAPH_Y);
+}
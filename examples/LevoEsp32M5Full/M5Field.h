@@ -8,10 +8,15 @@
 
 #include <M5Core2.h>
 #include "DisplayData.h"
+#include "ValueHistory.h"
+#include "M5GlyphAtlas.h"
 
 #ifndef M5_FIELD_H
 #define M5_FIELD_H
 
+// value area is composed in a RAM sprite and written to the LCD in one block (no flicker)
+#define M5FIELD_SPRITE
+
 // for creating 565 colors (uint16_t) directly
 // http://www.barth-dev.de/online/rgb565-color-picker/
 
@@ -51,8 +56,6 @@ protected:
         uint16_t rcBoundHeight;
     };
 
-    void printSpecialChar(const char* pStr);
-
 public:
     typedef enum
     {
@@ -61,13 +64,64 @@ public:
         // ALARM todo
     } enStyle;
 
+    enum
+    {
+        VAL_CHAR_WIDTH = 12, // font 1, size 2: 6x8 cell scaled
+        VAL_OFFSET_X   = 3,
+    };
+
+    // unit text without prefix, parsed once per layout
+    typedef enum
+    {
+        UNIT_NORMAL = 0,
+        UNIT_SMALL,     // "^kph"
+        UNIT_DEGREE,    // "&o"
+    } enUnitType;
+
+    typedef struct
+    {
+        const char* pText;
+        uint8_t     type;
+    } stUnit;
+
+    static stUnit ParseUnit(const char* strUnit);
+
     M5Field() {}
 
-    virtual void RenderValue(char* strVal, int orgPointX, int orgPointY, const DisplayData::stDisplayData* pDesc, enStyle style );
+    virtual void RenderValue(char* strVal, int orgPointX, int orgPointY, const stUnit& unit, enStyle style );
+    virtual void RenderValueSpan(const char* strVal, int first, int last, int orgPointX, int orgPointY, enStyle style ); // chars first..last, unit untouched
     virtual void RenderFrame(int orgPointX, int orgPointY, const DisplayData::stDisplayData* pDesc);
 
     virtual const stMetrics& GetMetrics() = 0;
     virtual const stColors& GetColors() { return colors;  }
+
+    static void SetUseAtlas(bool bUseAtlas); // false: TFT font rendering, for benchmark
+
+    // gauge and chart widgets, state per field is owned by the screen
+    typedef struct
+    {
+        float               rangeMin;
+        float               rangeMax;
+        bool                bAutoRange; // chart: 0..max of history
+        const ValueHistory* pHistory;   // chart only
+        TFT_eSprite*        pSprite;    // chart only: plot area
+        uint32_t            nSamples;   // chart: samples drawn
+        int16_t             lastPos;    // gauge: drawn bar length
+    } stGraph;
+
+    virtual bool IsGraph() { return false; }
+    virtual bool IsChart() { return false; }
+    virtual void RenderGraph(int orgPointX, int orgPointY, float val, stGraph& graph, bool bFull) {}
+
+protected:
+    void drawGlyphs(TFT_eSPI& gfx, const char* strVal, int first, int last, int x, int y, enStyle style);
+    void drawUnit(TFT_eSPI& gfx, const stUnit& unit, int x, int y);
+
+#ifdef M5FIELD_SPRITE
+    TFT_eSprite* m_pSprite = NULL;
+    bool         m_bSpriteFailed = false;
+    TFT_eSprite* getSprite();
+#endif
 };
 
 
@@ -102,4 +156,77 @@ public:
     virtual const stMetrics& GetMetrics() { return metrics; }
 };
 
+
+// value as 7 segment digits over the full screen width
+class M5FieldBig : public M5Field
+{
+protected:
+
+    const stMetrics metrics =
+    {
+        8,                   // uint8_t txtHeightLabel;
+        48,                  // uint8_t txtHeightVal;
+        M5.Lcd.width(),      // uint16_t rcBoundWidth;
+        64,                  // uint16_t rcBoundHeight;
+    };
+    enum { UNIT_WIDTH = 64 };
+    void drawBig(const char* strVal, int orgPointX, int orgPointY, enStyle style);
+
+public:
+    virtual const stMetrics& GetMetrics() { return metrics; }
+    virtual void RenderValue(char* strVal, int orgPointX, int orgPointY, const stUnit& unit, enStyle style);
+    virtual void RenderValueSpan(const char* strVal, int first, int last, int orgPointX, int orgPointY, enStyle style);
+};
+
+
+// label with small value text above a graph, half width
+class M5FieldGraph : public M5Field
+{
+protected:
+
+    const stMetrics metrics =
+    {
+        8,                   // uint8_t txtHeightLabel;
+        8,                   // uint8_t txtHeightVal;
+        M5.Lcd.width() / 2 , // uint16_t rcBoundWidth;
+        38,                  // uint16_t rcBoundHeight;
+    };
+    enum
+    {
+        TEXT_X       = 80,  // value text in label line
+        TEXT_WIDTH   = 6,   // font 1, size 1
+        GRAPH_Y      = 12,  // graph area below label line
+    };
+
+public:
+    virtual const stMetrics& GetMetrics() { return metrics; }
+    virtual void RenderValue(char* strVal, int orgPointX, int orgPointY, const stUnit& unit, enStyle style);
+    virtual void RenderValueSpan(const char* strVal, int first, int last, int orgPointX, int orgPointY, enStyle style);
+    virtual bool IsGraph() { return true; }
+
+    int GraphWidth()  { return metrics.rcBoundWidth - 2; }
+    int GraphHeight() { return metrics.rcBoundHeight - GRAPH_Y - 2; }
+};
+
+
+// horizontal bar, only the changed part of the bar is drawn
+class M5FieldGauge : public M5FieldGraph
+{
+public:
+    virtual void RenderGraph(int orgPointX, int orgPointY, float val, stGraph& graph, bool bFull);
+};
+
+
+// strip chart of the value history, scrolls one column per sample
+class M5FieldChart : public M5FieldGraph
+{
+protected:
+    int  sampleHeight(float val, const stGraph& graph);
+    void drawColumn(TFT_eSprite* pSprite, int x, float val, const stGraph& graph);
+
+public:
+    virtual bool IsChart() { return true; }
+    virtual void RenderGraph(int orgPointX, int orgPointY, float val, stGraph& graph, bool bFull);
+};
+
 #endif // M5_FIELD_H
\ No newline at end of file
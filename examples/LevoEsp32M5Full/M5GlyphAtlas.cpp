@@ -0,0 +1,58 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * Pre-rasterised value glyphs (font 1, size 2) for direct blits
+ *
+ */
+
+#include "M5GlyphAtlas.h"
+
+// all characters of dtostrf() and time values
+const char M5GlyphAtlas::s_chars[] = " 0123456789.-:";
+
+bool M5GlyphAtlas::Init(uint16_t colFg, uint16_t colBg)
+{
+    if (m_pPixels)
+        return true;
+
+    const int nGlyphs = sizeof(s_chars) - 1;
+    uint16_t* pPixels = (uint16_t*)malloc(nGlyphs * GLYPH_PIXELS * sizeof(uint16_t));
+    if (pPixels == NULL)
+        return false;
+
+    // rasterise with the TFT font code into a one char sprite
+    TFT_eSprite sprite(&M5.Lcd);
+    sprite.setColorDepth(16);
+    if (sprite.createSprite(CHAR_W, CHAR_H) == NULL)
+    {
+        free(pPixels);
+        return false;
+    }
+    sprite.setTextFont(1);
+    sprite.setTextSize(2);
+    sprite.setTextColor(colFg, colBg);
+
+    memset(m_index, -1, sizeof(m_index));
+    for (int i = 0; i < nGlyphs; i++)
+    {
+        sprite.fillSprite(colBg);
+        sprite.setCursor(0, 0);
+        sprite.print(s_chars[i]);
+        memcpy(pPixels + i * GLYPH_PIXELS, sprite.getPointer(), GLYPH_PIXELS * sizeof(uint16_t));
+        m_index[(uint8_t)s_chars[i]] = i;
+    }
+    sprite.deleteSprite();
+
+    m_pPixels = pPixels;
+    return true;
+}
+
+uint16_t* M5GlyphAtlas::Get(char c)
+{
+    uint8_t i = (uint8_t)c;
+    if (m_pPixels == NULL || i >= sizeof(m_index) || m_index[i] < 0)
+        return NULL;
+    return m_pPixels + m_index[i] * GLYPH_PIXELS;
+}
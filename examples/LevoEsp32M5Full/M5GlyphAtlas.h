@@ -0,0 +1,39 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * Pre-rasterised value glyphs (font 1, size 2) for direct blits
+ *
+ * Glyphs are rendered once into RAM in LCD byte order, like sprite buffers,
+ * and copied with pushImage() into a sprite or to the LCD. No font lookup,
+ * scaling or per pixel drawing on value updates.
+ *
+ */
+
+#ifndef M5_GLYPHATLAS_H
+#define M5_GLYPHATLAS_H
+
+#include <M5Core2.h>
+
+class M5GlyphAtlas
+{
+public:
+    enum
+    {
+        CHAR_W = 12,
+        CHAR_H = 16,
+        GLYPH_PIXELS = CHAR_W * CHAR_H,
+    };
+
+    bool      Init(uint16_t colFg, uint16_t colBg); // once, about 5 KB
+    bool      IsValid() { return m_pPixels != NULL; }
+    uint16_t* Get(char c);                          // NULL: not in atlas
+
+protected:
+    static const char s_chars[];
+    uint16_t* m_pPixels = NULL; // glyph after glyph
+    int8_t    m_index[128];     // char -> glyph, -1: none
+};
+
+#endif // M5_GLYPHATLAS_H
@@ -2,6 +2,8 @@
 
 #include <M5Core2.h>
 #include "M5Keyboard.h"
+#include "SysClock.h"
+#include "M5ButtonPool.h"
 #include <Free_Fonts.h>
 
 #define OFFSET_INPUT_Y (24)
@@ -60,20 +62,20 @@ String _old_input_text = "";
 M5Keyboard::key_mode_t _key_mode = M5Keyboard::KEY_MODE_LETTER;
 bool _keyboard_done = false;
 bool _keyboard_cancel = false;
+bool _wait_release = false;
 uint32_t _cursor_last;
 bool _cursor_state = false;
 ButtonColors _bc_on = {GREEN, BLACK, COLOR_FRAME};
 ButtonColors _bc_off = {BLACK, GREEN, COLOR_FRAME};
 
-bool M5Keyboard::Show(String& text, const char* title, key_mode_t keyMode )
+void M5Keyboard::Open(const String& text, const char* title, key_mode_t keyMode )
 {
-    // wait till there is no touch anymore
-    while (M5.Touch.ispressed())
-        M5.update();
-
    M5.Lcd.pushState();
    M5.Lcd.clear(TFT_BLACK);
 
+  _keyboard_done = false;
+  _keyboard_cancel = false;
+  _wait_release = true;
   _initKeyboard(text, title, keyMode);
   if( keyMode == KEY_MODE_NUMERIC )
       _drawKeyboardNumeric();
@@ -81,35 +83,40 @@ bool M5Keyboard::Show(String& text, const char* title, key_mode_t keyMode )
       _drawKeyboardNumeric( true );
   else
       _drawKeyboard();
-  _keyboard_done = false;
-  _keyboard_cancel = false;
-  while(_keyboard_done == false && _keyboard_cancel == false)
+}
+
+M5Keyboard::kb_result_t M5Keyboard::Update()
+{
+  // touch that opened the keyboard, OK or Cancel still pressed
+  if (_wait_release || _keyboard_done || _keyboard_cancel)
   {
-    M5.update();
+    if (M5.Touch.ispressed())
+      return KB_RUNNING;
+    _wait_release = false;
+  }
 
+  if(_keyboard_done == false && _keyboard_cancel == false)
+  {
     // Blinking cursor
-    if(millis() > _cursor_last)
+    if(SysClock::IsDue((uint32_t)SysClock::Millis(), _cursor_last))
     {
-      _cursor_last = millis() + 500;
+      _cursor_last = (uint32_t)SysClock::Millis() + 500;
       _cursor_state = !_cursor_state;
       _updateInputText();
     }
+    return KB_RUNNING;
   }
-  while(M5.BtnB.isPressed())
-  {
-    M5.update();
-  }
-  while (M5.BtnC.isPressed())
-  {
-      M5.update();
-  }
-  _deinitKeyboard();
-  text = _input_text;
 
+  _deinitKeyboard();
   M5.Lcd.clear(TFT_BLACK);
   M5.Lcd.popState();
 
-  return _keyboard_done ? true : false;
+  return _keyboard_done ? KB_DONE : KB_CANCEL;
+}
+
+const String& M5Keyboard::GetText()
+{
+  return _input_text;
 }
 
 void M5Keyboard::_updateInputText()
@@ -170,7 +177,12 @@ void M5Keyboard::_initKeyboard(String text, const char * title, key_mode_t keyMo
   {
     for(int c = 0; c < COLS; c++)
     {
-      _button_list[r][c] = new Button(0, 0, 0, 0, false, "", _bc_off, _bc_on);
+      _button_list[r][c] = M5ButtonPool::Get(0, 0, 0, 0, "", _bc_off, _bc_on, BUTTON_DATUM, 0, 0, 0xFF);
+      if(_button_list[r][c] == NULL)
+      {
+        _keyboard_cancel = true; // pool exhausted, caller did not release its buttons
+        continue;
+      }
       _button_list[r][c]->setTextSize(1);
     }
   }
@@ -191,8 +203,7 @@ void M5Keyboard::_deinitKeyboard()
   {
     for(int c = 0; c < COLS; c++)
     {
-      delete(_button_list[r][c]);
-      _button_list[r][c] = NULL;
+      M5ButtonPool::Release(_button_list[r][c]);
     }
   }
 }
@@ -207,6 +218,8 @@ void M5Keyboard::_drawKeyboardNumeric( bool bFloat )
         {
             x = (KEYBOARD_X + (c * cx));
             y = (KEYBOARD_Y + (r * cy));
+            if(_button_list[r][c] == NULL)
+                continue;
             _button_list[r][c]->set(x, y, cx, cy);
 
             const int key_page = 4;
@@ -240,6 +253,8 @@ void M5Keyboard::_drawKeyboard()
     {
       x = (KEYBOARD_X + (c * KEY_W));
       y = (KEYBOARD_Y + (r * KEY_H));
+      if(_button_list[r][c] == NULL)
+        continue;
       _button_list[r][c]->set(x, y, KEY_W, KEY_H);
 
       int key_page;
@@ -275,7 +290,7 @@ void M5Keyboard::_drawKeyboard()
 void M5Keyboard::_btnAEvent(Event& e)
 {
   // Delete all (long press) or delete one char (short press)
-  if(e.button == &M5.BtnA)
+  if(e.button == &M5.BtnA && !_wait_release)
   {
     if(e.duration > 500)
     {
@@ -292,6 +307,8 @@ void M5Keyboard::_btnAEvent(Event& e)
 void M5Keyboard::_buttonEvent(Event& e)
 {
   Button& b = *e.button;
+  if(_wait_release || _keyboard_done || _keyboard_cancel)
+    return;
 
   // Delete
   if(e.button == &M5.BtnA)
@@ -20,7 +20,17 @@ public:
         NUM_KEY_MODES,
     } key_mode_t;
 
-  bool Show(String& text, const char* title = NULL, key_mode_t keyMode = KEY_MODE_LETTER);
+    typedef enum
+    {
+        KB_RUNNING = 0,
+        KB_DONE,
+        KB_CANCEL,
+    } kb_result_t;
+
+  // non-blocking: Open(), then Update() from main loop until it returns KB_DONE or KB_CANCEL
+  void Open(const String& text, const char* title = NULL, key_mode_t keyMode = KEY_MODE_LETTER);
+  kb_result_t Update();
+  const String& GetText();
 
 protected:
     static void _initKeyboard(String text, const char* title, key_mode_t keyMode);
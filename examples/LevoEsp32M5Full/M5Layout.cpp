@@ -0,0 +1,239 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * Screen layouts, loaded from SD card, Preferences or built-in default
+ *
+ */
+
+#include "M5Layout.h"
+
+#define LAYOUT_FILE "/layout.txt"
+#define LAYOUT_KEY  "Layout"
+
+static const int START_Y = 32;  // Y start position on screen
+
+const char M5Layout::s_defaultLayout[] =
+    "screen A Data A\n"
+    "10 8 14 6 5 1 7 9 12 11 3 13 25 26 42 43 46\n"
+    "screen A Ride\n"                    // button A toggles
+    "10:b / 8:c 14:c / 6:c 9:c / 7:g0,100 1:g0,700\n"
+    "screen B Data B\n"
+    "15 16 17 / 20 21 22 / 23 18 24 / 0 19 4 2\n"
+    "screen C trip Trip & Tune\n"
+    "27 28 33 47 29 40 39 30 32 34 35 36 37 38 41\n";
+
+bool M5Layout::Load(Preferences& prefs, DisplayData& dispData, bool bHasSDCard)
+{
+    static char text[MAX_TEXT + 1];
+    size_t len = 0;
+    const char* pSource = "default";
+
+    // SD card
+    if (bHasSDCard && SD.exists(LAYOUT_FILE))
+    {
+        File file = SD.open(LAYOUT_FILE, "r");
+        if (file)
+        {
+            len = file.read((uint8_t*)text, MAX_TEXT);
+            file.close();
+            pSource = LAYOUT_FILE;
+        }
+    }
+
+    // preferences
+    if (len == 0 && prefs.isKey(LAYOUT_KEY))
+    {
+        len = prefs.getBytes(LAYOUT_KEY, text, MAX_TEXT);
+        pSource = "preferences";
+    }
+    text[len] = '\0';
+
+    m_pDispData = &dispData;
+    if (len > 0 && compile(text))
+    {
+        Serial.printf("layout: %d screens, %d fields from %s\n", m_nScreens, m_nFields, pSource);
+        return true;
+    }
+    if (len > 0)
+        Serial.printf("layout: error in %s, using default\n", pSource);
+
+    strcpy(text, s_defaultLayout);
+    compile(text);
+    return len == 0;
+}
+
+bool M5Layout::compile(char* pText)
+{
+    m_nScreens = 0;
+    m_nFields  = 0;
+
+    char* pLine = pText;
+    while (pLine && *pLine)
+    {
+        char* pNext = strchr(pLine, '\n');
+        if (pNext)
+            *pNext++ = '\0';
+        char* pComment = strchr(pLine, '#');
+        if (pComment)
+            *pComment = '\0';
+
+        // screen header
+        while (*pLine == ' ' || *pLine == '\t')
+            pLine++;
+        if (strncmp(pLine, "screen ", 7) == 0)
+        {
+            if (!beginScreen(pLine + 7))
+                return false;
+            pLine = pNext;
+            continue;
+        }
+
+        // fields
+        for (char* pTok = strtok(pLine, " \t\r"); pTok; pTok = strtok(NULL, " \t\r"))
+        {
+            if (m_nScreens == 0)
+                return false;
+            if (strcmp(pTok, "/") == 0)
+            {
+                m_bNewLine = true;
+                continue;
+            }
+            char* pEnd;
+            long id = strtol(pTok, &pEnd, 10);
+            if (pEnd == pTok || id < 0 || id >= DisplayData::numElements)
+                return false;
+            enWidget widget = WIDGET_AUTO;
+            float rangeMin = 0.0f, rangeMax = 0.0f;
+            if (pEnd[0] == ':')
+            {
+                switch (pEnd[1])
+                {
+                case 't': widget = WIDGET_THIRD; break;
+                case 'h': widget = WIDGET_HALF; break;
+                case 'b': widget = WIDGET_BIG; break;
+                case 'g': widget = WIDGET_GAUGE; break;
+                case 'c': widget = WIDGET_CHART; break;
+                default:  return false;
+                }
+                if (pEnd[2] && sscanf(pEnd + 2, "%f,%f", &rangeMin, &rangeMax) != 2)
+                    return false;
+            }
+            addField((DisplayData::enIds)id, widget, rangeMin, rangeMax);
+        }
+        pLine = pNext;
+    }
+    return m_nScreens > 0;
+}
+
+bool M5Layout::beginScreen(char* pArgs)
+{
+    if (m_nScreens >= MAX_SCREENS || pArgs[0] < 'A' || pArgs[0] > 'C')
+        return false;
+
+    stScreen& screen = m_screens[m_nScreens++];
+    memset(&screen, 0, sizeof(screen));
+    memset(screen.idToIdx, -1, sizeof(screen.idToIdx));
+    screen.button = pArgs[0] - 'A';
+    screen.firstField = m_nFields;
+
+    pArgs++;
+    while (*pArgs == ' ')
+        pArgs++;
+    if (strncmp(pArgs, "trip", 4) == 0 && (pArgs[4] == ' ' || pArgs[4] == '\0' || pArgs[4] == '\r'))
+    {
+        screen.flags |= TRIPBAR;
+        pArgs += 4;
+        while (*pArgs == ' ')
+            pArgs++;
+    }
+    strncpy(screen.title, pArgs, TITLE_SIZE - 1);
+    char* pCr = strchr(screen.title, '\r');
+    if (pCr)
+        *pCr = '\0';
+
+    m_x = 0;
+    m_y = START_Y;
+    m_bottom = 0;
+    m_bNewLine = false;
+    return true;
+}
+
+// position by line wrap, same as the former fixed layouts
+void M5Layout::addField(DisplayData::enIds id, enWidget widget, float rangeMin, float rangeMax)
+{
+    stScreen& screen = m_screens[m_nScreens - 1];
+    const DisplayData::stDisplayData* pDesc = m_pDispData->GetDescription(id);
+    if (pDesc == NULL || screen.idToIdx[id] >= 0) // hidden or twice
+        return;
+    if (m_nFields >= MAX_FIELDS)
+    {
+        Serial.printf("layout: more than %d fields\n", MAX_FIELDS);
+        return;
+    }
+
+    // needed field width
+    if (widget == WIDGET_AUTO)
+        widget = (pDesc->nWidth > 4) ? WIDGET_HALF : WIDGET_THIRD;
+    M5Field* pField = m_pWidgets[widget];
+    if (pField == NULL)
+        return;
+    int cx = pField->GetMetrics().rcBoundWidth;
+
+    stField& field = m_fields[m_nFields];
+    field.id = id;
+    field.pField = pField;
+    field.x = m_x;
+    field.y = m_y;
+    field.unit = M5Field::ParseUnit(pDesc->strUnit);
+    field.rangeMin = rangeMin;
+    field.rangeMax = (widget == WIDGET_GAUGE && rangeMax <= rangeMin) ? 100.0f : rangeMax;
+
+    // wrap line
+    m_x += cx;
+    if (m_x > M5.Lcd.width() || m_bNewLine)
+    {
+        m_y += m_bottom;
+        m_x = cx;
+        m_bottom = 0;
+        field.x = 0;
+        field.y = m_y;
+    }
+    m_bNewLine = false;
+    m_bottom = max(m_bottom, (int)pField->GetMetrics().rcBoundHeight);
+
+    if (field.y >= M5.Lcd.height())
+    {
+        Serial.printf("layout: field %d does not fit on screen %s\n", id, screen.title);
+        return;
+    }
+    screen.idToIdx[id] = screen.nFields++;
+    m_nFields++;
+}
+
+int M5Layout::NextScreen(int button, int nCurrent)
+{
+    for (int i = 1; i <= m_nScreens; i++)
+    {
+        int n = (nCurrent + i) % m_nScreens;
+        if (m_screens[n].button == button)
+            return n;
+    }
+    return -1;
+}
+
+void M5Layout::Print()
+{
+    for (int i = 0; i < m_nScreens; i++)
+    {
+        const stScreen& screen = m_screens[i];
+        Serial.printf("screen %c%s %s\n", 'A' + screen.button, (screen.flags & TRIPBAR) ? " trip" : "", screen.title);
+        const stField* pFields = GetFields(i);
+        for (int n = 0; n < screen.nFields; n++)
+        {
+            const DisplayData::stDisplayData* pDesc = m_pDispData->GetDescription((DisplayData::enIds)pFields[n].id);
+            Serial.printf("%s%d # %s\n", (n > 0 && pFields[n].x == 0) ? "/ " : "", pFields[n].id, pDesc ? pDesc->strLabel : "");
+        }
+    }
+}
@@ -0,0 +1,108 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * Screen layouts, loaded from SD card (/layout.txt), Preferences (key "Layout")
+ * or the built-in default and compiled once into per screen render lists.
+ *
+ * Layout text:
+ *   # comment
+ *   screen <A|B|C> [trip] <title>   new screen, shown by hardware button A, B or C,
+ *                                   a button cycles through all its screens,
+ *                                   trip: screen has the trip/tune button bar
+ *   <id>[:<w>] ... / <id> ...       field ids (DisplayData::enIds), '/' starts a new line,
+ *                                   w: t = third width, h = half width, default by value width,
+ *                                   b = big number, full width
+ *                                   g<min>,<max> = bar gauge, c[<min>,<max>] = chart, default 0..max
+ *
+ */
+
+#ifndef M5_LAYOUT_H
+#define M5_LAYOUT_H
+
+#include <M5Core2.h>
+#include <Preferences.h>
+#include "DisplayData.h"
+#include "M5Field.h"
+
+class M5Layout
+{
+public:
+    enum
+    {
+        MAX_SCREENS = 8,
+        MAX_FIELDS  = 96,   // all screens
+        MAX_TEXT    = 2048, // layout file size
+        TITLE_SIZE  = 16,
+    };
+
+    typedef enum
+    {
+        WIDGET_AUTO = 0,
+        WIDGET_THIRD,
+        WIDGET_HALF,
+        WIDGET_BIG,
+        WIDGET_GAUGE,
+        WIDGET_CHART,
+        NUM_WIDGETS,
+    } enWidget;
+
+    typedef enum
+    {
+        TRIPBAR = 1, // trip/tune button bar
+    } enScreenFlags;
+
+    typedef struct
+    {
+        int16_t  x;
+        int16_t  y;
+        M5Field* pField;
+        uint8_t  id;
+        float    rangeMin; // gauge and chart
+        float    rangeMax;
+        M5Field::stUnit unit;
+    } stField;
+
+    typedef struct
+    {
+        char     title[TITLE_SIZE];
+        uint8_t  button;  // 0..2: hardware button A..C
+        uint8_t  flags;
+        uint8_t  firstField;
+        uint8_t  nFields;
+        int8_t   idToIdx[DisplayData::numElements]; // -1: not on screen
+    } stScreen;
+
+    void SetWidget(enWidget widget, M5Field* pField) { m_pWidgets[widget] = pField; }
+    bool Load(Preferences& prefs, DisplayData& dispData, bool bHasSDCard);
+
+    int             GetNumScreens() { return m_nScreens; }
+    const stScreen& GetScreen(int nScreen) { return m_screens[nScreen]; }
+    const stField*  GetFields(int nScreen) { return &m_fields[m_screens[nScreen].firstField]; }
+    int             NextScreen(int button, int nCurrent); // next screen of a button, -1: none
+
+    void Print(); // layout text to serial, template for /layout.txt
+
+protected:
+    M5Field* m_pWidgets[NUM_WIDGETS] = {};
+
+    stScreen m_screens[MAX_SCREENS];
+    stField  m_fields[MAX_FIELDS];
+    int      m_nScreens = 0;
+    int      m_nFields  = 0;
+
+    static const char s_defaultLayout[];
+
+    // compiler
+    DisplayData* m_pDispData = NULL;
+    int      m_x = 0;
+    int      m_y = 0;
+    int      m_bottom = 0;
+    bool     m_bNewLine = false;
+    bool     compile(char* pText);
+    bool     beginScreen(char* pArgs);
+    void     addField(DisplayData::enIds id, enWidget widget, float rangeMin, float rangeMax);
+};
+
+#endif // M5_LAYOUT_H
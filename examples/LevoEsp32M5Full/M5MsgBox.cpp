@@ -0,0 +1,103 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * Non-blocking message box
+ *
+ */
+
+#include <Fonts/EVA_20px.h>
+#include "M5MsgBox.h"
+#include "M5ButtonPool.h"
+
+ButtonColors M5MsgBox::on_clrs  = { GREEN, WHITE, WHITE };
+ButtonColors M5MsgBox::off_clrs = { BLACK, WHITE, WHITE };
+
+// simple full screen centered two line message
+void M5MsgBox::Open(const char* msg, enMsgBoxButtons type)
+{
+    m_type = type;
+    M5.Lcd.clear(TFT_BLACK);
+    M5.Lcd.pushState();
+
+    TFT_eSprite lcdbuff = TFT_eSprite(&M5.Lcd);
+    lcdbuff.createSprite(320, 240);
+    lcdbuff.setFreeFont(&EVA_20px);
+    lcdbuff.setTextSize(1);
+    lcdbuff.setTextColor(TFT_WHITE, TFT_BLACK);
+    lcdbuff.setTextDatum(TC_DATUM);
+    int x = M5.Lcd.width() / 2;
+    int y = M5.Lcd.height() / 2 - 10;
+    lcdbuff.drawString( msg, x, y, GFXFF);
+    lcdbuff.pushSprite(0, 0);
+    lcdbuff.deleteSprite();
+
+    if (type == NOBUTTON)
+    {
+        M5.Lcd.popState();
+        return;
+    }
+
+    // show buttons
+    const int cx = 100, cy = 35;
+    const int bx = M5.Lcd.width()/4 - cx/2;
+    const int by = M5.Lcd.height()/4 * 3;
+    switch (type)
+    {
+    case CONFIRM:
+        m_pB1 = M5ButtonPool::Get(x - cx / 2, by, cx, cy, "OK", off_clrs, on_clrs, TC_DATUM, 0, 3);
+        break;
+    case OKCANCEL:
+        m_pB1 = M5ButtonPool::Get(bx, by, cx, cy, "OK", off_clrs, on_clrs, TC_DATUM, 0, 3);
+        m_pB2 = M5ButtonPool::Get((bx + cx / 2) * 3 - cx / 2, by, cx, cy, "Cancel", off_clrs, on_clrs, TC_DATUM, 0, 3);
+        break;
+    case YESNO:
+        m_pB1 = M5ButtonPool::Get(bx, by, cx, cy, "Yes", off_clrs, on_clrs, TC_DATUM, 0, 3);
+        m_pB2 = M5ButtonPool::Get((bx + cx / 2) * 3 - cx / 2, by, cx, cy, "No", off_clrs, on_clrs, TC_DATUM, 0, 3);
+        break;
+    default:
+        break;
+    }
+    M5.Buttons.draw();
+    m_bOpen = true;
+    m_bWaitRelease = true;
+}
+
+bool M5MsgBox::Update(enMsgBoxReturn& ret)
+{
+    if (!m_bOpen)
+    {
+        ret = RET_OK; // NOBUTTON
+        return true;
+    }
+
+    // ignore the touch that opened the box
+    if (m_bWaitRelease)
+    {
+        m_bWaitRelease = M5.Touch.ispressed();
+        return false;
+    }
+
+    if (m_pB1 && m_pB1->wasPressed())
+        ret = (m_type == YESNO) ? RET_YES : RET_OK;
+    else if (m_pB2 && m_pB2->wasPressed())
+        ret = (m_type == YESNO) ? RET_NO : RET_CANCEL;
+    else
+        return false;
+
+    close();
+    return true;
+}
+
+void M5MsgBox::close()
+{
+    if (m_pB1)
+        m_pB1->erase();
+    if (m_pB2)
+        m_pB2->erase();
+    M5ButtonPool::Release(m_pB1);
+    M5ButtonPool::Release(m_pB2);
+    M5.Lcd.popState();
+    m_bOpen = false;
+}
@@ -0,0 +1,54 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * Non-blocking message box
+ *
+ * Open() draws the message, Update() from the main loop returns true
+ * once a button was pressed.
+ *
+ */
+
+#ifndef M5MSGBOX_H
+#define M5MSGBOX_H
+
+#include <M5Core2.h>
+
+class M5MsgBox
+{
+public:
+    typedef enum
+    {
+        CONFIRM = 0,
+        OKCANCEL,
+        YESNO,
+        NOBUTTON, // show message, Update() returns at once
+    } enMsgBoxButtons;
+
+    typedef enum
+    {
+        RET_OK = 0,
+        RET_CANCEL,
+        RET_YES,
+        RET_NO,
+    } enMsgBoxReturn;
+
+    void Open(const char* msg, enMsgBoxButtons type = CONFIRM);
+    bool Update(enMsgBoxReturn& ret); // true: closed, ret is valid
+    bool IsOpen() { return m_bOpen; }
+
+protected:
+    static ButtonColors on_clrs;
+    static ButtonColors off_clrs;
+
+    enMsgBoxButtons m_type  = CONFIRM;
+    bool     m_bOpen        = false;
+    bool     m_bWaitRelease = false; // touch that opened the box is still down
+    Button*  m_pB1          = NULL;
+    Button*  m_pB2          = NULL;
+
+    void close();
+};
+
+#endif // M5MSGBOX_H
@@ -0,0 +1,127 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * power modes of M5Core2, driven by BLE status, ride activity and display timer
+ *
+ */
+
+#include "M5PowerMode.h"
+#include "IMUSensors.h"
+#include "SysClock.h"
+
+#if defined(CONFIG_PM_ENABLE) && defined(CONFIG_FREERTOS_USE_TICKLESS_IDLE)
+    #include <esp_pm.h>
+    #define POWERMODE_LIGHTSLEEP
+#endif
+
+// BLE needs 80 MHz at least
+const M5PowerMode::stMode M5PowerMode::s_modes[NUM_MODES] =
+{
+    //  name       MHz  poll delay IMU ms
+    { "active",    240,  1,   0,   10 },
+    { "idle",       80,  4,   5,   20 },
+    { "standby",    80, 10,  20,   50 },
+};
+
+void M5PowerMode::Init()
+{
+    m_tiMode = (uint32_t)SysClock::Millis();
+    applyMode(s_modes[ACTIVE]);
+}
+
+void M5PowerMode::FeedValue(DisplayData::enIds id, float fVal, uint32_t timestamp)
+{
+    if (id == DisplayData::BLE_MOT_SPEED && fVal > 0.0)
+        m_tiRiding = timestamp;
+}
+
+void M5PowerMode::Update(bool bBleConnected, bool bDisplayOff, uint32_t timestamp)
+{
+    bool bRiding = m_tiRiding != 0 && timestamp - m_tiRiding < RIDE_TIMEOUT_MS;
+    enMode mode;
+    if (!bDisplayOff || bRiding)
+        mode = ACTIVE;
+    else if (bBleConnected)
+        mode = IDLE;
+    else
+        mode = STANDBY;
+
+    if (mode != m_mode)
+        setMode(mode, timestamp);
+}
+
+void M5PowerMode::setMode(enMode mode, uint32_t timestamp)
+{
+    stModeStats& st = m_stats[m_mode];
+    st.tiTotal += timestamp - m_tiMode;
+    Serial.printf("Power mode: %s -> %s after %u s\r\n", s_modes[m_mode].name, s_modes[mode].name, (timestamp - m_tiMode) / 1000);
+    m_mode   = mode;
+    m_tiMode = timestamp;
+    applyMode(s_modes[mode]);
+}
+
+void M5PowerMode::applyMode(const stMode& mode)
+{
+#ifdef POWERMODE_LIGHTSLEEP
+    // dynamic clock, light sleep in idle task between BLE connection events
+    esp_pm_config_esp32_t pm;
+    pm.max_freq_mhz = mode.cpuMhz;
+    pm.min_freq_mhz = 80;
+    pm.light_sleep_enable = (mode.loopDelayMs != 0);
+    esp_pm_configure(&pm);
+#else
+    setCpuFrequencyMhz(mode.cpuMhz);
+#endif
+    m_imu.SetSampleInterval(mode.imuSampleMs);
+}
+
+// let idle task run, main loop only polls queues and touch in lower modes
+void M5PowerMode::Yield()
+{
+    uint8_t ms = s_modes[m_mode].loopDelayMs;
+    if (ms)
+        delay(ms);
+}
+
+// filtered discharge current
+void M5PowerMode::Sample(bool bOnBattery, float mA, uint32_t timestamp)
+{
+    if (bOnBattery != m_bOnBattery)
+    {
+        if (bOnBattery)
+        {
+            m_tiOnBattery = timestamp;
+            m_mAhUsed = 0.0;
+        }
+        else
+            Serial.printf("Power: %u min on battery, %.0f mAh used\r\n", (timestamp - m_tiOnBattery) / 60000, m_mAhUsed);
+        m_bOnBattery = bOnBattery;
+        m_tiSample = timestamp;
+        return;
+    }
+    if (!bOnBattery)
+        return;
+
+    m_mAhUsed += mA * (timestamp - m_tiSample) / 3600000.0;
+    m_tiSample = timestamp;
+
+    stModeStats& st = m_stats[m_mode];
+    st.sumCurrent += mA;
+    st.nSamples++;
+}
+
+void M5PowerMode::PrintStats()
+{
+    uint32_t ti = (uint32_t)SysClock::Millis();
+    for (int i = 0; i < NUM_MODES; i++)
+    {
+        const stModeStats& st = m_stats[i];
+        uint32_t tiTotal = st.tiTotal + ((i == m_mode) ? ti - m_tiMode : 0);
+        Serial.printf("Power mode %s: %u s, %.0f mA\r\n", s_modes[i].name, tiTotal / 1000,
+            st.nSamples ? st.sumCurrent / st.nSamples : 0.0);
+    }
+    if (m_bOnBattery)
+        Serial.printf("Power: %u min on battery, %.0f mAh used\r\n", (ti - m_tiOnBattery) / 60000, m_mAhUsed);
+}
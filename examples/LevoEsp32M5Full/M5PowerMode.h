@@ -0,0 +1,91 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * power modes of M5Core2, driven by BLE status, ride activity and display timer
+ *
+ *  ACTIVE:  display on or riding, full CPU clock, sensors at full rate
+ *  IDLE:    BLE connected, display off, no ride activity
+ *  STANDBY: BLE not connected and display off
+ *
+ * Lower modes reduce CPU clock, throttle sensor polling and let the main loop
+ * yield to the idle task. With CONFIG_PM_ENABLE and tickless idle in the core
+ * the idle task enters light sleep between BLE connection events, otherwise
+ * only the clock is scaled. Battery discharge current per mode and run time
+ * on battery come from M5Battery.
+ *
+ */
+
+#ifndef M5POWERMODE_H
+#define M5POWERMODE_H
+
+#include <M5Core2.h>
+#include "DisplayData.h"
+
+class IMUSensors;
+
+class M5PowerMode
+{
+public:
+    typedef enum
+    {
+        ACTIVE = 0,
+        IDLE,
+        STANDBY,
+        NUM_MODES,
+    } enMode;
+
+    M5PowerMode(IMUSensors& imu) : m_imu(imu) {}
+
+    void   Init();
+    void   FeedValue(DisplayData::enIds id, float fVal, uint32_t timestamp); // ride activity
+    void   Update(bool bBleConnected, bool bDisplayOff, uint32_t timestamp); // 100 ms
+    void   Sample(bool bOnBattery, float current, uint32_t timestamp); // 1000 ms, battery current in mA
+    void   Yield(); // end of main loop
+
+    enMode   GetMode() { return m_mode; }
+    uint32_t GetPollInterval(uint32_t ms) { return ms * s_modes[m_mode].pollScale; }
+    void     PrintStats(); // current per mode and run time on battery
+
+protected:
+    enum
+    {
+        RIDE_TIMEOUT_MS = 60000, // no speed for this time: not riding
+    };
+
+    typedef struct
+    {
+        const char* name;
+        uint16_t    cpuMhz;
+        uint8_t     pollScale;    // sensor poll interval factor
+        uint8_t     loopDelayMs;  // main loop yields this time
+        uint8_t     imuSampleMs;
+    } stMode;
+    static const stMode s_modes[NUM_MODES];
+
+    // battery discharge per mode
+    typedef struct
+    {
+        uint32_t tiTotal;     // ms in mode
+        float    sumCurrent;  // mA, on battery only
+        uint32_t nSamples;
+    } stModeStats;
+
+    IMUSensors& m_imu;
+    enMode      m_mode = ACTIVE;
+    uint32_t    m_tiMode = 0;     // mode entered
+    uint32_t    m_tiRiding = 0;   // last speed > 0
+    stModeStats m_stats[NUM_MODES] = {};
+
+    // run time on battery
+    bool        m_bOnBattery = false;
+    uint32_t    m_tiOnBattery = 0;
+    float       m_mAhUsed = 0.0;
+    uint32_t    m_tiSample = 0;
+
+    void setMode(enMode mode, uint32_t timestamp);
+    void applyMode(const stMode& mode);
+};
+
+#endif // M5POWERMODE_H
@@ -14,7 +14,7 @@
 
 #include "M5Screen.h"
 #include "M5Field.h"
-#include "M5ConfigForms.h"
+#include "SysClock.h"
 
 // icons
 extern const uint8_t btblue_map[];
@@ -32,6 +32,9 @@ extern const uint8_t img_tripstop_map[];
 
 M5FieldThird thirdField;
 M5FieldHalf  halfField;
+M5FieldBig   bigField;
+M5FieldGauge gaugeField;
+M5FieldChart chartField;
 
 // val is in seconds
 void M5Screen::formatAsTime(float val, size_t nLen, char* strVal)
@@ -45,74 +48,296 @@ void M5Screen::formatAsTime(float val, size_t nLen, char* strVal)
 
 void M5Screen::ShowValue( DisplayData::enIds id, float val, DisplayData& dispData )
 {
-    char strVal[20];
-
     // buffer value in case of screen change
     if( id < DisplayData::NUM_ELEMENTS )
       m_valueBuffer[id] = val;
+    else
+      return;
+
+    // mark field for next frame
+    m_stats.nValues++;
+    int idx = m_idToIdx[id];
+    if (idx < 0)
+        return;
+    if (m_fldRender[idx].bDirty)
+        m_stats.nMerged++;
+    m_fldRender[idx].bDirty = true;
+    m_bDirty = true;
+}
+
+void M5Screen::Update(uint32_t ti)
+{
+    if (m_pDispData == NULL)
+        return;
 
-    const DisplayData::stDisplayData* pDesc = dispData.GetDescription(id);
-    if (pDesc && pDesc->nWidth < sizeof( strVal ) )
+    // chart history, sampled for all screens
+    if (ti - m_tiSample >= ValueHistory::SAMPLE_MS)
     {
-        if( pDesc->flags & DisplayData::TIME )
-            formatAsTime( val, sizeof(strVal), strVal );
-        else
-            dtostrf(val, pDesc->nWidth, pDesc->nPrecision, strVal );
-        
-        int idx = m_idToIdx[id];
-        if (idx < 0 || idx >= DisplayData::NUM_ELEMENTS)
+        m_tiSample = ti;
+        sampleHistory();
+    }
+
+    if (m_bHidden)
+    {
+        m_tiNextFrame = 0L;
+        return;
+    }
+    if ((int32_t)(ti - m_tiNextFrame) < 0)
+        return;
+
+    // frames missed since last due time
+    if (m_tiNextFrame != 0L)
+        m_stats.nDropped += (ti - m_tiNextFrame) / m_frameMs;
+    m_tiNextFrame = ti + m_frameMs;
+    if (!m_bDirty)
+        return;
+
+    uint32_t usStart = micros();
+    for (int i = 0; i < m_nFields; i++)
+    {
+        stRender& render = m_fldRender[i];
+        if (!render.bDirty)
+            continue;
+        render.bDirty = false;
+        DisplayData::enIds id = (DisplayData::enIds)m_pFields[i].id;
+        const DisplayData::stDisplayData* pDesc = m_pDispData->GetDescription(id);
+        if (pDesc && m_valueBuffer[id] != FLOAT_UNDEFINED)
+            renderValue(i, id, m_valueBuffer[id], pDesc);
+    }
+    m_bDirty = false;
+
+    uint32_t us = micros() - usStart;
+    m_stats.nFrames++;
+    m_stats.usFrames += us;
+    m_stats.usMaxFrame = max(m_stats.usMaxFrame, us);
+}
+
+// full redraw on first value, style or length change, else only the changed chars
+void M5Screen::renderValue(int idx, DisplayData::enIds id, float val, const DisplayData::stDisplayData* pDesc)
+{
+    char strVal[20];
+    if (pDesc->nWidth >= sizeof(strVal))
+        return;
+
+    if( pDesc->flags & DisplayData::TIME )
+        formatAsTime( val, sizeof(strVal), strVal );
+    else
+        dtostrf(val, pDesc->nWidth, pDesc->nPrecision, strVal );
+
+    // style/text color
+    M5Field::enStyle style = M5Field::NORMAL;
+    if( pDesc->flags & DisplayData::TRIP && m_sysStatus.tripStatus != SystemStatus::STARTED )
+        style = M5Field::OFFLINE;
+
+    stRender& render = m_fldRender[idx];
+    const M5Layout::stField& field = m_pFields[idx];
+    uint32_t usStart = micros();
+
+    // gauge bar, charts are drawn by sampleHistory()
+    if (field.pField->IsGraph() && !field.pField->IsChart())
+        field.pField->RenderGraph(field.x, field.y, val, m_graph[idx], false);
+
+    uint32_t cx = field.pField->GetMetrics().rcBoundWidth - 2;
+    uint32_t cy = field.pField->GetMetrics().txtHeightVal;
+    size_t   len = strlen(strVal);
+    uint32_t fullBytes = ( cx + (len + strlen(field.unit.pText)) * M5Field::VAL_CHAR_WIDTH ) * cy * 2;
+    if (render.text[0] && render.style == style && strlen(render.text) == len)
+    {
+        int first = 0, last = (int)len - 1;
+        while (first <= last && strVal[first] == render.text[first])
+            first++;
+        while (last >= first && strVal[last] == render.text[last])
+            last--;
+        if (first > last)
+        {
+            m_stats.nSkipped++;
+            m_stats.bytesSaved += fullBytes;
             return;
+        }
+        field.pField->RenderValueSpan(strVal, first, last, field.x, field.y, style);
+        uint32_t spanBytes = (last - first + 1) * M5Field::VAL_CHAR_WIDTH * cy * 2;
+        m_stats.nPartial++;
+        addBlockedTime(usStart);
+        m_stats.bytesSent += spanBytes;
+        m_stats.bytesSaved += (fullBytes > spanBytes) ? fullBytes - spanBytes : 0;
+    }
+    else
+    {
+        field.pField->RenderValue(strVal, field.x, field.y, field.unit, style);
+        m_stats.nFull++;
+        addBlockedTime(usStart);
+        m_stats.bytesSent += fullBytes;
+    }
+    strcpy(render.text, strVal);
+    render.style = style;
+}
+
+// draw time of a value field with TFT font rendering and with glyph atlas
+void M5Screen::Benchmark()
+{
+    const int N = 200;
+    if (m_nFields == 0)
+        return;
+    const M5Layout::stField& field = m_pFields[0];
+    char strVal[20];
+
+    for (int mode = 0; mode < 2; mode++)
+    {
+        M5Field::SetUseAtlas(mode == 1);
+        uint32_t usStart = micros();
+        for (int i = 0; i < N; i++)
+        {
+            dtostrf(i * 0.1f, 5, 1, strVal);
+            field.pField->RenderValue(strVal, field.x, field.y, field.unit, M5Field::NORMAL);
+        }
+        uint32_t usFull = micros() - usStart;
 
-        // style/text color
-        M5Field::enStyle style = M5Field::NORMAL;
-        if( pDesc->flags & DisplayData::TRIP && m_sysStatus.tripStatus != SystemStatus::STARTED )
-            style = M5Field::OFFLINE;
-        
-        // render value
-        stRender& render = m_fldRender[idx];
-        render.pField->RenderValue(strVal, render.x, render.y, pDesc, style);
+        usStart = micros();
+        for (int i = 0; i < N; i++)
+        {
+            dtostrf(i * 0.1f, 5, 1, strVal);
+            field.pField->RenderValueSpan(strVal, 4, 4, field.x, field.y, M5Field::NORMAL);
+        }
+        uint32_t usSpan = micros() - usStart;
+        Serial.printf("Screen benchmark %s: %u us/value, %u us/changed digit\n", mode ? "glyph atlas" : "TFT font   ", usFull / N, usSpan / N);
     }
+    M5Field::SetUseAtlas(true);
+}
+
+void M5Screen::addBlockedTime(uint32_t usStart)
+{
+    uint32_t us = micros() - usStart;
+    m_stats.usBlocked += us;
+    m_stats.usMaxBlocked = max(m_stats.usMaxBlocked, us);
 }
 
-void M5Screen::renderEmptyValue(stRender& render, const DisplayData::stDisplayData* pDesc)
+void M5Screen::PrintRenderStats()
+{
+    uint32_t nRenders = m_stats.nFull + m_stats.nPartial;
+    Serial.printf("Screen: %u frames, %u dropped, %u us/frame, max %u us\n",
+        m_stats.nFrames, m_stats.nDropped, m_stats.nFrames ? m_stats.usFrames / m_stats.nFrames : 0, m_stats.usMaxFrame);
+    Serial.printf("Screen: %u values, %u merged, %u full, %u partial, %u skipped, %u kB sent, %u kB saved\n",
+        m_stats.nValues, m_stats.nMerged, m_stats.nFull, m_stats.nPartial, m_stats.nSkipped,
+        m_stats.bytesSent / 1024, m_stats.bytesSaved / 1024);
+    Serial.printf("Screen: CPU blocked %u ms, %u us/render, max %u us\n",
+        m_stats.usBlocked / 1000, nRenders ? m_stats.usBlocked / nRenders : 0, m_stats.usMaxBlocked);
+}
+
+void M5Screen::renderEmptyValue(int idx, const DisplayData::stDisplayData* pDesc)
 {
     char strVal[20];
     if (pDesc->flags & DisplayData::TIME)
         formatAsTime(0.0, sizeof(strVal), strVal);
     else
         dtostrf( 0.0f, pDesc->nWidth, pDesc->nPrecision, strVal);
-    render.pField->RenderValue( strVal, render.x, render.y, pDesc, M5Field::OFFLINE );
+    m_pFields[idx].pField->RenderValue( strVal, m_pFields[idx].x, m_pFields[idx].y, m_pFields[idx].unit, M5Field::OFFLINE );
+    m_fldRender[idx].text[0] = '\0';
+}
+
+bool M5Screen::LoadLayout(Preferences& prefs, DisplayData& dispData, bool bHasSDCard)
+{
+    m_layout.SetWidget(M5Layout::WIDGET_THIRD, &thirdField);
+    m_layout.SetWidget(M5Layout::WIDGET_HALF, &halfField);
+    m_layout.SetWidget(M5Layout::WIDGET_BIG, &bigField);
+    m_layout.SetWidget(M5Layout::WIDGET_GAUGE, &gaugeField);
+    m_layout.SetWidget(M5Layout::WIDGET_CHART, &chartField);
+    bool bRet = m_layout.Load(prefs, dispData, bHasSDCard);
+
+    // one history per charted id
+    m_nHistories = 0;
+    for (int n = 0; n < m_layout.GetNumScreens(); n++)
+    {
+        const M5Layout::stField* pFields = m_layout.GetFields(n);
+        for (int i = 0; i < m_layout.GetScreen(n).nFields; i++)
+        {
+            if (!pFields[i].pField->IsChart())
+                continue;
+            int h = 0;
+            while (h < m_nHistories && m_historyId[h] != pFields[i].id)
+                h++;
+            if (h == m_nHistories && m_nHistories < MAX_HISTORIES)
+            {
+                m_history[h].Clear();
+                m_historyId[m_nHistories++] = pFields[i].id;
+            }
+        }
+    }
+    return bRet;
 }
 
-DisplayData::enIds M5Screen::getIdFromIdx(enScreens nScreen, int i)
+void M5Screen::sampleHistory()
 {
-    if (i < DisplayData::numElements)
+    for (int h = 0; h < m_nHistories; h++)
     {
-        if(m_order[nScreen][i] != UNKNOWN )
-            return (DisplayData::enIds)(m_order[nScreen][i] & 0x7FFF);
+        float val = m_valueBuffer[m_historyId[h]];
+        if (val != FLOAT_UNDEFINED)
+            m_history[h].Add(val);
+    }
+
+    // scroll charts of current screen, redrawn by Init() when a form closes
+    if (m_bHidden)
+        return;
+    for (int i = 0; i < m_nFields; i++)
+    {
+        if (m_pFields[i].pField->IsChart())
+            m_pFields[i].pField->RenderGraph(m_pFields[i].x, m_pFields[i].y, 0.0f, m_graph[i], false);
     }
-    return DisplayData::UNKNOWN;
 }
 
-bool M5Screen::hasLineBreak(enScreens nScreen, int i)
+// graph state of a field on current screen, charts get a history and a sprite for the plot area
+void M5Screen::initGraph(int idx)
 {
-    if (i < DisplayData::NUM_ELEMENTS)
+    const M5Layout::stField& field = m_pFields[idx];
+    M5Field::stGraph& graph = m_graph[idx];
+    memset(&graph, 0, sizeof(graph));
+    graph.rangeMin = field.rangeMin;
+    graph.rangeMax = field.rangeMax;
+    graph.lastPos  = -1;
+    if (!field.pField->IsChart())
+        return;
+
+    graph.bAutoRange = field.rangeMax <= field.rangeMin;
+    for (int h = 0; h < m_nHistories; h++)
+    {
+        if (m_historyId[h] == field.id)
+            graph.pHistory = &m_history[h];
+    }
+    int nChart = 0;
+    for (int i = 0; i < idx; i++)
     {
-        if (m_order[nScreen][i] != UNKNOWN)
-            return (m_order[nScreen][i] & NEWLINE ) ? true : false;
+        if (m_pFields[i].pField->IsChart())
+            nChart++;
+    }
+    if (nChart >= MAX_CHARTS)
+        return;
+    if (m_pChartSprite[nChart] == NULL)
+    {
+        m_pChartSprite[nChart] = new TFT_eSprite(&M5.Lcd);
+        m_pChartSprite[nChart]->setColorDepth(8);
+        if (m_pChartSprite[nChart]->createSprite(chartField.GraphWidth(), chartField.GraphHeight()) == NULL)
+        {
+            Serial.printf("Screen: no memory for chart\n");
+            delete m_pChartSprite[nChart];
+            m_pChartSprite[nChart] = NULL;
+            return;
+        }
     }
-    return false;
+    graph.pSprite = m_pChartSprite[nChart];
 }
 
-void M5Screen::Init(enScreens nScreen, DisplayData& dispData)
+void M5Screen::Init(int nScreen, DisplayData& dispData)
 {
     M5.Lcd.clear();
 
+    if (nScreen < 0 || nScreen >= m_layout.GetNumScreens())
+        nScreen = 0;
+    const M5Layout::stScreen& screen = m_layout.GetScreen(nScreen);
+
     // Hardware buttons
     UpdateHardwareButtons(nScreen);
 
     // Button bar 
-    enableButtonBar((nScreen == SCREEN_C) ? m_fnButtonBarEvent : NULL);
+    enableButtonBar((screen.flags & M5Layout::TRIPBAR) ? m_fnButtonBarEvent : NULL);
 
     // BT icon
     drawBluetoothIcon(m_lastBleStatus);
@@ -120,72 +345,55 @@ void M5Screen::Init(enScreens nScreen, DisplayData& dispData)
     // settings icon
     M5.Lcd.drawBitmap(M5.Lcd.width() - 26, 5, 20, 20, img_settings_map);  // 20x20 image
 
-    // reset lookup table
-    memset(m_idToIdx, -1, sizeof(m_idToIdx));
+    // switch to compiled render list and reset rendered values
+    m_nScreen = nScreen;
+    m_pDispData = &dispData;
+    m_pFields = m_layout.GetFields(nScreen);
+    m_nFields = screen.nFields;
+    memcpy(m_idToIdx, screen.idToIdx, sizeof(m_idToIdx));
+    for (int i = 0; i < m_nFields; i++)
+    {
+        m_fldRender[i].text[0] = '\0';
+        m_fldRender[i].bDirty = false;
+    }
 
-    // build layout from id order 
-    int i, x = 0, y = START_Y, bottom = 0;
-    for (i = 0; i < DisplayData::numElements; i++)
+    // render frame and buffered or empty value
+    for (int i = 0; i < m_nFields; i++)
     {
-        // get data id
-        DisplayData::enIds id = getIdFromIdx(nScreen, i);
-        if (id == DisplayData::UNKNOWN) // value not to be displayed on current screen
-            continue;
-        
-        // get data description
+        DisplayData::enIds id = (DisplayData::enIds)m_pFields[i].id;
         const DisplayData::stDisplayData* pDesc = dispData.GetDescription( id );
         if (pDesc == 0)
             continue;
-
-        // lookup for faster rendering of values
-        m_idToIdx[id] = i;
-
-        // needed field width 
-        if (pDesc->nWidth > 4)
-            m_fldRender[i].pField = &halfField;
-        else
-            m_fldRender[i].pField = &thirdField;
-
-        // field position
-        m_fldRender[i].y = y;
-        m_fldRender[i].x = x;
-
-        // wrap line
-        x += m_fldRender[i].pField->GetMetrics().rcBoundWidth;
-        if (x > M5.Lcd.width() || hasLineBreak(nScreen, i))
-        {
-            y += bottom;
-            x = m_fldRender[i].pField->GetMetrics().rcBoundWidth;
-            bottom = 0;
-            m_fldRender[i].y = y;
-            m_fldRender[i].x = 0;
-        }
-
-        // render frame and buffered or empty value
-        m_fldRender[i].pField->RenderFrame(m_fldRender[i].x, m_fldRender[i].y, pDesc);
+        m_pFields[i].pField->RenderFrame(m_pFields[i].x, m_pFields[i].y, pDesc);
+        initGraph(i);
         if(m_valueBuffer[id] != FLOAT_UNDEFINED )
-            ShowValue( id, m_valueBuffer[id], dispData );
+            renderValue( i, id, m_valueBuffer[id], pDesc );
         else
-            renderEmptyValue(m_fldRender[i], pDesc);
-
-        // remember bottom of highest element 
-        bottom = max(bottom, (int)m_fldRender[i].pField->GetMetrics().rcBoundHeight);
+            renderEmptyValue(i, pDesc);
+        if (m_pFields[i].pField->IsChart() || (m_pFields[i].pField->IsGraph() && m_graph[i].lastPos < 0))
+            m_pFields[i].pField->RenderGraph(m_pFields[i].x, m_pFields[i].y,
+                (m_valueBuffer[id] != FLOAT_UNDEFINED) ? m_valueBuffer[id] : 0.0f, m_graph[i], true);
     }
 
     m_showSysStatusCnt = 0;
 }
 
-void M5Screen::UpdateHardwareButtons(enScreens nScreen)
+// label of a button: current screen or its first screen
+void M5Screen::UpdateHardwareButtons(int nScreen)
 {
+    static const int xPos[3] = { 55, 160, 265 };
+
     M5.Lcd.setFreeFont(FF1);
     M5.Lcd.setTextSize(1);
     M5.Lcd.setTextDatum(TC_DATUM);
-    M5.Lcd.setTextColor((nScreen == SCREEN_A) ? TFT_WHITE : TFT_GREEN, TFT_BLACK);
-    M5.Lcd.drawString("Data A", 55, 224, 2);
-    M5.Lcd.setTextColor((nScreen == SCREEN_B) ? TFT_WHITE : TFT_GREEN, TFT_BLACK);
-    M5.Lcd.drawString("Data B", 160, 224, 2);
-    M5.Lcd.setTextColor((nScreen == SCREEN_C) ? TFT_WHITE : TFT_GREEN, TFT_BLACK);
-    M5.Lcd.drawString("Trip & Tune", 265, 224, 2);
+    for (int button = 0; button < 3; button++)
+    {
+        int n = (m_layout.GetScreen(nScreen).button == button) ? nScreen : m_layout.NextScreen(button, -1);
+        if (n < 0)
+            continue;
+        M5.Lcd.setTextColor((n == nScreen) ? TFT_WHITE : TFT_GREEN, TFT_BLACK);
+        M5.Lcd.drawString(m_layout.GetScreen(n).title, xPos[button], 224, 2);
+    }
 }
 
 void M5Screen::drawBluetoothIcon(LevoEsp32Ble::enBleStatus bleStatus)
@@ -231,9 +439,12 @@ bool M5Screen::ShowSysStatus()
             // mark value buffer as invalid
             ResetValueBuffer();
         }
-        drawBluetoothIcon(m_lastBleStatus);
+        if (!m_bHidden)
+            drawBluetoothIcon(m_lastBleStatus);
         ret = true; // indicate changed ble status 
     }
+    if (m_bHidden)
+        return ret;
 
     // trip button status
     updateTripButtonStatus();
@@ -317,16 +528,10 @@ bool M5Screen::ShowSysStatus()
             // clock display
             char timeStrbuff[20];
             M5.Lcd.setCursor(218 - 32, 8);
-            M5.Rtc.GetTime(&m_RTCtime_Now);
+            SysClock::GetTime(&m_RTCtime_Now);
             sprintf(timeStrbuff, "%02d:%02d:%02d", m_RTCtime_Now.Hours, m_RTCtime_Now.Minutes, m_RTCtime_Now.Seconds);
             M5.Lcd.println(timeStrbuff);
         }
     }
     return ret;
 }
-
-void M5Screen::ShowConfig(Preferences& prefs)
-{
-    M5ConfigForms forms;
-    forms.ShowMenu(prefs);
-}
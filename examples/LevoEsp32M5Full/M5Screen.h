@@ -13,21 +13,16 @@
 #include <M5Core2.h>
 #include <Preferences.h>
 #include "DisplayData.h"
+#include "DisplaySink.h"
 #include "M5Field.h"
+#include "M5Layout.h"
 #include "SystemStatus.h"
 #include "M5TripTuneButtons.h"
 
-class M5Screen
+class M5Screen : public DisplaySink
 {
 public:
-    typedef enum
-    {
-        UNDEFINED = -1,
-        SCREEN_A = 0,
-        SCREEN_B,
-        SCREEN_C,
-        NUM_SCREENS,
-    } enScreens;
+    enum { UNDEFINED = -1 }; // screen index
 
     typedef enum // keep consistent with code in M5TripTuneButtons (userData)
     {
@@ -40,19 +35,65 @@ public:
 protected:
     SystemStatus& m_sysStatus;
 
-    const int START_Y = 32;  // Y start position on screen
+    // values only update the model (m_valueBuffer), Update() draws the changed fields once per frame
+    const uint32_t FRAME_MS        = 66;   // 15 Hz
+    const uint32_t FRAME_MS_DIMMED = 1000; // backlight off
+    uint32_t m_frameMs     = FRAME_MS;
+    uint32_t m_tiNextFrame = 0L;
+    bool     m_bDirty      = false;        // any field changed since last frame
+
+    // layouts of all screens, compiled at load time
+    M5Layout m_layout;
+    int      m_nScreen = 0;
+    const M5Layout::stField* m_pFields = NULL; // render list of current screen
+    int      m_nFields = 0;
 
+    // render state of current screen, index as m_pFields
     typedef struct
     {
-        int x = 0;
-        int y = 0;
-        M5Field* pField = 0;
+        char     text[20] = "";   // last rendered value, empty: field needs a full redraw
+        uint8_t  style = M5Field::NORMAL;
+        bool     bDirty = false;
     } stRender;
     stRender m_fldRender[DisplayData::numElements];
+    M5Field::stGraph m_graph[DisplayData::numElements]; // gauge and chart state, index as m_pFields
+
+    // value history of all ids shown in charts on any screen
+    enum { MAX_HISTORIES = 6, MAX_CHARTS = 4 };
+    ValueHistory m_history[MAX_HISTORIES];
+    uint8_t      m_historyId[MAX_HISTORIES];
+    int          m_nHistories = 0;
+    uint32_t     m_tiSample = 0L;
+    TFT_eSprite* m_pChartSprite[MAX_CHARTS] = {}; // plot areas of current screen
+    void sampleHistory();
+    void initGraph(int idx);
+
+    DisplayData* m_pDispData = NULL;
+    void renderValue(int idx, DisplayData::enIds id, float val, const DisplayData::stDisplayData* pDesc);
+
+    // render statistics, SPI bytes are estimated from the pixel area (16 bit color)
+    struct stRenderStats
+    {
+        uint32_t nValues;
+        uint32_t nFull;
+        uint32_t nPartial;
+        uint32_t nSkipped;
+        uint32_t nMerged;      // values replaced before their frame was drawn
+        uint32_t nFrames;
+        uint32_t nDropped;     // frames missed because the loop was late
+        uint32_t usFrames;
+        uint32_t usMaxFrame;
+        uint32_t bytesSent;
+        uint32_t bytesSaved;
+        uint32_t usBlocked;    // CPU time in field rendering incl. waiting for the LCD
+        uint32_t usMaxBlocked;
+    };
+    stRenderStats m_stats = {};
+    void addBlockedTime(uint32_t usStart);
 
-    int m_idToIdx[DisplayData::numElements]; // lookup table for fast access from id to idx (for current screen only)
+    int8_t m_idToIdx[DisplayData::numElements]; // lookup table for fast access from id to idx (for current screen only)
 
-    void renderEmptyValue(stRender& render, const DisplayData::stDisplayData* pDesc );
+    void renderEmptyValue(int idx, const DisplayData::stDisplayData* pDesc );
     void formatAsTime(float val, size_t nLen, char * strVal);
 
     // counter for showing system Status to slow down refresh rate
@@ -65,6 +106,9 @@ protected:
     const float FLOAT_UNDEFINED = -10000.0f;
     float m_valueBuffer[ DisplayData::numElements ]; // index is value id
 
+    // no drawing while a form is open
+    bool m_bHidden = false;
+
     // last BLE status 
     LevoEsp32Ble::enBleStatus m_lastBleStatus = LevoEsp32Ble::UNDEFINED;
     void drawBluetoothIcon( LevoEsp32Ble::enBleStatus bleStatus );
@@ -75,96 +119,22 @@ protected:
     void enableButtonBar(void (*fnBtEvent)(Event&)) { m_tripTuneButtons.Enable(fnBtEvent); }
     void updateTripButtonStatus();
 
-    // field order on screens, unused elements must be UNKNOWN
-    const uint32_t NEWLINE = 0x80000000;
-    const uint32_t UNKNOWN = DisplayData::UNKNOWN;
-    bool hasLineBreak(enScreens nScreen, int i);
-    DisplayData::enIds getIdFromIdx(enScreens nScreen, int i);
-    const uint32_t m_order[NUM_SCREENS][DisplayData::numElements] =
-    {
-        {   // Screen A
-            DisplayData::BLE_MOT_SPEED,
-            DisplayData::BLE_RIDER_POWER,
-            DisplayData::BLE_MOT_POWER,
-            DisplayData::BLE_BATT_CURRENT,
-            DisplayData::BLE_BATT_VOLTAGE,
-            DisplayData::BLE_BATT_REMAINWH,
-            DisplayData::BLE_BATT_CHARGEPERCENT,
-            DisplayData::BLE_MOT_CADENCE,
-            DisplayData::BLE_MOT_ASSISTLEVEL,
-            DisplayData::BLE_MOT_ODOMETER,
-            DisplayData::BLE_BATT_TEMP,
-            DisplayData::BLE_MOT_TEMP,
-            DisplayData::BARO_ALTIMETER,
-            DisplayData::VIRT_INCLINATION,
-            DisplayData::VIRT_CONSUMPTION,
-            DisplayData::TRIP_RANGE,
-            DisplayData::PWR_POWER,
-            UNKNOWN, // DisplayData::BARO_TEMP, // DisplayData::GYRO_PITCH,
-            UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN,
-            UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN,
-            UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN,
-            UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN,
-            UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN,
-            UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN,
-        },
-        {   // Screen B
-            DisplayData::BLE_MOT_PEAKASSIST1,
-            DisplayData::BLE_MOT_PEAKASSIST2,
-            DisplayData::BLE_MOT_PEAKASSIST3,
-            DisplayData::BLE_BIKE_ASSISTLEV1 | NEWLINE,
-            DisplayData::BLE_BIKE_ASSISTLEV2,
-            DisplayData::BLE_BIKE_ASSISTLEV3,
-            DisplayData::BLE_BIKE_FAKECHANNEL | NEWLINE,
-            DisplayData::BLE_MOT_SHUTTLE,
-            DisplayData::BLE_BIKE_ACCEL,
-            DisplayData::BLE_BATT_SIZEWH | NEWLINE,
-            DisplayData::BLE_BIKE_WHEELCIRC,
-            DisplayData::BLE_BATT_CHARGECYCLES,
-            DisplayData::BLE_BATT_HEALTH,
-            UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN,
-            UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN,
-            UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN,
-            UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN,
-            UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN,
-            UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN,
-            UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN,
-        },
-        {   // Screen C
-            DisplayData::TRIP_DISTANCE,
-            DisplayData::TRIP_TIME,
-            DisplayData::TRIP_ELEVATIONGAIN,
-            DisplayData::TRIP_RIDERPOWER,
-            DisplayData::TRIP_AVGSPEED,
-            DisplayData::TRIP_MAXSPEED,
-            DisplayData::TRIP_MINBATTVOLTAGE,
-            DisplayData::TRIP_RIDERENERGY,
-            DisplayData::TRIP_BATTENERGY,
-            DisplayData::TRIP_PEAKMOTTEMP,
-            DisplayData::TRIP_PEAKBATTTEMP,
-            DisplayData::TRIP_PEAKBATTCURRENT,
-            DisplayData::TRIP_PEAKRIDERPOWER,
-            DisplayData::TRIP_PEAKMOTORPOWER,
-            DisplayData::TRIP_CONSUMPTION, // TRIP_MOTORENERGY,
-            UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN,
-            UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN,
-            UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN,
-            UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN,
-            UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN,
-            UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN,
-            UNKNOWN, UNKNOWN, UNKNOWN,
-        }
-    };
-
 public:
     M5Screen(SystemStatus& rSystemStatus) : m_sysStatus(rSystemStatus) { ResetValueBuffer(); }
 
-    void Init(enScreens nScreen, DisplayData& dispData );
+    bool LoadLayout(Preferences& prefs, DisplayData& dispData, bool bHasSDCard);
+    void Init(int nScreen, DisplayData& dispData );
+    int  NextScreen(int button, int nCurrent) { return m_layout.NextScreen(button, nCurrent); } // button 0..2: A..C
+
     void ShowValue( DisplayData::enIds id, float val, DisplayData& dispData );
+    void Update(uint32_t ti);        // draw a frame when due, call from every loop
+    void SetDimmed(bool bDimmed) { m_frameMs = bDimmed ? FRAME_MS_DIMMED : FRAME_MS; }
+    void PrintRenderStats();
+    void Benchmark(); // needs Init() before
     bool ShowSysStatus();
-    void ShowConfig(Preferences& prefs);
+    void SetHidden(bool bHidden) { m_bHidden = bHidden; } // a form owns the LCD, values are only buffered
     void ResetValueBuffer() { for( int i = 0; i < DisplayData::numElements; i++ ) m_valueBuffer[i] = FLOAT_UNDEFINED; }
-    void UpdateHardwareButtons(enScreens nScreen);
+    void UpdateHardwareButtons(int nScreen);
 
     void SetButtonBarHandler(void (*fnBtEvent)(Event&)) { m_fnButtonBarEvent = fnBtEvent; }
     void DisableButtonBar() { enableButtonBar( NULL ); }
@@ -11,6 +11,7 @@
 */
 
 #include "M5System.h"
+#include "SysClock.h"
 
 #include <Fonts/EVA_20px.h>
 #include <Fonts/EVA_11px.h>
@@ -24,47 +25,51 @@ TFT_eSprite DisCoverScrollbuff = TFT_eSprite(&M5.Lcd);
 // switch lcd backlight off after some time to save battery power
 void M5System::DoDisplayTimer()
 {
-    bool bKeepOn = M5.Axp.isACIN() && bBacklightCharging;
+    bool bKeepOn = bExternalPower && bBacklightCharging;
 
     // see https://github.com/m5stack/M5Core2/blob/master/src/AXP192.cpp
     if( tiDisplayOff == 0 || M5.Touch.ispressed() || bKeepOn )
     {
-        if( tiDisplayOff == UINT32_MAX )
+        if( tiDisplayOff == UINT64_MAX )
         {
             Serial.println( "turn backlight on");
             M5.Axp.SetLed(0);
             M5.Axp.SetDCDC3(true);  // lcd backlight light on
         }
-        tiDisplayOff = millis() + (uint32_t)backlightTimeout * 1000L;
+        tiDisplayOff = SysClock::Millis() + (uint64_t)backlightTimeout * 1000;
     }
 
     // check timeout
-    if (millis() > tiDisplayOff )
+    if (SysClock::Millis() > tiDisplayOff )
     {
         // Serial.println(tiDisplayOff);
         M5.Axp.SetDCDC3(false); // lcd backlight light off
         M5.Axp.SetLed( 1 );     // indicate unit is running
-        tiDisplayOff = UINT32_MAX;
+        tiDisplayOff = UINT64_MAX;
     }
 
 }
 
-void M5System::addI2cDevice(String name, uint8_t addr )
+void M5System::OnSettingChanged(Settings& settings, Settings::enIds id)
 {
-    i2cDevice_t *lastptr = &i2cParentptr;
-    
-    while(lastptr->nextPtr != nullptr )
+    switch (id)
     {
-        lastptr = lastptr->nextPtr;
+    case Settings::BACKLIGHT_TO:  backlightTimeout = settings.GetUInt(id); break;
+    case Settings::BACKLIGHT_CHG: bBacklightCharging = settings.GetBool(id); break;
+    default: return;
     }
-
-    i2cDevice_t* ptr = ( i2cDevice_t * )calloc(1,sizeof(i2cDevice_t));
-    ptr->Name = name;
-    ptr->addr = addr;
-    ptr->nextPtr = nullptr;
-    lastptr->nextPtr = ptr;
+    ResetDisplayTimer();
 }
 
+// Wire1 devices
+const M5System::stI2cDevice M5System::s_i2cDevices[] =
+{
+    { "Axp192",    0x34 },
+    { "CST Touch", 0x38 },
+    { "IMU6886",   0x68 },
+    { "BM8563",    0x51 },
+};
+
 void M5System::sysErrorSkip()
 {
     uint32_t bkColor16 = Disbuff.color565(0x22, 0x22, 0x22);
@@ -118,36 +123,33 @@ void M5System::coverScrollText(String strNext, uint32_t color)
     colorLast = color;
 }
 
+// only missing devices are shown
 int M5System::checkI2cAddr()
 {
-    uint8_t count = 0;
-    i2cDevice_t* lastptr = &i2cParentptr;
-    do {
-        lastptr = lastptr->nextPtr;
-        Serial.printf("Addr:0x%02X - Name:%s\r\n", lastptr->addr, lastptr->Name.c_str());
-        Wire1.beginTransmission(lastptr->addr);
-        if (Wire1.endTransmission() == 0)
-        {
-            String log = "I2C " + lastptr->Name + " Found";
-            coverScrollText(log, M5.Lcd.color565(SUCCESS_COLOR));
-        }
-        else
+    int nFailed = 0;
+    for (size_t i = 0; i < sizeof(s_i2cDevices) / sizeof(s_i2cDevices[0]); i++)
+    {
+        const stI2cDevice& dev = s_i2cDevices[i];
+        Wire1.beginTransmission(dev.addr);
+        bool bFound = Wire1.endTransmission() == 0;
+        Serial.printf("Addr:0x%02X - Name:%s - %s\r\n", dev.addr, dev.name, bFound ? "found" : "failed");
+        if (!bFound)
         {
-            String log = "I2C " + lastptr->Name + " Find failed";
-            coverScrollText(log, M5.Lcd.color565(FAILED_COLOR));
+            coverScrollText(String("I2C ") + dev.name + " Find failed", M5.Lcd.color565(FAILED_COLOR));
             sysErrorSkip();
+            nFailed++;
         }
-        delay(100);
-        count++;
-    } while (lastptr->nextPtr != nullptr);
-    return 0;
+    }
+    return nFailed;
 }
 
-void M5System::CheckPowerSupply(SystemStatus& sysStatus)
+// filtered AXP192 values, no I2C access
+void M5System::CheckPowerSupply(SystemStatus& sysStatus, M5Battery& battery)
 {
-    sysStatus.powerStatus = ( M5.Axp.isACIN()) ? SystemStatus::POWER_EXTERNAL : SystemStatus::POWER_INTERNAL;
-    sysStatus.batterVoltage = M5.Axp.GetBatVoltage();
-    sysStatus.batteryPercent = (sysStatus.batterVoltage < 3.2f ) ? 0 : (sysStatus.batterVoltage - 3.2f ) * 100;
+    bExternalPower = battery.IsExternalPower();
+    sysStatus.powerStatus = bExternalPower ? SystemStatus::POWER_EXTERNAL : SystemStatus::POWER_INTERNAL;
+    sysStatus.batterVoltage = battery.GetVoltage();
+    sysStatus.batteryPercent = battery.GetPercent();
 }
 
 void M5System::CheckSDCard(SystemStatus& sysStatus)
@@ -161,21 +163,12 @@ void M5System::CheckSDCard(SystemStatus& sysStatus)
 
 void M5System::Init()
 {
-    M5.begin(true, true, true, true);
+    // serial is started before, bluetooth scans already
+    M5.begin(true, true, false, true);
     M5.Lcd.fillScreen(BLACK);
 
-    M5.Axp.SetLed(1);
-    delay(100);
-    M5.Axp.SetLed(0);
-
     Disbuff.createSprite(320, 240);
 
-    // Wire1 devices
-    addI2cDevice("Axp192",0x34);
-    addI2cDevice("CST Touch",0x38);
-    addI2cDevice("IMU6886",0x68);
-    addI2cDevice("BM8563",0x51);
-
     M5.Axp.SetLcdVoltage(3300);
     SD.begin();
     M5.Axp.SetBusPowerMode(0);
@@ -185,10 +178,10 @@ void M5System::Init()
     M5.Axp.SetLDOVoltage(3, 3300);
 
     DisCoverScrollbuff.createSprite(320, 60);
-    checkI2cAddr();
     coverScrollText("LEVO BLE Version 0.99", M5.Lcd.color565(SUCCESS_COLOR));
+    checkI2cAddr();
     DisCoverScrollbuff.deleteSprite();
+    Disbuff.deleteSprite();
 
-    delay(500);
     M5.Lcd.fillScreen(BLACK);
 }
\ No newline at end of file
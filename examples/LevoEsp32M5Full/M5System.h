@@ -12,38 +12,35 @@
 
 #include <M5Core2.h>
 #include "SystemStatus.h"
+#include "Settings.h"
+#include "M5Battery.h"
 
 class M5System
 {
 public:
     void Init();
-    void CheckPowerSupply(SystemStatus& sysStatus);
+    void CheckPowerSupply(SystemStatus& sysStatus, M5Battery& battery);
     void CheckSDCard(SystemStatus& sysStatus);
     void DoDisplayTimer();
     void ResetDisplayTimer(){ tiDisplayOff = 0; DoDisplayTimer();  }
+    bool IsDisplayOff() { return tiDisplayOff == UINT64_MAX; }
     void SetBacklightSettings( uint16_t backlightTo, bool bBacklightChg ) { backlightTimeout = backlightTo; bBacklightCharging = bBacklightChg; }
+    void OnSettingChanged(Settings& settings, Settings::enIds id);
 
 protected:
-    typedef struct i2cDevice
+    typedef struct
     {
-        i2cDevice() {
-            Name = "";
-            addr = 0;
-            nextPtr = nullptr;
-        };
-        String Name;
-        uint8_t addr;
-        struct i2cDevice* nextPtr;
-    } i2cDevice_t;
-    
-    i2cDevice_t i2cParentptr;
-
-    void addI2cDevice(String name, uint8_t addr);
+        const char* name;
+        uint8_t     addr;
+    } stI2cDevice;
+    static const stI2cDevice s_i2cDevices[];
+
     int  checkI2cAddr();
     void coverScrollText(String strNext, uint32_t color);
     void sysErrorSkip();
 
-    uint32_t tiDisplayOff = 0L;
+    uint64_t tiDisplayOff = 0L; // SysClock::Millis()
+    bool     bExternalPower = false;
 
     // settings from peferences
     bool     bBacklightCharging = true;
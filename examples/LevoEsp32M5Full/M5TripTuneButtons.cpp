@@ -9,6 +9,7 @@
 
 #include <M5Core2.h>
 #include "M5TripTuneButtons.h"
+#include "M5ButtonPool.h"
 
 void M5TripTuneButtons::SetButtonState(enButtons btId, bool bChecked)
 {
@@ -38,6 +39,8 @@ void M5TripTuneButtons::Enable(void (*fnBtEvent)(Event&))
         createButtons();
         for (i = 0; i < nButtons; i++)
         {
+            if (pButtons[i] == NULL)
+                continue;
             pButtons[i]->on  = on_clrs;
             pButtons[i]->off = off_clrs;
             pButtons[i]->addHandler(fnBtEvent, E_TOUCH);
@@ -51,15 +54,16 @@ void M5TripTuneButtons::Enable(void (*fnBtEvent)(Event&))
 void M5TripTuneButtons::createButtons()
 {
     const int START_Y = 188;
+    const ButtonColors noDraw = { NODRAW, NODRAW, NODRAW };
+    static const char* labels[nButtons] = { "Start", "Stop", "Finish", "Tune" };
+    static const int16_t xPos[nButtons] = { 6, 90, 170, 248 };
     deleteButtons();
-    pButtons[BTSTART]  = new Button(   6, START_Y, 68, 28, false, "Start",  { NODRAW, NODRAW, NODRAW }, { NODRAW, NODRAW, NODRAW }, TC_DATUM, 0, 0, 0xFF );
-    pButtons[BTSTOP]   = new Button(  90, START_Y, 68, 28, false, "Stop",   { NODRAW, NODRAW, NODRAW }, { NODRAW, NODRAW, NODRAW }, TC_DATUM, 0, 0, 0xFF );
-    pButtons[BTFINISH] = new Button( 170, START_Y, 68, 28, false, "Finish", { NODRAW, NODRAW, NODRAW }, { NODRAW, NODRAW, NODRAW }, TC_DATUM, 0, 0, 0xFF );
-    pButtons[BTTUNE]   = new Button( 248, START_Y, 68, 28, false, "Tune",   { NODRAW, NODRAW, NODRAW }, { NODRAW, NODRAW, NODRAW }, TC_DATUM, 0, 0, 0xFF );
-    pButtons[BTSTART]->userData  = BTSTART;
-    pButtons[BTSTOP]->userData   = BTSTOP;
-    pButtons[BTFINISH]->userData = BTFINISH;
-    pButtons[BTTUNE]->userData   = BTTUNE;
+    for (int i = 0; i < nButtons; i++)
+    {
+        pButtons[i] = M5ButtonPool::Get( xPos[i], START_Y, 68, 28, labels[i], noDraw, noDraw, TC_DATUM, 0, 0, 0xFF );
+        if (pButtons[i])
+            pButtons[i]->userData = i; // enButtons
+    }
     stateMask = 0;
 };
 
@@ -70,11 +74,8 @@ void M5TripTuneButtons::deleteButtons()
     {
         if( pButtons[i] != NULL )
         {
-            pButtons[i]->delHandlers();
             pButtons[i]->erase();
-            delete pButtons[i];
-            pButtons[i] = NULL;
+            M5ButtonPool::Release(pButtons[i]);
         }
     }
 }
-
@@ -0,0 +1,155 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * Math kernel: table based barometric formula and air density,
+ * bike power model for single points and for whole trip segments
+ *
+ * Tables are linear interpolated, max. error compared to pow():
+ * altitude < 5cm, sealevel pressure < 0.01 hPa, air density < 0.0001 kg/m^3
+ *
+ */
+
+#include "PowerMath.h"
+
+const float PowerMath::RATIO_MIN = 0.45f;  // ~ 6500m
+const float PowerMath::RATIO_MAX = 1.10f;  // ~ -800m
+const float PowerMath::ALT_MIN   = -500.0f;
+const float PowerMath::ALT_STEP  = 25.0f;  // -500m ... 6000m
+
+float PowerMath::s_ratioTable[RATIO_TABLESIZE + 1];
+float PowerMath::s_pressureTable[ALT_TABLESIZE + 1];
+bool  PowerMath::s_bInit = false;
+
+static const float GRAVITY       = 9.81f;
+static const float GAS_CONST_AIR = 287.058f; // J/(kg*K)
+static const float KELVIN        = 273.15f;
+
+void PowerMath::Init()
+{
+    int i;
+    if (s_bInit)
+        return;
+
+    for (i = 0; i <= RATIO_TABLESIZE; i++)
+    {
+        float ratio = RATIO_MIN + (RATIO_MAX - RATIO_MIN) * i / RATIO_TABLESIZE;
+        s_ratioTable[i] = pow(ratio, 0.1903);
+    }
+
+    for (i = 0; i <= ALT_TABLESIZE; i++)
+    {
+        float altitude = ALT_MIN + ALT_STEP * i;
+        s_pressureTable[i] = 1013.25 * pow(1.0 - (altitude / 44330.0), 5.255);
+    }
+
+    s_bInit = true;
+}
+
+// pos is a fractional index within 0...tableSize
+float PowerMath::interpolate(const float* pTable, int tableSize, float pos)
+{
+    int idx = (int)pos;
+    if (idx >= tableSize)
+        idx = tableSize - 1;
+    float frac = pos - idx;
+    return pTable[idx] + (pTable[idx + 1] - pTable[idx]) * frac;
+}
+
+float PowerMath::standardPressure(float altitude)
+{
+    float pos = (altitude - ALT_MIN) / ALT_STEP;
+    if (!s_bInit || pos < 0.0f || pos > ALT_TABLESIZE)
+        return 1013.25 * pow(1.0 - (altitude / 44330.0), 5.255);
+    return interpolate(s_pressureTable, ALT_TABLESIZE, pos);
+}
+
+float PowerMath::AltitudeFromPressure(float hPa, float sealevelhPa)
+{
+    float ratio = hPa / sealevelhPa;
+    if (!s_bInit || ratio < RATIO_MIN || ratio > RATIO_MAX)
+        return AltitudeFromPressurePow(hPa, sealevelhPa);
+
+    float pos = (ratio - RATIO_MIN) * (RATIO_TABLESIZE / (RATIO_MAX - RATIO_MIN));
+    return 44330.0f * (1.0f - interpolate(s_ratioTable, RATIO_TABLESIZE, pos));
+}
+
+float PowerMath::SealevelFromAltitude(float hPa, float altitude)
+{
+    return hPa * 1013.25f / standardPressure(altitude);
+}
+
+float PowerMath::AirDensity(float altitude, float airTemp)
+{
+    return (standardPressure(altitude) * 100.0f) / (GAS_CONST_AIR * (airTemp + KELVIN));
+}
+
+// P = v * ( m * g * (cR * cos(a) + sin(a)) + m * accel + 1/2 * rho * cwA * v^2 )
+float PowerMath::Power(const stModel& model, float speed, float inclinationPercent, float altitude, float airTemp, float accel)
+{
+    float incl    = inclinationPercent * 0.01f;
+    float cosIncl = 1.0f / sqrtf(1.0f + incl * incl); // cos(atan(x)), no trigonometric functions needed
+    float sinIncl = incl * cosIncl;
+    float rho     = AirDensity(altitude, airTemp);
+
+    float force = model.mass * (GRAVITY * (model.cR * cosIncl + sinIncl) + accel) + 0.5f * rho * model.cwA * speed * speed;
+    return force * speed;
+}
+
+float PowerMath::PowerSegments(const stModel& model, const stSegments& seg, float* pPower)
+{
+    size_t i;
+    if (seg.nSegments == 0)
+        return 0.0f;
+
+    // air density first: table lookups only
+    for (i = 0; i < seg.nSegments; i++)
+        pPower[i] = AirDensity(seg.altitude[i], seg.airTemp[i]);
+
+    // power and energy: plain arithmetic on arrays
+    float massG     = model.mass * GRAVITY;
+    float lastSpeed = seg.speed[0];
+    float energyWs  = 0.0f;
+    for (i = 0; i < seg.nSegments; i++)
+    {
+        float v       = seg.speed[i];
+        float dt      = seg.duration[i];
+        float accel   = (dt > 0.0f) ? (v - lastSpeed) / dt : 0.0f;
+        float incl    = seg.inclination[i] * 0.01f;
+        float cosIncl = 1.0f / sqrtf(1.0f + incl * incl);
+        float sinIncl = incl * cosIncl;
+
+        float force = massG * (model.cR * cosIncl + sinIncl) + model.mass * accel + 0.5f * pPower[i] * model.cwA * v * v;
+        float power = force * v;
+
+        pPower[i]  = power;
+        energyWs  += (power > 0.0f) ? power * dt : 0.0f;
+        lastSpeed  = v;
+    }
+
+    return energyWs / 3600.0f;
+}
+
+float PowerMath::AltitudeFromPressurePow(float hPa, float sealevelhPa)
+{
+    return 44330 * (1.0 - pow(hPa / sealevelhPa, 0.1903));
+}
+
+float PowerMath::SealevelFromAltitudePow(float hPa, float altitude)
+{
+    return hPa / pow(1.0 - (altitude / 44330.0), 5.255);
+}
+
+float PowerMath::AirDensityPow(float altitude, float airTemp)
+{
+    return (101325.0 * pow(1.0 - (altitude / 44330.0), 5.255)) / (GAS_CONST_AIR * (airTemp + KELVIN));
+}
+
+float PowerMath::PowerPow(const stModel& model, float speed, float inclinationPercent, float altitude, float airTemp, float accel)
+{
+    double angle = atan(inclinationPercent / 100.0);
+    double rho   = AirDensityPow(altitude, airTemp);
+    double force = model.mass * (GRAVITY * (model.cR * cos(angle) + sin(angle)) + accel) + 0.5 * rho * model.cwA * speed * speed;
+    return force * speed;
+}
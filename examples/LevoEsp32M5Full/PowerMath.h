@@ -0,0 +1,79 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * Math kernel: table based barometric formula and air density,
+ * bike power model for single points and for whole trip segments
+ *
+ */
+
+#ifndef POWERMATH_H
+#define POWERMATH_H
+
+#include "Arduino.h"
+
+class PowerMath
+{
+public:
+    // bike and rider parameters of the power model
+    struct stModel
+    {
+        float mass; // system mass (kg)
+        float cR;   // coeff for roll resistance
+        float cwA;  // coeff for air resistance * surface
+    };
+
+    // trip segments as structure of arrays, all arrays have nSegments elements
+    struct stSegments
+    {
+        const float* speed;       // m/s
+        const float* inclination; // percent
+        const float* altitude;    // m
+        const float* airTemp;     // degree celsius
+        const float* duration;    // s
+        size_t       nSegments;
+    };
+
+    static void Init(); // build lookup tables, called once at startup
+
+    // barometric formula (hPa, m)
+    static float AltitudeFromPressure(float hPa, float sealevelhPa);
+    static float SealevelFromAltitude(float hPa, float altitude);
+
+    // air density in kg/m^3 for altitude (m) and air temperature (degree celsius)
+    static float AirDensity(float altitude, float airTemp);
+
+    // power (W) for one point, speed in m/s, acceleration in m/s^2
+    static float Power(const stModel& model, float speed, float inclinationPercent, float altitude, float airTemp, float accel = 0.0f);
+
+    // power (W) for all segments into pPower[], acceleration is taken from speed change between segments
+    // returns positive energy (Wh) of all segments
+    static float PowerSegments(const stModel& model, const stSegments& seg, float* pPower);
+
+    // reference implementation with pow() and trigonometric functions, compared by "levobench -p"
+    static float AltitudeFromPressurePow(float hPa, float sealevelhPa);
+    static float SealevelFromAltitudePow(float hPa, float altitude);
+    static float AirDensityPow(float altitude, float airTemp);
+    static float PowerPow(const stModel& model, float speed, float inclinationPercent, float altitude, float airTemp, float accel = 0.0f);
+
+protected:
+    // pressure ratio p/p0 -> (p/p0)^0.1903
+    static const int   RATIO_TABLESIZE = 256;
+    static const float RATIO_MIN;
+    static const float RATIO_MAX;
+    static float       s_ratioTable[RATIO_TABLESIZE + 1];
+
+    // altitude -> standard pressure (hPa)
+    static const int   ALT_TABLESIZE = 260;
+    static const float ALT_MIN;
+    static const float ALT_STEP;
+    static float       s_pressureTable[ALT_TABLESIZE + 1];
+
+    static bool s_bInit;
+
+    static float interpolate(const float* pTable, int tableSize, float pos);
+    static float standardPressure(float altitude);
+};
+
+#endif // POWERMATH_H
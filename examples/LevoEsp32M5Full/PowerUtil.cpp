@@ -8,9 +8,9 @@
  */
 
 #include <M5Core2.h>
-#include <Preferences.h>
 #include "DisplayData.h"
 #include "PowerUtil.h"
+#include "SysClock.h"
 
 void PowerUtil::DumpEta(float eta)
 {
@@ -37,8 +37,8 @@ void PowerUtil::DumpPoints(const char* title, BikeResistance::measurePoints& p,
     char filename[20];
     RTC_TimeTypeDef RTC_Time;
     RTC_DateTypeDef RTC_Date;
-    M5.Rtc.GetDate(&RTC_Date);
-    M5.Rtc.GetTime(&RTC_Time);
+    SysClock::GetDate(&RTC_Date);
+    SysClock::GetTime(&RTC_Time);
     snprintf(filename, sizeof(filename), "/%02d%02d%02d.cal", RTC_Date.Date, RTC_Date.Month, (uint8_t)(RTC_Date.Year - 2000));
 
     // open file in append mode
@@ -61,55 +61,61 @@ void PowerUtil::DumpPoints(const char* title, BikeResistance::measurePoints& p,
         Serial.printf("cR: %f\tcwA: %f\r\n", cR, cwA);
 }
 
-void PowerUtil::SysParamsInit(Preferences& prefs)
+void PowerUtil::SysParamsInit(Settings& settings)
+{
+    for (int i = Settings::SP_MASS; i <= Settings::SP_ETA; i++)
+        OnSettingChanged(settings, (Settings::enIds)i);
+}
+
+// session timestamp to etalog.txt, SD card must be ready
+void PowerUtil::WriteEtaLogHeader()
 {
-    m_sysParams.mass             = prefs.getFloat("Sp_mass", 110.0 );
-    m_sysParams.cR               = prefs.getFloat("Sp_cR", 0.009725 );
-    m_sysParams.cwA              = prefs.getFloat("Sp_cwA", 0.437392);
-    m_sysParams.avgRiderPower    = prefs.getFloat("Sp_avgRdPower", 100.0 );
-    m_sysParams.defaultAirTemp   = prefs.getFloat("Sp_defAirTemp", 18.0 );
-    m_sysParams.defaultAltitude  = prefs.getFloat("Sp_defAlt", 520.0);
-    m_sysParams.nCalibrationRuns = prefs.getUChar("Sp_nRuns", 4 );
-    m_sysParams.eta              = prefs.getFloat("Sp_eta", 0.6 );
-    m_bikePower.SetSystemParams( m_sysParams.mass, m_sysParams.cR, m_sysParams.cwA );
-
-    Serial.printf( "Sp_mass: %f\r\n",       m_sysParams.mass );
-    Serial.printf( "Sp_cR: %f\r\n",         m_sysParams.cR );
-    Serial.printf( "Sp_cwA: %f\r\n",        m_sysParams.cwA );
-    Serial.printf( "Sp_avgRdPower: %f\r\n", m_sysParams.avgRiderPower );
-    Serial.printf( "Sp_defAirTemp: %f\r\n", m_sysParams.defaultAirTemp );
-    Serial.printf( "Sp_defAlt: %f\r\n",     m_sysParams.defaultAltitude );
-    Serial.printf( "Sp_nRuns: %d\r\n",      m_sysParams.nCalibrationRuns );
-    Serial.printf( "Sp_eta: %f\r\n",        m_sysParams.eta );
-
-    // write timestamp to etalog.txt
     File dataFile = SD.open("/EtaLog.txt", FILE_APPEND);
     if (dataFile)
     {
         RTC_TimeTypeDef RTC_Time;
         RTC_DateTypeDef RTC_Date;
-        M5.Rtc.GetDate(&RTC_Date);
-        M5.Rtc.GetTime(&RTC_Time);
+        SysClock::GetDate(&RTC_Date);
+        SysClock::GetTime(&RTC_Time);
         dataFile.printf("--- %02d.%02d.%04d %02d:%02d:%02d --- \r\n", RTC_Date.Date, RTC_Date.Month, RTC_Date.Year, RTC_Time.Hours, RTC_Time.Minutes, RTC_Time.Seconds);
         dataFile.close();
     }
 }
 
-void PowerUtil::CalibrationSave( Preferences& prefs, float cR, float cwA )
+// parameters are applied by the settings listener, see OnSettingChanged()
+void PowerUtil::CalibrationSave( Settings& settings, float cR, float cwA )
 {
-    m_sysParams.cR  = cR;
-    m_sysParams.cwA = cwA;
-    prefs.putFloat("Sp_cR",  m_sysParams.cR);
-    prefs.putFloat("Sp_cwA", m_sysParams.cwA);
+    settings.SetFloat(Settings::SP_CR,  cR);
+    settings.SetFloat(Settings::SP_CWA, cwA);
 }
 
-void PowerUtil::EtaSave(Preferences& prefs, float eta)
+void PowerUtil::EtaSave(Settings& settings, float eta)
 {
-    m_sysParams.eta = eta;
-    prefs.putFloat("Sp_eta", m_sysParams.eta);
+    settings.SetFloat(Settings::SP_ETA, eta);
     // Serial.printf("eta saved: %f\r\n", eta );
 }
 
+// only the affected parameter, running calibration and energy counters are kept
+void PowerUtil::OnSettingChanged(Settings& settings, Settings::enIds id)
+{
+    switch (id)
+    {
+    case Settings::SP_MASS:        m_sysParams.mass = m_model.mass = settings.GetFloat(id); break;
+    case Settings::SP_CR:          m_sysParams.cR = m_model.cR = settings.GetFloat(id); break;
+    case Settings::SP_CWA:         m_sysParams.cwA = m_model.cwA = settings.GetFloat(id); break;
+    case Settings::SP_AVG_RDPOWER: m_sysParams.avgRiderPower = settings.GetFloat(id); break;
+    case Settings::SP_DEF_AIRTEMP: m_sysParams.defaultAirTemp = settings.GetFloat(id); break;
+    case Settings::SP_DEF_ALT:     m_sysParams.defaultAltitude = settings.GetFloat(id); break;
+    case Settings::SP_NRUNS:       m_sysParams.nCalibrationRuns = settings.GetUInt(id); break;
+    case Settings::SP_ETA:         m_sysParams.eta = settings.GetFloat(id); break;
+    default: break;
+    }
+#ifdef POWERUTIL_BIKEPOWER
+    if (id == Settings::SP_MASS || id == Settings::SP_CR || id == Settings::SP_CWA)
+        m_bikePower.SetSystemParams(m_sysParams.mass, m_sysParams.cR, m_sysParams.cwA);
+#endif
+}
+
 void PowerUtil::EnableCalibrationMode(bool bEnable )
 {
     int i;
@@ -254,6 +260,16 @@ void PowerUtil::FeedValue(DisplayData::enIds id, float fVal, uint32_t timestamp)
     }
 }
 
+// energy integration continues with the next Update()
+void PowerUtil::SetEnergyState(const stEnergyState& state)
+{
+    m_calcEnergy     = state.calcEnergy;
+    m_riderEnergy    = state.riderEnergy;
+    m_startRemainWh  = state.startRemainWh;
+    m_lastRemainWh   = state.lastRemainWh;
+    m_lastUpdateTime = 0;
+}
+
 // calc correction factor between measured electric energy and rider energy and calculated energy
 // in theory this is "eta" aka efficiency, in practice it is a try to correct measurement errors
 void PowerUtil::calcEfficiency(float calcPower, uint32_t timestamp)
@@ -298,7 +314,16 @@ void PowerUtil::calcEfficiency(float calcPower, uint32_t timestamp)
 bool PowerUtil::Update(DisplayData::enIds& id, float& fVal, uint32_t timestamp)
 {
     // curent power
+#ifdef POWERUTIL_BIKEPOWER
     fVal = m_bikePower.CurrentPower( m_lastSpeed/3.6, m_lastInclinationPercent, m_lastAltitude, m_lastAirTemp, timestamp );
+#else
+    float speed = m_lastSpeed/3.6;
+    float accel = 0.0;
+    if( m_lastUpdateTime != 0 && timestamp != m_lastUpdateTime )
+        accel = (speed - m_lastPowerSpeed) / ((float)(timestamp - m_lastUpdateTime) / 1000.0);
+    fVal = PowerMath::Power( m_model, speed, m_lastInclinationPercent, m_lastAltitude, m_lastAirTemp, accel );
+    m_lastPowerSpeed = speed;
+#endif
     id   = DisplayData::PWR_POWER;
 
     // efficiency
@@ -380,3 +405,13 @@ bool PowerUtil::calibrationCalc(float& cR, float& cwA)
 
     return ret;
 }
+
+void PowerUtil::GetRouteParams(RoutePlanner::stParams& params)
+{
+    RoutePlanner::InitParams(params);
+    params.model      = m_model;
+    params.eta        = m_sysParams.eta;
+    params.riderPower = m_sysParams.avgRiderPower;
+    params.airTemp    = m_lastAirTemp;
+    params.remainWh   = m_lastRemainWh;
+}
@@ -11,8 +11,13 @@
 #define POWERUTIL_H
 
 #include <BikePowerCalc.h>
-#include <Preferences.h>
 #include "DisplayData.h"
+#include "PowerMath.h"
+#include "RoutePlanner.h"
+#include "Settings.h"
+
+// current power from BikePowerCalc instead of the PowerMath tables, both are compared by "levobench -p"
+// #define POWERUTIL_BIKEPOWER
 
 class PowerUtil
 {
@@ -39,9 +44,11 @@ public:
     };
 
     // system parameters
-    void SysParamsInit( Preferences & prefs );
-    void CalibrationSave(Preferences& prefs, float cR, float cwA );
-    void EtaSave(Preferences& prefs, float eta);
+    void SysParamsInit( Settings & settings );
+    void WriteEtaLogHeader();
+    void CalibrationSave(Settings& settings, float cR, float cwA );
+    void EtaSave(Settings& settings, float eta);
+    void OnSettingChanged(Settings& settings, Settings::enIds id); // single parameter changed
 
     // calibration 
     void EnableCalibrationMode( bool bEnable ); // start/stop calibration mode
@@ -55,9 +62,19 @@ public:
     void FeedValue(DisplayData::enIds id, float fVal, uint32_t timestamp); // value from any other sensor
     bool Update(DisplayData::enIds& id, float& fVal, uint32_t timestamp);  // poll PowerUtil sensor values
 
-    // todo
-    // sensor values: current calculated power for a point via feed/update
-    // calculations: energy for a gpx route / plot position -> altitude/energy for a route
+    // energy and efficiency state of the ride for checkpoints
+    struct stEnergyState
+    {
+        float    calcEnergy;
+        float    riderEnergy;
+        uint32_t startRemainWh;
+        uint32_t lastRemainWh;
+    };
+    void GetEnergyState(stEnergyState& state) { state = { m_calcEnergy, m_riderEnergy, m_startRemainWh, m_lastRemainWh }; }
+    void SetEnergyState(const stEnergyState& state);
+
+    // route energy prediction with current system params and battery state
+    void GetRouteParams(RoutePlanner::stParams& params);
 
 protected:
 
@@ -104,7 +121,11 @@ protected:
     void DumpEta( float eta );
 
     // for power calculation
+#ifdef POWERUTIL_BIKEPOWER
     BikePower m_bikePower;
+#endif
+    PowerMath::stModel m_model = { m_sysParams.mass, m_sysParams.cR, m_sysParams.cwA };
+    float     m_lastPowerSpeed = 0.0; // m/s, for acceleration
     float     m_lastInclinationPercent = 0.0;
     float     m_lastAirTemp = m_sysParams.defaultAirTemp;
     float     m_lastAltitude = m_sysParams.defaultAltitude;
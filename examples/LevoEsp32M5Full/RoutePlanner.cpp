@@ -0,0 +1,338 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * Route energy planner: predict battery consumption for a GPX track
+ *
+ */
+
+#include <M5Core2.h>
+#include "RoutePlanner.h"
+
+static const double EARTH_RADIUS = 6371000.0; // m
+static const double DEG_TO_RAD_D = 0.017453292519943295;
+
+void RoutePlanner::InitParams(stParams& params)
+{
+    params.model.mass   = 110.0;
+    params.model.cR     = 0.009725;
+    params.model.cwA    = 0.437392;
+    params.eta          = 0.6;
+    params.riderPower   = 100.0;
+    params.maxPower     = 400.0;
+    params.speed        = 20.0;
+    params.airTemp      = 18.0;
+    params.remainWh     = 0.0;
+    params.resampleDist = 50.0;
+}
+
+bool RoutePlanner::Begin(const char* filename, const stParams& params, stResult& result)
+{
+    memset(&result, 0, sizeof(result));
+    m_pParams = &params;
+    m_pResult = &result;
+
+    // reset parser and resampling state
+    m_tagLen = m_textLen = 0;
+    m_bInTag = m_bInEle = m_bInPoint = false;
+    m_ele = 0.0;
+    m_bHasPrev = m_bHasSample = false;
+    m_trackDist = m_nextSampleDist = 0.0;
+    m_nBlock = 0;
+    m_profileStep = 1;
+
+    m_gpxFile = SD.open(filename, FILE_READ);
+    if (!m_gpxFile)
+    {
+        Serial.printf("Route: can't open: %s\r\n", filename);
+        return false;
+    }
+    return true;
+}
+
+// stream file in small chunks, at least one per step
+bool RoutePlanner::Step(uint32_t maxMs)
+{
+    if (!m_gpxFile)
+        return false;
+
+    uint32_t tiStart = millis();
+    do
+    {
+        int nRead = m_gpxFile.read((uint8_t*)m_readBuf, sizeof(m_readBuf));
+        if (nRead <= 0)
+        {
+            m_gpxFile.close();
+            finish();
+            m_pResult->tiCalc += millis() - tiStart;
+            Serial.printf("Route: %lu points, %lu segments, %.2f km, %.0f hm, %.0f Wh, range %.1f km, %lu ms\r\n",
+                (unsigned long)m_pResult->nTrackPoints, (unsigned long)m_pResult->nSegments, m_pResult->distance, m_pResult->elevationGain,
+                m_pResult->energyWh, m_pResult->range, (unsigned long)m_pResult->tiCalc);
+            return false;
+        }
+        parse(m_readBuf, nRead);
+    } while (millis() - tiStart < maxMs);
+
+    m_pResult->tiCalc += millis() - tiStart;
+    return true;
+}
+
+void RoutePlanner::finish()
+{
+    stResult& result = *m_pResult;
+
+    // last track point closes the route
+    if (m_bHasPrev && m_trackDist > m_sampleDist)
+        addSample(m_trackDist, m_prevLat, m_prevLon, m_prevEle);
+    flushBlock();
+
+    // range with remaining battery energy
+    if (result.bBatteryEmpty)
+        result.range = result.emptyDistance;
+    else if (result.energyWh > 0.0)
+        result.range = result.distance + (m_pParams->remainWh - result.energyWh) * result.distance / result.energyWh;
+}
+
+bool RoutePlanner::Plan(const char* filename, const stParams& params, stResult& result)
+{
+    if (!Begin(filename, params, result))
+        return false;
+    while (Step(UINT32_MAX))
+        ;
+    return result.nSegments > 0;
+}
+
+// character based parser, tags and text may be split across read buffers
+void RoutePlanner::parse(const char* pBuf, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        char c = pBuf[i];
+        if (m_bInTag)
+        {
+            if (c == '>')
+            {
+                m_tag[m_tagLen] = '\0';
+                m_bInTag = false;
+                onTag();
+            }
+            else if (m_tagLen < TAG_SIZE - 1) // long tags are truncated, lat/lon are always at the beginning
+                m_tag[m_tagLen++] = c;
+        }
+        else if (c == '<')
+        {
+            m_bInTag = true;
+            m_tagLen = 0;
+        }
+        else if (m_bInEle && m_textLen < TEXT_SIZE - 1)
+            m_text[m_textLen++] = c;
+    }
+}
+
+static bool isTag(const char* tag, const char* name, size_t len)
+{
+    return strncmp(tag, name, len) == 0 && (tag[len] == '\0' || tag[len] == ' ' || tag[len] == '/' || tag[len] == '\t' || tag[len] == '\r' || tag[len] == '\n');
+}
+
+bool RoutePlanner::getAttribute(const char* name, double& value)
+{
+    size_t len = strlen(name);
+    const char* p = m_tag;
+    while ((p = strstr(p, name)) != NULL)
+    {
+        // attribute name must be preceeded by white space and followed by ="
+        if (p > m_tag && isspace(*(p - 1)) && p[len] == '=' && (p[len + 1] == '"' || p[len + 1] == '\''))
+        {
+            value = strtod(p + len + 2, NULL);
+            return true;
+        }
+        p += len;
+    }
+    return false;
+}
+
+void RoutePlanner::onTag()
+{
+    // track or route point
+    if (isTag(m_tag, "trkpt", 5) || isTag(m_tag, "rtept", 5))
+    {
+        m_bInPoint = getAttribute("lat", m_lat) && getAttribute("lon", m_lon);
+        if (m_bInPoint && m_tag[m_tagLen - 1] == '/') // <trkpt lat="" lon=""/> without elevation
+        {
+            onTrackPoint(m_lat, m_lon, m_ele);
+            m_bInPoint = false;
+        }
+    }
+    else if (m_bInPoint && isTag(m_tag, "ele", 3))
+    {
+        m_bInEle  = true;
+        m_textLen = 0;
+    }
+    else if (m_bInEle && isTag(m_tag, "/ele", 4))
+    {
+        m_text[m_textLen] = '\0';
+        m_ele = strtod(m_text, NULL);
+        m_bInEle = false;
+    }
+    else if (m_bInPoint && (isTag(m_tag, "/trkpt", 6) || isTag(m_tag, "/rtept", 6)))
+    {
+        onTrackPoint(m_lat, m_lon, m_ele);
+        m_bInPoint = false;
+    }
+}
+
+// resample track to equidistant points
+void RoutePlanner::onTrackPoint(double lat, double lon, float ele)
+{
+    m_pResult->nTrackPoints++;
+
+    if (!m_bHasPrev)
+    {
+        m_prevLat = lat; m_prevLon = lon; m_prevEle = ele;
+        m_bHasPrev = true;
+        addSample(0.0, lat, lon, ele);
+        m_nextSampleDist = m_pParams->resampleDist;
+        return;
+    }
+
+    // equirectangular approximation, good enough for distances between track points
+    double dx = (lon - m_prevLon) * DEG_TO_RAD_D * cos((lat + m_prevLat) * 0.5 * DEG_TO_RAD_D);
+    double dy = (lat - m_prevLat) * DEG_TO_RAD_D;
+    double dist = sqrt(dx * dx + dy * dy) * EARTH_RADIUS;
+
+    while (dist > 0.0 && m_trackDist + dist >= m_nextSampleDist)
+    {
+        double f = (m_nextSampleDist - m_trackDist) / dist;
+        addSample(m_nextSampleDist, m_prevLat + (lat - m_prevLat) * f, m_prevLon + (lon - m_prevLon) * f, m_prevEle + (ele - m_prevEle) * f);
+        m_nextSampleDist += m_pParams->resampleDist;
+    }
+
+    m_trackDist += dist;
+    m_prevLat = lat; m_prevLon = lon; m_prevEle = ele;
+}
+
+// speed is limited uphill by max. power
+float RoutePlanner::segmentSpeed(float inclinationPercent)
+{
+    float speed = m_pParams->speed / 3.6;
+    float incl  = inclinationPercent * 0.01;
+    float cosIncl = 1.0 / sqrtf(1.0 + incl * incl);
+    float climbForce = m_pParams->model.mass * 9.81 * (m_pParams->model.cR * cosIncl + incl * cosIncl);
+    if (climbForce > 0.0 && climbForce * speed > m_pParams->maxPower)
+        speed = m_pParams->maxPower / climbForce;
+    return max(speed, 1.5f); // walking speed at least
+}
+
+void RoutePlanner::addSample(double dist, double lat, double lon, float ele)
+{
+    if (m_bHasSample)
+    {
+        float len = dist - m_sampleDist;
+        if (len <= 0.0)
+            return;
+
+        float dEle = ele - m_sampleEle;
+        float incl = dEle / len * 100.0;
+        if (dEle > 0.0)
+            m_pResult->elevationGain += dEle;
+
+        m_incl[m_nBlock]  = incl;
+        m_speed[m_nBlock] = segmentSpeed(incl);
+        m_dur[m_nBlock]   = len / m_speed[m_nBlock];
+        m_alt[m_nBlock]   = (ele + m_sampleEle) * 0.5;
+        m_temp[m_nBlock]  = m_pParams->airTemp;
+        m_lats[m_nBlock]  = lat;
+        m_lons[m_nBlock]  = lon;
+        if (++m_nBlock >= BLOCK_SIZE)
+            flushBlock();
+    }
+    m_bHasSample = true;
+    m_sampleDist = dist;
+    m_sampleEle  = ele;
+}
+
+// evaluate power model for all segments of the block
+void RoutePlanner::flushBlock()
+{
+    if (m_nBlock == 0)
+        return;
+
+    PowerMath::stSegments seg = { m_speed, m_incl, m_alt, m_temp, m_dur, m_nBlock };
+    PowerMath::PowerSegments(m_pParams->model, seg, m_power);
+
+    stResult& r = *m_pResult;
+    for (size_t i = 0; i < m_nBlock; i++)
+    {
+        // battery delivers what the rider does not
+        float motorPower = m_power[i] - m_pParams->riderPower;
+        float energyWh   = (motorPower > 0.0) ? motorPower * m_dur[i] / 3600.0 / m_pParams->eta : 0.0;
+
+        r.energyWh += energyWh;
+        r.distance += m_speed[i] * m_dur[i] / 1000.0;
+        r.nSegments++;
+
+        if (!r.bBatteryEmpty && m_pParams->remainWh > 0.0 && r.energyWh >= m_pParams->remainWh)
+        {
+            r.bBatteryEmpty = true;
+            r.emptyDistance = r.distance;
+            r.emptyLat      = m_lats[i];
+            r.emptyLon      = m_lons[i];
+        }
+
+        // altitude at end of segment, speed * duration is the horizontal length
+        float len = m_speed[i] * m_dur[i];
+        float alt = m_alt[i] + 0.5f * m_incl[i] * 0.01f * len;
+        addProfile(r.distance, alt, r.energyWh);
+    }
+    m_nBlock = 0;
+}
+
+// keep every n-th segment, double n when profile is full
+void RoutePlanner::addProfile(float distance, float altitude, float energyWh)
+{
+    stResult& r = *m_pResult;
+    if (((r.nSegments - 1) % m_profileStep) != 0)
+        return;
+
+    if (r.nProfile >= PROFILE_SIZE)
+    {
+        for (int i = 0; i < PROFILE_SIZE / 2; i++)
+            r.profile[i] = r.profile[i * 2];
+        r.nProfile = PROFILE_SIZE / 2;
+        m_profileStep *= 2;
+        if (((r.nSegments - 1) % m_profileStep) != 0)
+            return;
+    }
+
+    r.profile[r.nProfile].distance = distance;
+    r.profile[r.nProfile].altitude = altitude;
+    r.profile[r.nProfile].energyWh = energyWh;
+    r.nProfile++;
+}
+
+bool RoutePlanner::WriteResultSD(const char* filename, const stResult& result)
+{
+    File dataFile = SD.open(filename, FILE_WRITE);
+    if (!dataFile)
+    {
+        Serial.printf("SD: can't open: %s\r\n", filename);
+        return false;
+    }
+
+    dataFile.printf("Track points:\t%lu\r\n", (unsigned long)result.nTrackPoints);
+    dataFile.printf("Distance:\t%.2f km\r\n", result.distance);
+    dataFile.printf("Elev. gain:\t%.0f m\r\n", result.elevationGain);
+    dataFile.printf("Batt energy:\t%.0f Wh\r\n", result.energyWh);
+    dataFile.printf("Range:\t%.1f km\r\n", result.range);
+    if (result.bBatteryEmpty)
+        dataFile.printf("Batt empty:\t%.2f km\t%.6f\t%.6f\r\n", result.emptyDistance, result.emptyLat, result.emptyLon);
+
+    // profile
+    dataFile.println("Dist\tElevation\tEnergy");
+    for (int i = 0; i < result.nProfile; i++)
+        dataFile.printf("%.2f\t%.0f\t%.1f\r\n", result.profile[i].distance, result.profile[i].altitude, result.profile[i].energyWh);
+
+    dataFile.close();
+    return true;
+}
@@ -0,0 +1,133 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * Route energy planner: predict battery consumption for a GPX track
+ *
+ * The GPX file is streamed from SD with a small read buffer, track points
+ * are resampled by distance and evaluated block by block with the power
+ * model, so memory usage does not depend on the size of the track.
+ *
+ * Begin() and Step() plan in time slices from the main loop, Plan() blocks
+ * until the whole file is read.
+ *
+ */
+
+#ifndef ROUTEPLANNER_H
+#define ROUTEPLANNER_H
+
+#include <M5Core2.h>
+#include "PowerMath.h"
+
+class RoutePlanner
+{
+public:
+    struct stParams
+    {
+        PowerMath::stModel model;
+        float eta;          // compensation factor: calcPower = (motorPower * eta) + riderPower
+        float riderPower;   // average rider power (W)
+        float maxPower;     // max. rider + motor power (W), limits speed uphill
+        float speed;        // planned speed on flat road (km/h)
+        float airTemp;      // degree celsius
+        float remainWh;     // battery energy at start of route
+        float resampleDist; // distance between resampled points (m)
+    };
+
+    enum { PROFILE_SIZE = 64 };
+
+    struct stProfilePoint
+    {
+        float distance; // km
+        float altitude; // m
+        float energyWh; // accumulated battery energy
+    };
+
+    struct stResult
+    {
+        uint32_t nTrackPoints;
+        uint32_t nSegments;
+        float    distance;      // km
+        float    elevationGain; // m
+        float    energyWh;      // predicted battery energy for the whole route
+        float    range;         // km, with remaining battery energy and route consumption
+        bool     bBatteryEmpty; // battery runs out on this route
+        float    emptyDistance; // km, where the battery runs out
+        float    emptyLat;
+        float    emptyLon;
+        uint32_t tiCalc;        // ms, sum of all steps
+
+        // decimated elevation and energy profile
+        int            nProfile;
+        stProfilePoint profile[PROFILE_SIZE];
+    };
+
+    static void InitParams(stParams& params); // defaults
+
+    bool Begin(const char* filename, const stParams& params, stResult& result); // false: can't open file
+    bool Step(uint32_t maxMs);  // reads chunks for max. ms, false: result is complete
+    bool Plan(const char* filename, const stParams& params, stResult& result);
+    bool WriteResultSD(const char* filename, const stResult& result);
+
+protected:
+    const stParams* m_pParams = NULL;
+    stResult*       m_pResult = NULL;
+    File            m_gpxFile;
+
+    void finish();
+
+    // streaming GPX parser
+    enum { READ_SIZE = 1024, TAG_SIZE = 96, TEXT_SIZE = 24 };
+    char   m_readBuf[READ_SIZE];
+    char   m_tag[TAG_SIZE];
+    int    m_tagLen   = 0;
+    char   m_text[TEXT_SIZE];
+    int    m_textLen  = 0;
+    bool   m_bInTag   = false;
+    bool   m_bInEle   = false;
+    bool   m_bInPoint = false;
+    double m_lat      = 0.0;
+    double m_lon      = 0.0;
+    float  m_ele      = 0.0;
+
+    void parse(const char* pBuf, size_t len);
+    void onTag();
+    bool getAttribute(const char* name, double& value);
+
+    // resampling by distance
+    bool   m_bHasPrev = false;
+    double m_prevLat  = 0.0;
+    double m_prevLon  = 0.0;
+    float  m_prevEle  = 0.0;
+    double m_trackDist = 0.0;      // m
+    double m_nextSampleDist = 0.0; // m
+
+    void onTrackPoint(double lat, double lon, float ele);
+    void addSample(double dist, double lat, double lon, float ele);
+
+    bool   m_bHasSample = false;
+    double m_sampleDist = 0.0;
+    float  m_sampleEle  = 0.0;
+
+    // segment block for power model, structure of arrays
+    enum { BLOCK_SIZE = 64 };
+    float  m_speed[BLOCK_SIZE];
+    float  m_incl[BLOCK_SIZE];
+    float  m_alt[BLOCK_SIZE];
+    float  m_temp[BLOCK_SIZE];
+    float  m_dur[BLOCK_SIZE];
+    float  m_power[BLOCK_SIZE];
+    float  m_lats[BLOCK_SIZE];
+    float  m_lons[BLOCK_SIZE];
+    size_t m_nBlock = 0;
+
+    void  flushBlock();
+    float segmentSpeed(float inclinationPercent);
+
+    // profile decimation
+    uint32_t m_profileStep = 1;
+    void addProfile(float distance, float altitude, float energyWh);
+};
+
+#endif // ROUTEPLANNER_H
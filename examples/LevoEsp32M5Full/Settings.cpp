@@ -0,0 +1,146 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * Typed settings with RAM cache and batched write back to Preferences
+ *
+ */
+
+#include "Settings.h"
+#include "SysClock.h"
+
+// keys are the former Preferences keys, existing settings remain valid
+const Settings::stSchema Settings::s_schema[numElements] =
+{
+    { "LogFormat",       UCHAR,  0.0 },  // FileLogger::NONE
+    { "BtEnabled",       UCHAR,  1.0 },
+    { "BtPin",           ULONG,  0.0 },  // 0: no pin
+    { "BacklightTo",     USHORT, 60.0 },
+    { "BacklightChg",    UCHAR,  1.0 },
+    { "SealevelhPa",     FLOAT,  1013.25 },
+    { "PwrCalibEnabled", UCHAR,  0.0 },
+    { "Sp_mass",         FLOAT,  110.0 },
+    { "Sp_cR",           FLOAT,  0.009725 },
+    { "Sp_cwA",          FLOAT,  0.437392 },
+    { "Sp_avgRdPower",   FLOAT,  100.0 },
+    { "Sp_defAirTemp",   FLOAT,  18.0 },
+    { "Sp_defAlt",       FLOAT,  520.0 },
+    { "Sp_nRuns",        UCHAR,  4.0 },
+    { "Sp_eta",          FLOAT,  0.6 },
+};
+
+static_assert(Settings::numElements <= 32, "dirty mask is 32 bit");
+
+void Settings::setDefault(enIds id)
+{
+    if (s_schema[id].type == FLOAT)
+        m_values[id].f = s_schema[id].def;
+    else
+        m_values[id].u = (uint32_t)s_schema[id].def;
+}
+
+void Settings::Load(Preferences& prefs)
+{
+    m_pPrefs = &prefs;
+    for (int i = 0; i < numElements; i++)
+    {
+        const stSchema& s = s_schema[i];
+        unValue& val = m_values[i];
+        switch (s.type)
+        {
+        case UCHAR:  val.u = prefs.getUChar(s.key, (uint8_t)s.def); break;
+        case USHORT: val.u = prefs.getUShort(s.key, (uint16_t)s.def); break;
+        case ULONG:  val.u = prefs.getULong(s.key, (uint32_t)s.def); break;
+        case FLOAT:  val.f = prefs.getFloat(s.key, s.def); break;
+        }
+        m_stored[i] = val;
+        if (s.type == FLOAT)
+            Serial.printf("%s: %f\r\n", s.key, val.f);
+        else
+            Serial.printf("%s: %u\r\n", s.key, val.u);
+    }
+    m_dirtyMask = 0;
+}
+
+void Settings::AddListener(fnChanged fn)
+{
+    if (m_nListeners < MAX_LISTENERS)
+        m_listeners[m_nListeners++] = fn;
+}
+
+void Settings::SetUInt(enIds id, uint32_t val)
+{
+    unValue v;
+    v.u = val;
+    if (m_values[id].u != v.u)
+        changed(id, v);
+}
+
+void Settings::SetFloat(enIds id, float val)
+{
+    unValue v;
+    v.f = val;
+    if (m_values[id].f != v.f)
+        changed(id, v);
+}
+
+void Settings::changed(enIds id, const unValue& val)
+{
+    m_values[id] = val;
+    m_dirtyMask |= 1UL << id;
+    m_tiChanged = (uint32_t)SysClock::Millis();
+    for (int i = 0; i < m_nListeners; i++)
+        m_listeners[i](id);
+}
+
+void Settings::Poll(uint32_t timestamp)
+{
+    if (m_dirtyMask && timestamp - m_tiChanged >= COMMIT_DELAY_MS)
+        Commit();
+}
+
+// values changed back and forth are not written
+void Settings::Commit()
+{
+    if (m_pPrefs == NULL || m_dirtyMask == 0)
+        return;
+
+    int nWritten = 0;
+    for (int i = 0; i < numElements; i++)
+    {
+        if (!(m_dirtyMask & (1UL << i)) || m_values[i].u == m_stored[i].u)
+            continue;
+        const stSchema& s = s_schema[i];
+        const unValue& val = m_values[i];
+        switch (s.type)
+        {
+        case UCHAR:  m_pPrefs->putUChar(s.key, (uint8_t)val.u); break;
+        case USHORT: m_pPrefs->putUShort(s.key, (uint16_t)val.u); break;
+        case ULONG:  m_pPrefs->putULong(s.key, val.u); break;
+        case FLOAT:  m_pPrefs->putFloat(s.key, val.f); break;
+        }
+        m_stored[i] = val;
+        nWritten++;
+    }
+    m_dirtyMask = 0;
+    m_nWrites += nWritten;
+    if (nWritten)
+        Serial.printf("settings: %d written, %u since start\r\n", nWritten, m_nWrites);
+}
+
+void Settings::Clear()
+{
+    if (m_pPrefs)
+        m_pPrefs->clear();
+    m_dirtyMask = 0;
+    for (int i = 0; i < numElements; i++)
+    {
+        unValue old = m_values[i];
+        setDefault((enIds)i);
+        m_stored[i] = m_values[i];
+        if (old.u != m_values[i].u)
+            for (int n = 0; n < m_nListeners; n++)
+                m_listeners[n]((enIds)i);
+    }
+}
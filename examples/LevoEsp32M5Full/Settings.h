@@ -0,0 +1,105 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * Typed settings: one schema with keys and defaults, RAM cache loaded once
+ * from Preferences, changes are written back batched and only if the value
+ * differs from flash. Listeners are notified per changed setting.
+ *
+ */
+
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+
+class Settings
+{
+public:
+    typedef enum
+    {
+        LOG_FORMAT = 0,
+        BT_ENABLED,
+        BT_PIN,
+        BACKLIGHT_TO,
+        BACKLIGHT_CHG,
+        SEALEVEL_HPA,
+        PWR_CALIB_ENABLED,
+        SP_MASS,
+        SP_CR,
+        SP_CWA,
+        SP_AVG_RDPOWER,
+        SP_DEF_AIRTEMP,
+        SP_DEF_ALT,
+        SP_NRUNS,
+        SP_ETA,
+        NUM_SETTINGS,
+    } enIds;
+    static const int numElements = NUM_SETTINGS;
+
+    typedef enum
+    {
+        UCHAR = 0,
+        USHORT,
+        ULONG,
+        FLOAT,
+    } enType;
+
+    typedef struct
+    {
+        const char* key;  // Preferences key
+        enType      type;
+        float       def;  // default, also for integer types
+    } stSchema;
+
+    enum
+    {
+        COMMIT_DELAY_MS = 5000, // write back after last change
+        MAX_LISTENERS   = 4,
+    };
+
+    typedef void (*fnChanged)(enIds id);
+
+    void Load(Preferences& prefs);            // once at startup
+    void Poll(uint32_t timestamp);            // deferred write back
+    void Commit();                            // write back now, e.g. before restart
+    void Clear();                             // all to defaults, flash erased
+    void AddListener(fnChanged fn);
+    Preferences& GetPrefs() { return *m_pPrefs; } // strings and blobs, not part of the schema
+
+    uint32_t GetUInt(enIds id) const  { return m_values[id].u; }
+    float    GetFloat(enIds id) const { return m_values[id].f; }
+    bool     GetBool(enIds id) const  { return m_values[id].u != 0; }
+
+    void     SetUInt(enIds id, uint32_t val);
+    void     SetFloat(enIds id, float val);
+    void     SetBool(enIds id, bool bVal) { SetUInt(id, bVal ? 1 : 0); }
+
+    static const stSchema& GetSchema(enIds id) { return s_schema[id]; }
+
+protected:
+    typedef union
+    {
+        uint32_t u;
+        float    f;
+    } unValue;
+
+    static const stSchema s_schema[numElements];
+
+    Preferences* m_pPrefs = NULL;
+    unValue      m_values[numElements];
+    unValue      m_stored[numElements]; // as in flash
+    uint32_t     m_dirtyMask = 0;
+    uint32_t     m_tiChanged = 0;
+    uint32_t     m_nWrites   = 0;
+
+    fnChanged    m_listeners[MAX_LISTENERS] = {};
+    int          m_nListeners = 0;
+
+    void setDefault(enIds id);
+    void changed(enIds id, const unValue& val);
+};
+
+#endif // SETTINGS_H
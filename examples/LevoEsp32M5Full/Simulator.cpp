@@ -64,90 +64,447 @@ const int Simulator::s_valColArray[] =
   18,   // BARO_TEMP,
 };
 
-bool Simulator::readLine(uint32_t& time, int& dispId, float& fVal)
+bool Simulator::Open(const char* filename, DisplayData& DispData)
 {
-    int colCnt, valCol;
-    char buffer[250];
-    uint32_t ti;
-    int id;
+    Close();
 
-    while (m_simFile.available())
+    sdcard_type_t Type = SD.cardType();
+    if (Type == CARD_UNKNOWN || Type == CARD_NONE)
+        return false;
+
+    m_simFile = SD.open(filename, FILE_READ);
+    if (!m_simFile)
+        return false;
+    strncpy(m_filename, filename, sizeof(m_filename) - 1);
+
+    // columns of old table format without head line
+    int i;
+    m_mode = TABLE;
+    for (i = 0; i < MAX_COLUMNS; i++)
+        m_colId[i] = -1;
+    for (i = 0; i < (int)(sizeof(s_valColArray) / sizeof(s_valColArray[0])); i++)
+        if (s_valColArray[i] > 0)
+            m_colId[s_valColArray[i]] = i;
+
+    // skip to first value line, head line defines columns
+    stScan scan = {};
+    m_scan = scan;
+    seekFile(0);
+    uint32_t offset;
+    char* pLine;
+    while ((pLine = readLine(offset)) != NULL)
     {
-        size_t nRead = m_simFile.readBytesUntil('\n', buffer, sizeof( buffer) );
-        if ( nRead >= 0 )
+        if (strncmp(pLine, "Time", 4) == 0)
         {
-            colCnt = 0;
-            valCol = 0;
-
-            buffer[nRead] = '\0';
-            char* token = strtok(buffer, "\t;");
-            while (token != NULL)
+            // Time  Dist  Id  Label  Value  Unit  or  Time  Dist  Id  <label> ...
+            char* pSave;
+            char* pToken = strtok_r(pLine, "\t;", &pSave);
+            for (int col = 0; pToken && col < MAX_COLUMNS; col++, pToken = strtok_r(NULL, "\t;", &pSave))
             {
-                // Serial.println( token );
-                // time in ms
-                if( colCnt == 0 )
-                {
-                    ti = (uint32_t)(atof( token ) * 1000.0);
-                }
-                // value id
-                else if( colCnt == 2 )
-                {
-                    id = atoi( token );
-                    if( id >= sizeof( s_valColArray ) )
-                        return false;
-                    if( ( valCol = s_valColArray[id] ) == 0 )
-                        return false;
-                }
-                // get value from column
-                else if (valCol == colCnt)
+                while (*pToken == ' ')
+                    pToken++;
+                char* pEnd = pToken + strlen(pToken);
+                while (pEnd > pToken && pEnd[-1] == ' ')
+                    *--pEnd = '\0';
+
+                m_colId[col] = -1;
+                if (col == 3 && strcmp(pToken, "Label") == 0)
+                    m_mode = SIMPLE;
+                for (i = 0; col >= 3 && i < DisplayData::numElements; i++)
                 {
-                    time = ti;
-                    dispId = id;
-                    fVal = atof( token );
-                    return true;
+                    const DisplayData::stDisplayData* pDesc = DispData.GetDescription((DisplayData::enIds)i);
+                    if (pDesc && strcmp(pDesc->strLabel, pToken) == 0)
+                        m_colId[col] = i;
                 }
-                token = strtok(NULL, "\t;");
-                colCnt++;
             }
+            continue;
         }
+        if (parseLine(pLine, false))
+            break;
     }
-    return false;
+    if (pLine == NULL)
+    {
+        Serial.printf("Simulator: no values in %s\r\n", filename);
+        Close();
+        return false;
+    }
+
+    // eliminate time offset in file
+    restart(offset, scan);
+    m_startTimeOffset = m_fileStartTime = m_lineTime;
+    Serial.printf("Simulator: %s, %s format, speed %.1f\r\n", filename, (m_mode == SIMPLE) ? "simple" : "table", m_speed);
+    return true;
 }
 
-bool Simulator::Update( DisplayData::enIds& id, float& fVal, uint32_t timestamp)
+void Simulator::Close()
 {
-    sdcard_type_t Type = SD.cardType();
-    if (Type == CARD_UNKNOWN || Type == CARD_NONE)
-        return false;
+    if (m_simFile)
+        m_simFile.close();
+    m_bStarted = false;
+    m_nPending = m_iPending = 0;
+}
 
-    if (!m_simFile)
+// read ahead buffer, returns line terminated in place
+char* Simulator::readLine(uint32_t& lineOffset)
+{
+    for (;;)
     {
-        m_simFile = SD.open("/simulator.txt", FILE_READ );
-        m_startTime = timestamp;
-        uint32_t ti; int id; float val;
-        if (readLine(ti, id, val))
-            m_startTimeOffset = ti; // eliminate time offset in file
+        char* pStart = &m_buffer[m_pos];
+        char* pEnd   = (char*)memchr(pStart, '\n', m_len - m_pos);
+        if (pEnd)
+        {
+            *pEnd = '\0';
+            if (pEnd > pStart && pEnd[-1] == '\r')
+                pEnd[-1] = '\0';
+            lineOffset = m_bufferOffset + m_pos;
+            m_pos = pEnd - m_buffer + 1;
+            return pStart;
+        }
+
+        // keep incomplete line, a line longer than the buffer is dropped
+        size_t rest = m_len - m_pos;
+        if (rest >= BUFFER_SIZE)
+            rest = 0;
+        else
+            memmove(m_buffer, pStart, rest);
+        m_bufferOffset += m_len - rest;
+        m_pos = 0;
+        m_len = rest;
+
+        int nRead = m_simFile.read((uint8_t*)&m_buffer[m_len], BUFFER_SIZE - m_len);
+        if (nRead <= 0)
+        {
+            // last line without line feed
+            if (m_len == 0)
+                return NULL;
+            m_buffer[m_len] = '\0';
+            lineOffset = m_bufferOffset;
+            m_pos = m_len;
+            return m_buffer;
+        }
+        m_len += nRead;
     }
+}
 
-    if (m_simFile)
+void Simulator::seekFile(uint32_t offset)
+{
+    m_simFile.seek(offset);
+    m_bufferOffset = offset;
+    m_pos = m_len = 0;
+}
+
+// [spaces][-]digits[.digits][spaces] followed by tab, semicolon or end of line
+bool Simulator::parseFloat(char*& p, float& fVal)
+{
+    while (*p == ' ')
+        p++;
+    bool bNeg = (*p == '-');
+    if (bNeg)
+        p++;
+    if (*p < '0' || *p > '9')
+        return false;
+
+    int32_t intPart = 0;
+    while (*p >= '0' && *p <= '9')
+        intPart = intPart * 10 + (*p++ - '0');
+
+    int32_t frac = 0, div = 1;
+    if (*p == '.')
     {
-        if( m_nextValueTime == 0 )
+        p++;
+        while (*p >= '0' && *p <= '9')
         {
-            if( readLine(m_nextValueTime, m_nextValueId, m_nextValue) )
+            if (div < 1000000)
             {
-                // Serial.printf("time: %ld, id: %d, val: %f\r\n", m_nextValueTime, m_nextValueId, m_nextValue );
-                m_nextValueTime += m_startTime - m_startTimeOffset;
+                frac = frac * 10 + (*p - '0');
+                div *= 10;
             }
+            p++;
+        }
+    }
+    while (*p == ' ')
+        p++;
+    if (*p != '\t' && *p != ';' && *p != '\0')
+        return false;
+    if (*p)
+        p++;
+
+    fVal = (float)intPart + (float)frac / (float)div;
+    if (bNeg)
+        fVal = -fVal;
+    return true;
+}
+
+// time  dist  id  values ... , date, head and static lines are rejected
+bool Simulator::parseLine(char* pLine, bool bValues)
+{
+    char* p = pLine;
+    float fTime, fDist, fId;
+    if (!parseFloat(p, fTime) || !parseFloat(p, fDist) || !parseFloat(p, fId))
+        return false;
+
+    // ms without float rounding, times of long rides exceed float precision
+    uint32_t time = 0;
+    char* q = pLine;
+    while (*q == ' ')
+        q++;
+    for (; *q >= '0' && *q <= '9'; q++)
+        time = time * 10 + (*q - '0');
+    time *= 1000;
+    if (*q == '.')
+    {
+        uint32_t scale = 100;
+        for (q++; *q >= '0' && *q <= '9'; q++, scale /= 10)
+            time += (*q - '0') * scale;
+    }
+
+    // a new session in the same file restarts time and distance
+    time += m_scan.timeAdd;
+    if (time < m_scan.lastTime)
+    {
+        m_scan.timeAdd += m_scan.lastTime - time;
+        time = m_scan.lastTime;
+    }
+    m_scan.lastTime = time;
+    fDist += m_scan.distAdd;
+    if (fDist < m_scan.lastDist)
+    {
+        m_scan.distAdd += m_scan.lastDist - fDist;
+        fDist = m_scan.lastDist;
+    }
+    m_scan.lastDist = fDist;
+
+    m_lineTime = time;
+    m_lineDist = fDist;
+    m_nLines++;
+    if (!bValues)
+        return true;
+
+    m_nPending = m_iPending = 0;
+    if (m_mode == SIMPLE)
+    {
+        // id  label  value  unit
+        int id = (int)fId;
+        p = strpbrk(p, "\t;");
+        float fVal;
+        if (id >= 0 && id < DisplayData::numElements && p && parseFloat(++p, fVal))
+        {
+            m_pending[0].id   = id;
+            m_pending[0].fVal = fVal;
+            m_nPending = 1;
+        }
+        return true;
+    }
+
+    // all changed values of a table line
+    for (int col = 3; *p && col < MAX_COLUMNS; col++)
+    {
+        float fVal;
+        if (!parseFloat(p, fVal))
+        {
+            p = strpbrk(p, "\t;");
+            if (p == NULL)
+                break;
+            p++;
+            continue;
         }
-        else if( timestamp > m_nextValueTime )
+        int id = m_colId[col];
+        if (id < 0 || (m_bHasVal[id] && m_lastVal[id] == fVal))
+            continue;
+        m_lastVal[id] = fVal;
+        m_bHasVal[id] = true;
+        m_pending[m_nPending].id   = id;
+        m_pending[m_nPending].fVal = fVal;
+        m_nPending++;
+    }
+    return true;
+}
+
+bool Simulator::Update( DisplayData::enIds& id, float& fVal, uint32_t timestamp)
+{
+    if (!m_simFile)
+        return false;
+
+    // replay clock starts with first call
+    if (!m_bStarted)
+    {
+        m_bStarted     = true;
+        m_startTime    = timestamp;
+        m_tiBenchStart = millis();
+        m_nLines = m_nValues = 0;
+    }
+
+    // next line with values
+    while (m_iPending >= m_nPending)
+    {
+        uint32_t offset;
+        char* pLine = readLine(offset);
+        if (pLine == NULL)
         {
-            m_nextValueTime = 0;
-            id   = (DisplayData::enIds)m_nextValueId;
-            fVal = m_nextValue;
-            return true;
+            uint32_t ti = millis() - m_tiBenchStart;
+            Serial.printf("Simulator: end of file, %lu lines, %lu values in %lu ms, %lu values/s\r\n", (unsigned long)m_nLines,
+                (unsigned long)m_nValues, (unsigned long)ti, (unsigned long)(ti ? (uint64_t)m_nValues * 1000 / ti : 0));
+            Close();
+            return false;
         }
+        parseLine(pLine, true);
     }
 
+    // wait for log time
+    if (m_speed > 0.0f && (float)(timestamp - m_startTime) * m_speed < (float)(int32_t)(m_lineTime - m_startTimeOffset))
+        return false;
+
+    id   = (DisplayData::enIds)m_pending[m_iPending].id;
+    fVal = m_pending[m_iPending].fVal;
+    m_iPending++;
+    m_nValues++;
+    return true;
+}
+
+// log time mapped to replay start, correct time base for integration at any speed
+uint32_t Simulator::GetTime()
+{
+    return m_startTime + (m_lineTime - m_startTimeOffset);
+}
+
+void Simulator::restart(uint32_t lineOffset, const stScan& scan)
+{
+    seekFile(lineOffset);
+    m_scan     = scan;
+    m_nPending = m_iPending = 0;
+    m_bStarted = false;
+    for (int i = 0; i < DisplayData::numElements; i++)
+        m_bHasVal[i] = false;
+}
+
+bool Simulator::openIndex(File& index, stIndexHeader& hdr)
+{
+    char idxName[sizeof(m_filename)];
+    strcpy(idxName, m_filename);
+    char* pExt = strrchr(idxName, '.');
+    strcpy(pExt ? pExt : idxName + strlen(idxName), ".idx");
+
+    index = SD.open(idxName, FILE_READ);
+    if (!index)
+        return false;
+    if (index.read((uint8_t*)&hdr, sizeof(hdr)) == sizeof(hdr) && memcmp(hdr.magic, "LSI1", 4) == 0 && hdr.logSize == m_simFile.size())
+        return true;
+    index.close();
     return false;
 }
 
+// one scan of the whole log file
+bool Simulator::buildIndex()
+{
+    char idxName[sizeof(m_filename)];
+    strcpy(idxName, m_filename);
+    char* pExt = strrchr(idxName, '.');
+    strcpy(pExt ? pExt : idxName + strlen(idxName), ".idx");
+
+    File index = SD.open(idxName, FILE_WRITE);
+    if (!index)
+        return false;
+
+    // header is valid after all entries are written
+    stIndexHeader hdr;
+    memcpy(hdr.magic, "LSI1", 4);
+    hdr.logSize  = 0;
+    hdr.nEntries = 0;
+    index.write((const uint8_t*)&hdr, sizeof(hdr));
+
+    uint32_t tiStart = millis();
+    stScan scan = {};
+    m_scan = scan;
+    seekFile(0);
+    uint32_t offset, nextTime = 0;
+    char* pLine;
+    while ((pLine = readLine(offset)) != NULL)
+    {
+        scan = m_scan;
+        if (!parseLine(pLine, false) || m_lineTime < nextTime)
+            continue;
+        stIndexEntry entry = { offset, m_lineTime, m_lineDist, scan };
+        index.write((const uint8_t*)&entry, sizeof(entry));
+        hdr.nEntries++;
+        nextTime = m_lineTime + INDEX_INTERVAL;
+    }
+    index.close();
+
+    hdr.logSize = m_simFile.size();
+    index = SD.open(idxName, "r+");
+    if (!index)
+        return false;
+    index.write((const uint8_t*)&hdr, sizeof(hdr));
+    index.close();
+
+    Serial.printf("Simulator: index %s, %lu entries in %lu ms\r\n", idxName, (unsigned long)hdr.nEntries, (unsigned long)(millis() - tiStart));
+    return true;
+}
+
+// last index entry before target, then line by line
+bool Simulator::seekEntry(bool bDistance, float target)
+{
+    if (!m_simFile)
+        return false;
+
+    File index;
+    stIndexHeader hdr;
+    if (!openIndex(index, hdr) && (!buildIndex() || !openIndex(index, hdr)))
+        return false;
+    if (hdr.nEntries == 0)
+    {
+        index.close();
+        return false;
+    }
+
+    stIndexEntry entry;
+    int lo = 0, hi = hdr.nEntries - 1;
+    while (lo < hi)
+    {
+        int mid = (lo + hi + 1) / 2;
+        index.seek(sizeof(hdr) + mid * sizeof(entry));
+        index.read((uint8_t*)&entry, sizeof(entry));
+        float key = bDistance ? entry.dist : (float)entry.time;
+        if (key <= target)
+            lo = mid;
+        else
+            hi = mid - 1;
+    }
+    index.seek(sizeof(hdr) + lo * sizeof(entry));
+    index.read((uint8_t*)&entry, sizeof(entry));
+    index.close();
+
+    restart(entry.offset, entry.scan);
+    uint32_t offset = entry.offset;
+    stScan scan = entry.scan;
+    char* pLine;
+    for (;;)
+    {
+        stScan scanBefore = m_scan;
+        uint32_t lineOffset;
+        if ((pLine = readLine(lineOffset)) == NULL)
+            break;
+        if (!parseLine(pLine, false))
+            continue;
+        offset = lineOffset;
+        scan   = scanBefore;
+        if ((bDistance ? m_lineDist : (float)m_lineTime) >= target)
+            break;
+    }
+
+    // replay continues with the found line
+    restart(offset, scan);
+    m_startTimeOffset = m_lineTime;
+    Serial.printf("Simulator: seek to %.1f s, %.2f km\r\n", m_lineTime / 1000.0f, m_lineDist);
+    return true;
+}
+
+bool Simulator::SeekTime(uint32_t ms)
+{
+    return seekEntry(false, (float)(ms + m_fileStartTime));
+}
+
+bool Simulator::SeekDistance(float km)
+{
+    return seekEntry(true, km);
+}
@@ -5,30 +5,115 @@
  *
  * Replay a log file to simulate a trip
  *
+ * Reads CSV_TABLE or CSV_SIMPLE logs (head line "Time Dist Id ...") and the
+ * old table format without head line. All changed values of a table line
+ * are delivered, one value per Update() call. Replay speed is 1x, Nx or as
+ * fast as possible (speed 0) for benchmarking the whole data pipeline.
+ *
+ * Seek by time or distance uses a sidecar index /<name>.idx with one entry
+ * per INDEX_INTERVAL of log time. It is built on the first seek and rebuilt
+ * when the log file size changes.
+ *
  */
 
 #ifndef SIMULATOR_H
 #define SIMULATOR_H
 
+#include <M5Core2.h>
 #include "DisplayData.h"
 
 class Simulator
 {
 public:
+    enum
+    {
+        BUFFER_SIZE    = 4096,  // read ahead, longest line must fit
+        INDEX_INTERVAL = 10000, // ms of log time per index entry
+        MAX_COLUMNS    = 3 + DisplayData::numElements,
+    };
+
+    bool Open(const char* filename, DisplayData& DispData);
+    void Close();
+    bool IsOpen() { return m_simFile ? true : false; }
     bool Update(DisplayData::enIds & id, float & fVal, uint32_t timestamp);
 
+    void     SetSpeed(float speed) { m_speed = speed; } // 1.0: real time, 0: max. speed
+    uint32_t GetTime();                                 // replay time of last value, use as timestamp for values
+
+    bool SeekTime(uint32_t ms);      // log time since start of file
+    bool SeekDistance(float km);     // distance since start of file
+
 protected:
     File m_simFile;
+    char m_filename[32] = "";
 
     static const int s_valColArray[];
 
-    bool readLine(uint32_t & time, int & id, float & fVal );
+    // column layout
+    enum enMode { TABLE = 0, SIMPLE };
+    enMode  m_mode = TABLE;
+    int8_t  m_colId[MAX_COLUMNS]; // display id of a column, -1 = none
+
+    // read ahead buffer
+    char     m_buffer[BUFFER_SIZE + 1];
+    size_t   m_pos = 0;
+    size_t   m_len = 0;
+    uint32_t m_bufferOffset = 0;  // file position of m_buffer[0]
+    char*    readLine(uint32_t& lineOffset);
+    void     seekFile(uint32_t offset);
+
+    // parsed line, time and distance continue over sessions in one file
+    struct stScan
+    {
+        uint32_t timeAdd;
+        uint32_t lastTime;
+        float    distAdd;
+        float    lastDist;
+    };
+    stScan   m_scan;
+    uint32_t m_lineTime = 0;
+    float    m_lineDist = 0.0f;
+    bool     parseLine(char* pLine, bool bValues);
+    static bool parseFloat(char*& p, float& fVal); // fixed point text, advances behind separator
+
+    // values of current line
+    struct stValue { uint8_t id; float fVal; };
+    stValue  m_pending[DisplayData::numElements];
+    int      m_nPending = 0;
+    int      m_iPending = 0;
+    float    m_lastVal[DisplayData::numElements];
+    bool     m_bHasVal[DisplayData::numElements];
+
+    // replay clock
+    float    m_speed = 1.0f;
+    bool     m_bStarted = false;
+    uint32_t m_startTime = 0L;       // millis() of replay start
+    uint32_t m_startTimeOffset = 0L; // log time at replay start
+    uint32_t m_fileStartTime = 0L;   // log time of first line
+
+    // sidecar index
+    struct stIndexEntry
+    {
+        uint32_t offset;
+        uint32_t time;  // ms
+        float    dist;
+        stScan   scan;
+    };
+    struct stIndexHeader
+    {
+        char     magic[4];
+        uint32_t logSize;
+        uint32_t nEntries;
+    };
+    bool     openIndex(File& index, stIndexHeader& hdr);
+    bool     buildIndex();
+    bool     seekEntry(bool bDistance, float target);
+    void     restart(uint32_t lineOffset, const stScan& scan);
 
-    uint32_t m_startTime = 0L;
-    uint32_t m_nextValueTime = 0L;
-    uint32_t m_startTimeOffset = 0L;
-    int      m_nextValueId;
-    float    m_nextValue;
+    // statistics
+    uint32_t m_nLines  = 0;
+    uint32_t m_nValues = 0;
+    uint32_t m_tiBenchStart = 0;
 };
 
-#endif // SIMULATOR_H
\ No newline at end of file
+#endif // SIMULATOR_H
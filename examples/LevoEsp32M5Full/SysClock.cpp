@@ -0,0 +1,76 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * Clock service: monotonic 64 bit time since boot and cached wall clock
+ *
+ */
+
+#include "SysClock.h"
+
+bool    SysClock::s_bSynced  = false;
+int64_t SysClock::s_offsetUs = 0;
+
+// days since 1970-01-01, proleptic Gregorian calendar
+int32_t SysClock::daysFromCivil(int y, unsigned m, unsigned d)
+{
+    y -= m <= 2;
+    int32_t  era = (y >= 0 ? y : y - 399) / 400;
+    unsigned yoe = (unsigned)(y - era * 400);
+    unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int32_t)doe - 719468;
+}
+
+void SysClock::civilFromDays(int32_t days, int& y, unsigned& m, unsigned& d)
+{
+    days += 719468;
+    int32_t  era = (days >= 0 ? days : days - 146096) / 146097;
+    unsigned doe = (unsigned)(days - era * 146097);
+    unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    unsigned mp  = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y = (int)yoe + era * 400 + (m <= 2);
+}
+
+// the only RTC access, seconds of RTC and monotonic clock are not aligned (< 1 s)
+void SysClock::Sync()
+{
+    RTC_DateTypeDef date;
+    RTC_TimeTypeDef time;
+    M5.Rtc.GetDate(&date);
+    M5.Rtc.GetTime(&time);
+    int64_t secs = (int64_t)daysFromCivil(date.Year, date.Month, date.Date) * 86400
+                 + time.Hours * 3600 + time.Minutes * 60 + time.Seconds;
+    s_offsetUs = secs * 1000000 - Micros();
+    s_bSynced  = true;
+}
+
+time_t SysClock::Now()
+{
+    if (!s_bSynced)
+        Sync();
+    return (time_t)((Micros() + s_offsetUs) / 1000000);
+}
+
+void SysClock::GetDate(RTC_DateTypeDef* pDate)
+{
+    int32_t days = (int32_t)(Now() / 86400);
+    int y; unsigned m, d;
+    civilFromDays(days, y, m, d);
+    pDate->WeekDay = (uint8_t)((days + 4) % 7); // 1970-01-01 was a thursday, 0: sunday
+    pDate->Month   = m;
+    pDate->Date    = d;
+    pDate->Year    = y;
+}
+
+void SysClock::GetTime(RTC_TimeTypeDef* pTime)
+{
+    uint32_t secs = (uint32_t)(Now() % 86400);
+    pTime->Hours   = secs / 3600;
+    pTime->Minutes = secs / 60 % 60;
+    pTime->Seconds = secs % 60;
+}
@@ -0,0 +1,47 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * Clock service: monotonic 64 bit time since boot and cached wall clock
+ *
+ * Micros()/Millis() come from esp_timer and never wrap. Components get
+ * 32 bit millisecond timestamps from the main loop and compare them by
+ * difference (IsDue), which is valid across the 49.7 day wraparound.
+ *
+ * The RTC is read once (first use or Sync() after it was set by NTP), wall
+ * clock time is then derived from the monotonic clock without I2C access.
+ *
+ */
+
+#ifndef SYSCLOCK_H
+#define SYSCLOCK_H
+
+#include <M5Core2.h>
+#include <esp_timer.h>
+#include <time.h>
+
+class SysClock
+{
+public:
+    static int64_t  Micros() { return esp_timer_get_time(); }
+    static uint64_t Millis() { return (uint64_t)esp_timer_get_time() / 1000; }
+
+    // 32 bit timestamps: deadline reached, wrap safe for intervals < 24 days
+    static bool IsDue(uint32_t timestamp, uint32_t deadline) { return (int32_t)(timestamp - deadline) >= 0; }
+
+    // wall clock, local time as set in RTC
+    static void   Sync(); // read RTC
+    static time_t Now();  // seconds since 1970
+    static void   GetDate(RTC_DateTypeDef* pDate);
+    static void   GetTime(RTC_TimeTypeDef* pTime);
+
+protected:
+    static bool    s_bSynced;
+    static int64_t s_offsetUs; // wall clock - monotonic clock
+
+    static int32_t daysFromCivil(int y, unsigned m, unsigned d);
+    static void    civilFromDays(int32_t days, int& y, unsigned& m, unsigned& d);
+};
+
+#endif // SYSCLOCK_H
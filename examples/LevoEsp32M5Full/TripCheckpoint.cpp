@@ -0,0 +1,154 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * Trip and power state checkpoints in RTC memory and Preferences
+ *
+ */
+
+#include "TripCheckpoint.h"
+#include "LogJournal.h"
+#include "SysClock.h"
+
+#define CHECKPOINT_KEY   "TripCp"
+#define CHECKPOINT_MAGIC 0x50435254 // "TRCP"
+
+static_assert(sizeof(TripCheckpoint::stRecord) <= 256, "checkpoint record too big");
+
+// not initialized at reset, CRC detects garbage after power on
+static RTC_NOINIT_ATTR TripCheckpoint::stRecord s_rtcRecord;
+
+// seconds since 1.1.2000, cached wall clock
+uint32_t TripCheckpoint::rtcSeconds()
+{
+    const time_t epoch2000 = 946684800;
+    time_t now = SysClock::Now();
+    return (now < epoch2000) ? 0 : (uint32_t)(now - epoch2000);
+}
+
+uint32_t TripCheckpoint::payloadCrc(const stRecord& record)
+{
+    return LogJournal::crc32((const uint8_t*)&record, offsetof(stRecord, crc));
+}
+
+// sequence and time are not part of the state
+uint32_t TripCheckpoint::stateCrc(const stRecord& record)
+{
+    stRecord cmp = record;
+    cmp.seq = 0;
+    cmp.rtcTime = 0;
+    return payloadCrc(cmp);
+}
+
+bool TripCheckpoint::isValid(const stRecord& record)
+{
+    return record.magic == CHECKPOINT_MAGIC && record.version == VERSION && record.size == sizeof(stRecord)
+        && record.crc == payloadCrc(record);
+}
+
+void TripCheckpoint::Init(Preferences& prefs, VirtualSensors& virtSensors, PowerUtil& power, SystemStatus& sysStatus)
+{
+    m_pPrefs       = &prefs;
+    m_pVirtSensors = &virtSensors;
+    m_pPower       = &power;
+    m_pSysStatus   = &sysStatus;
+}
+
+bool TripCheckpoint::Restore(DisplayData& dispData)
+{
+    uint32_t us = micros();
+
+    // newest valid record
+    stRecord nvsRecord;
+    bool bNvs = m_pPrefs->getBytes(CHECKPOINT_KEY, &nvsRecord, sizeof(nvsRecord)) == sizeof(nvsRecord) && isValid(nvsRecord);
+    bool bRtc = isValid(s_rtcRecord);
+    const stRecord* pRecord = NULL;
+    if (bRtc && (!bNvs || s_rtcRecord.seq >= nvsRecord.seq))
+        pRecord = &s_rtcRecord;
+    else if (bNvs)
+        pRecord = &nvsRecord;
+    if (pRecord == NULL)
+    {
+        Serial.println("checkpoint: none");
+        return false;
+    }
+    m_seq = pRecord->seq;
+    if (bNvs)
+        m_nvsCrc = stateCrc(nvsRecord);
+
+    // a ride continues only after a short break
+    uint32_t now = rtcSeconds();
+    uint32_t age = (now >= pRecord->rtcTime) ? now - pRecord->rtcTime : UINT32_MAX;
+    bool bResume = age <= RESUME_MAX_S;
+
+    SystemStatus::enTripStatus tripStatus = (SystemStatus::enTripStatus)pRecord->tripStatus;
+    if (tripStatus != SystemStatus::NONE)
+    {
+        if (tripStatus == SystemStatus::STARTED && !bResume)
+            tripStatus = SystemStatus::STOPPED;
+        if (m_pVirtSensors->RestoreTrip(pRecord->trip, tripStatus == SystemStatus::STARTED, dispData))
+            m_pSysStatus->tripStatus = tripStatus;
+    }
+    if (bResume)
+        m_pPower->SetEnergyState(pRecord->energy);
+
+    Serial.printf("checkpoint: restored #%u from %s, age %u s, trip %d, %s, %u us\r\n", pRecord->seq,
+        (pRecord == &s_rtcRecord) ? "RTC" : "NVS", age, m_pSysStatus->tripStatus, bResume ? "resumed" : "trip only", micros() - us);
+    return true;
+}
+
+void TripCheckpoint::capture()
+{
+    memset(&m_record, 0, sizeof(m_record));
+    m_record.magic      = CHECKPOINT_MAGIC;
+    m_record.version    = VERSION;
+    m_record.size       = sizeof(stRecord);
+    m_record.seq        = ++m_seq;
+    m_record.rtcTime    = rtcSeconds();
+    m_record.tripStatus = m_pSysStatus->tripStatus;
+    m_pVirtSensors->SaveTrip(m_record.trip);
+    m_pPower->GetEnergyState(m_record.energy);
+    m_record.crc = payloadCrc(m_record);
+}
+
+void TripCheckpoint::Save(bool bFlash)
+{
+    if (m_pPrefs == NULL)
+        return;
+
+    uint32_t ti = (uint32_t)SysClock::Millis();
+    uint32_t us = micros();
+    capture();
+    s_rtcRecord = m_record;
+    m_rtcCost.usLast = micros() - us;
+    m_rtcCost.usMax = max(m_rtcCost.usMax, m_rtcCost.usLast);
+    m_rtcCost.n++;
+    m_tiRtc = ti + RTC_MS;
+    if (!bFlash)
+        return;
+
+    // same state as in flash: no write
+    uint32_t crc = stateCrc(m_record);
+    m_tiNvs = ti + NVS_MS;
+    if (crc == m_nvsCrc)
+        return;
+
+    us = micros();
+    m_pPrefs->putBytes(CHECKPOINT_KEY, &m_record, sizeof(m_record));
+    m_nvsCost.usLast = micros() - us;
+    m_nvsCost.usMax = max(m_nvsCost.usMax, m_nvsCost.usLast);
+    m_nvsCost.n++;
+    m_nvsCrc = crc;
+
+    Serial.printf("checkpoint: #%u, %u bytes, RTC %u us (max %u), NVS %u us (max %u, %u writes)\r\n", m_record.seq, sizeof(stRecord),
+        m_rtcCost.usLast, m_rtcCost.usMax, m_nvsCost.usLast, m_nvsCost.usMax, m_nvsCost.n);
+}
+
+void TripCheckpoint::Poll(uint32_t timestamp)
+{
+    if (SysClock::IsDue(timestamp, m_tiNvs))
+        Save(true);
+    else if (SysClock::IsDue(timestamp, m_tiRtc))
+        Save(false);
+}
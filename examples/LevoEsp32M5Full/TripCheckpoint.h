@@ -0,0 +1,85 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * Trip and power state checkpoints, a ride continues after reboot
+ *
+ * One fixed size record with magic, version, sequence and CRC:
+ * - RTC slow memory every RTC_MS, survives reset, crash and brown-out
+ *   as long as the RTC domain keeps its supply, costs a few microseconds
+ * - Preferences (NVS) every NVS_MS if the state changed, and at trip
+ *   start/stop/finish, survives a power cut
+ * Restore() at boot takes the newest valid record.
+ *
+ */
+
+#ifndef TRIP_CHECKPOINT_H
+#define TRIP_CHECKPOINT_H
+
+#include <M5Core2.h>
+#include <Preferences.h>
+#include "SystemStatus.h"
+#include "VirtualSensors.h"
+#include "PowerUtil.h"
+
+class TripCheckpoint
+{
+public:
+    enum
+    {
+        VERSION      = 1,     // increment on record layout change
+        RTC_MS       = 5000,
+        NVS_MS       = 60000,
+        RESUME_MAX_S = 900,   // older: trip values restored, trip stopped, no energy state
+    };
+
+    void Init(Preferences& prefs, VirtualSensors& virtSensors, PowerUtil& power, SystemStatus& sysStatus);
+    bool Restore(DisplayData& dispData); // once at boot
+    void Poll(uint32_t timestamp);       // periodic checkpoints
+    void Save(bool bFlash = true);       // now, i.e. trip state changed
+
+    struct stRecord
+    {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t size;
+        uint32_t seq;
+        uint32_t rtcTime;     // seconds since 2000, age at restore
+        uint8_t  tripStatus;  // SystemStatus::enTripStatus
+        uint8_t  reserved[3];
+        VirtualSensors::stTripState trip;
+        PowerUtil::stEnergyState    energy;
+        uint32_t crc;
+    };
+
+protected:
+    Preferences*    m_pPrefs      = NULL;
+    VirtualSensors* m_pVirtSensors = NULL;
+    PowerUtil*      m_pPower      = NULL;
+    SystemStatus*   m_pSysStatus  = NULL;
+
+    stRecord m_record;
+    uint32_t m_seq       = 0;
+    uint32_t m_tiRtc     = 0;
+    uint32_t m_tiNvs     = 0;
+    uint32_t m_nvsCrc    = 0;     // last record in flash, unchanged state is not written again
+
+    // cost per checkpoint
+    struct stCost
+    {
+        uint32_t n;
+        uint32_t usLast;
+        uint32_t usMax;
+    };
+    stCost   m_rtcCost = {};
+    stCost   m_nvsCost = {};
+
+    void     capture();
+    bool     isValid(const stRecord& record);
+    static uint32_t payloadCrc(const stRecord& record);
+    static uint32_t stateCrc(const stRecord& record);
+    static uint32_t rtcSeconds();
+};
+
+#endif // TRIP_CHECKPOINT_H
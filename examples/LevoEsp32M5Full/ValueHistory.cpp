@@ -0,0 +1,27 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * Fixed size ring buffer of sampled values for chart fields
+ *
+ */
+
+#include "ValueHistory.h"
+
+void ValueHistory::Add(float val)
+{
+    m_samples[m_head] = val;
+    m_head = (m_head + 1) % SIZE;
+    if (m_count < SIZE)
+        m_count++;
+    m_nAdded++;
+}
+
+float ValueHistory::Max() const
+{
+    float fMax = 0.0f;
+    for (int i = 0; i < m_count; i++)
+        fMax = max(fMax, Get(i));
+    return fMax;
+}
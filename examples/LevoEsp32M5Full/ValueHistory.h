@@ -0,0 +1,39 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * Fixed size ring buffer of sampled values for chart fields
+ *
+ */
+
+#ifndef VALUEHISTORY_H
+#define VALUEHISTORY_H
+
+#include "Arduino.h"
+
+class ValueHistory
+{
+public:
+    enum
+    {
+        SIZE      = 160,  // samples, one column per sample in a half width chart
+        SAMPLE_MS = 2000, // 5:20 min history
+    };
+
+    void     Add(float val);
+    void     Clear() { m_head = 0; m_count = 0; m_nAdded = 0; }
+    int      Count() const { return m_count; }
+    float    Get(int i) const { return m_samples[(m_head + SIZE - m_count + i) % SIZE]; } // 0: oldest
+    float    Last() const { return Get(m_count - 1); }
+    uint32_t NumAdded() const { return m_nAdded; } // detects new samples
+    float    Max() const;
+
+protected:
+    float    m_samples[SIZE];
+    int      m_head   = 0;  // next write position
+    int      m_count  = 0;
+    uint32_t m_nAdded = 0;
+};
+
+#endif // VALUEHISTORY_H
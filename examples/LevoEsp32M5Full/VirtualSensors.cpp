@@ -9,6 +9,7 @@
 
 #include <M5Core2.h>
 #include "VirtualSensors.h"
+#include "SysClock.h"
 
 VirtualSensors::VirtualSensors()
 {
@@ -36,19 +37,19 @@ VirtualSensors::VirtualSensors()
 void VirtualSensors::StartTrip(DisplayData& DispData)
 {
     m_tripStatus = STARTED;
-    m_startTime = millis();
+    m_startTime = SysClock::Millis();
 
     refreshTripDisplay(DispData);
 
     // needs special treatment since this value changes only from time to time and trip will not be started yet at power on 
-    setValue( DisplayData::TRIP_PEAKBATTTEMP, m_lastBattTemp, m_startTime );
+    setValue( DisplayData::TRIP_PEAKBATTTEMP, m_lastBattTemp, (uint32_t)m_startTime );
 }
 
 void VirtualSensors::StopTrip()
 {
     int i;
     m_tripStatus = STOPPED;
-    m_stopTime = millis();
+    m_stopTime = SysClock::Millis();
 
     for (i = 0; i < DisplayData::numElements; i++)
     {
@@ -73,6 +74,40 @@ void VirtualSensors::ResetTrip()
     }
 }
 
+void VirtualSensors::SaveTrip(stTripState& state)
+{
+    memset(&state, 0, sizeof(state));
+    for (int i = 0; i < DisplayData::numElements && state.nValues < MAX_TRIP_VALUES; i++)
+    {
+        stVirtSensorValue* pValue = m_sensorValues[i];
+        if (pValue)
+            pValue->save(state.values[state.nValues++]);
+    }
+}
+
+// values in the same order as saved, trip time continues from now
+bool VirtualSensors::RestoreTrip(const stTripState& state, bool bStarted, DisplayData& DispData)
+{
+    int n = 0;
+    for (int i = 0; i < DisplayData::numElements; i++)
+        if (m_sensorValues[i])
+            n++;
+    if (n != state.nValues)
+        return false;
+
+    n = 0;
+    for (int i = 0; i < DisplayData::numElements; i++)
+    {
+        stVirtSensorValue* pValue = m_sensorValues[i];
+        if (pValue)
+            pValue->restore(state.values[n++]);
+    }
+    m_tripStatus = bStarted ? STARTED : STOPPED;
+    m_startTime = m_stopTime = SysClock::Millis();
+    refreshTripDisplay(DispData);
+    return true;
+}
+
 void VirtualSensors::refreshTripDisplay(DisplayData& DispData)
 {
     for (int i = 0; i < DisplayData::numElements; i++)
@@ -94,8 +129,8 @@ bool VirtualSensors::WriteStatisticsSD(DisplayData& DispData)
     char filename[20];
     RTC_DateTypeDef RTC_Date;
     RTC_TimeTypeDef RTC_Time;
-    M5.Rtc.GetDate(&RTC_Date);
-    M5.Rtc.GetTime(&RTC_Time);
+    SysClock::GetDate(&RTC_Date);
+    SysClock::GetTime(&RTC_Time);
     snprintf(filename, sizeof( filename), "/%02d%02d%02d.txt", RTC_Date.Date, RTC_Date.Month, (uint8_t)(RTC_Date.Year-2000));
 
     // check card
@@ -324,12 +359,17 @@ void VirtualSensors::stMinValue::setValue(float fVal, uint32_t timestamp)
 // elevation gain
 void VirtualSensors::stSumupPositiveValue::setValue( float fVal, uint32_t timestamp )
 {
+    const float hysteresis = 1.0; // m, sensor noise does not sum up
     if (startValue == 0.0)
         startValue = fVal;
     float newVal = fVal - startValue;
-    if( newVal > 0.0 )
+    if( newVal >= hysteresis )
+    {
         currentTripValue += newVal;
-    startValue = fVal;
+        startValue = fVal;
+    }
+    else if( newVal < 0.0 )
+        startValue = fVal;
     lastTime = timestamp;
     bChanged = true;
 }
@@ -396,11 +436,10 @@ void VirtualSensors::updateTripTime(uint32_t timestamp)
     stAbsDifferenceValue* pValue = static_cast<stAbsDifferenceValue*>(m_sensorValues[DisplayData::TRIP_TIME]);
     if (pValue)
     {
-        if (m_tripStatus == STARTED && timestamp > (pValue->lastTime + 1000))
+        if (m_tripStatus == STARTED && timestamp - pValue->lastTime >= 1000)
         {
-            if (pValue->startValue == 0.0)
-                pValue->startValue = (float)m_startTime / 1000.0;
-            pValue->currentTripValue = (float)timestamp / 1000.0 - pValue->startValue;
+            // 64 bit difference, float only for the duration
+            pValue->currentTripValue = (float)(SysClock::Millis() - m_startTime) / 1000.0;
             pValue->lastTime = timestamp;
             pValue->bChanged = true;
         }
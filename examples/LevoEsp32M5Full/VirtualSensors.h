@@ -33,6 +33,17 @@ public:
     } enTripStatus;
     enTripStatus m_tripStatus = RESET;
 
+    // trip values for checkpoints, restored values continue like after StopTrip()
+    enum { MAX_TRIP_VALUES = 24 };
+    struct stTripState
+    {
+        uint8_t nValues;
+        uint8_t reserved[3];
+        float   values[MAX_TRIP_VALUES][2];
+    };
+    void SaveTrip(stTripState& state);
+    bool RestoreTrip(const stTripState& state, bool bStarted, DisplayData& DispData);
+
 protected:
     // inclination calculation
     class InclinationQueue
@@ -66,8 +77,8 @@ protected:
     float m_lastBattEnergy = 0.0;
 
     // start stop time values
-    uint32_t m_startTime = 0L;
-    uint32_t m_stopTime  = 0L;
+    uint64_t m_startTime = 0L; // SysClock::Millis()
+    uint64_t m_stopTime  = 0L;
 
     // trip values - abstract base class
     struct stVirtSensorValue
@@ -79,6 +90,8 @@ protected:
         virtual void reset() = 0;
         virtual void setValue(float fVal, uint32_t timestamp) = 0;
         virtual bool deliverValue( float & fVal, bool bForce = false ) = 0;
+        virtual void save(float* p) = 0;
+        virtual void restore(const float* p) = 0;
     };
     struct stAbsDifferenceValue : stVirtSensorValue
     {
@@ -90,6 +103,8 @@ protected:
         virtual void reset() { currentTripValue = pastTripValueSum =  startValue = 0.0; }
         virtual void setValue(float fVal, uint32_t timestamp);
         virtual bool deliverValue( float & fVal, bool bForce = false );
+        virtual void save(float* p) { p[0] = currentTripValue + pastTripValueSum; }
+        virtual void restore(const float* p) { reset(); pastTripValueSum = p[0]; }
     };
     struct stPeakValue : stVirtSensorValue
     {
@@ -101,6 +116,8 @@ protected:
         virtual void reset() { currentTripValue = pastTripValueSum = startValue = 0.0; }
         virtual void setValue(float fVal, uint32_t timestamp);
         virtual bool deliverValue(float& fVal, bool bForce = false);
+        virtual void save(float* p) { p[0] = max(currentTripValue, pastTripValueSum); }
+        virtual void restore(const float* p) { reset(); pastTripValueSum = p[0]; }
     };
     struct stMinValue : stVirtSensorValue
     {
@@ -112,6 +129,8 @@ protected:
         virtual void reset() { currentTripValue = pastTripValueSum = startValue = 0.0; }
         virtual void setValue(float fVal, uint32_t timestamp);
         virtual bool deliverValue(float& fVal, bool bForce = false);
+        virtual void save(float* p) { p[0] = (pastTripValueSum == 0.0) ? currentTripValue : min(currentTripValue, pastTripValueSum); }
+        virtual void restore(const float* p) { reset(); pastTripValueSum = currentTripValue = p[0]; }
     };
     struct stSumupPositiveValue : stVirtSensorValue
     {
@@ -123,6 +142,8 @@ protected:
         virtual void reset() { currentTripValue = pastTripValueSum = startValue = 0.0; }
         virtual void setValue(float fVal, uint32_t timestamp);
         virtual bool deliverValue(float& fVal, bool bForce = false);
+        virtual void save(float* p) { p[0] = currentTripValue + pastTripValueSum; }
+        virtual void restore(const float* p) { reset(); pastTripValueSum = p[0]; }
     };
     struct stIntegrationValue : stVirtSensorValue
     {
@@ -133,6 +154,8 @@ protected:
         virtual void reset() { currentTripValue = pastTripValueSum = 0.0; lastTime = 0; }
         virtual void setValue(float fVal, uint32_t timestamp);
         virtual bool deliverValue(float& fVal, bool bForce = false);
+        virtual void save(float* p) { p[0] = currentTripValue + pastTripValueSum; }
+        virtual void restore(const float* p) { reset(); pastTripValueSum = p[0]; }
     };
     struct stAverageValue : stVirtSensorValue
     {
@@ -143,6 +166,8 @@ protected:
         virtual void reset() { currentTripValue = sumTime = 0.0; lastTime = 0; }
         virtual void setValue(float fVal, uint32_t timestamp);
         virtual bool deliverValue(float& fVal, bool bForce = false);
+        virtual void save(float* p) { p[0] = currentTripValue; p[1] = sumTime; }
+        virtual void restore(const float* p) { currentTripValue = p[0]; sumTime = p[1]; lastTime = 0; }
     };
     struct stAverageNonZeroValue : stAverageValue
     {
@@ -156,6 +181,8 @@ protected:
         virtual void reset() { value = 0.0; }
         virtual void setValue(float fVal, uint32_t timestamp);
         virtual bool deliverValue(float& fVal, bool bForce = false);
+        virtual void save(float* p) { p[0] = value; }
+        virtual void restore(const float* p) { value = p[0]; }
     };
     stVirtSensorValue* m_sensorValues[DisplayData::numElements] = {0};
 
@@ -0,0 +1,564 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * Host tool: replay a recorded ride through the M5Full data pipeline
+ *
+ * Simulator -> display sink, FileLogger, VirtualSensors, PowerUtil with
+ * the same wiring and timers as loop() in LevoEsp32M5Full.ino. The clock
+ * follows the log time, so a ride is replayed as fast as the host can.
+ *
+ * build:   cmake -S extras/HostBench -B build && cmake --build build
+ *          (-DBIKEPOWERCALC_DIR=<path to BikePowerCalc/src> for PowerUtil)
+ *
+ * usage:   levobench [-f <log format>] [-x <speed>] [-v] <ride.txt>
+ *          ride.txt    CSV_TABLE or CSV_SIMPLE log, log files are written to the same directory
+ *          -f          FileLogger format 0..6, default CSV_SIMPLE, 0: no log file
+ *          -x          replay speed, 0 (default): max. speed
+ *          -v          serial output of the sketch classes to stdout
+ *
+ *          levobench -p
+ *          PowerMath tables against pow() (altitude, sealevel, air density)
+ *          and the power model against pow() and BikePowerCalc over a grid
+ *          of speed, grade, altitude and air temperature plus acceleration
+ *          ramps: max. error and time per call, exit code 1 if BikePowerCalc
+ *          and PowerMath::Power differ by more than 1 W or 1 %
+ *
+ *          levobench -r <route.gpx> [<points>]
+ *          RoutePlanner::Plan on a GPX track: time and peak heap, the track
+ *          is generated with <points> track points (default 100000) if the
+ *          file does not exist, its directory is the SD card
+ *
+ */
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <time.h>
+#include "HostPlatform.h"
+#include "DisplaySink.h"
+#include "FileLogger.h"
+#include "Simulator.h"
+#include "VirtualSensors.h"
+#include "PowerMath.h"
+#include "RoutePlanner.h"
+#ifdef HAVE_POWERUTIL
+    #include "PowerUtil.h"
+#endif
+
+// components for time and heap statistics
+enum enComponent
+{
+    COMP_NONE = 0,
+    COMP_SIMULATOR,
+    COMP_DISPLAY,
+    COMP_LOGGER,
+    COMP_VIRTSENSORS,
+    COMP_POWER,
+    NUM_COMPONENTS,
+    COMP_ROUTEPLANNER = NUM_COMPONENTS, // -r only
+};
+static const char* s_componentNames[NUM_COMPONENTS] = { "", "Simulator", "Display sink", "FileLogger", "VirtualSensors", "PowerUtil" };
+
+struct stComponentStats
+{
+    uint64_t nCalls;
+    uint64_t ns;
+    size_t   staticSize;
+};
+static stComponentStats s_stats[NUM_COMPONENTS] = {};
+
+// time and heap of one call
+class ComponentScope
+{
+public:
+    ComponentScope(enComponent comp) : m_comp(comp), m_start(std::chrono::steady_clock::now()) { HostPlatform::SetComponent(comp); }
+    ~ComponentScope()
+    {
+        s_stats[m_comp].ns += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count();
+        s_stats[m_comp].nCalls++;
+        HostPlatform::SetComponent(COMP_NONE);
+    }
+protected:
+    enComponent m_comp;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+// formats each value like the screen fields do, nothing is drawn
+class BenchDisplaySink : public DisplaySink
+{
+public:
+    void ShowValue(DisplayData::enIds id, float val, DisplayData& dispData)
+    {
+        const DisplayData::stDisplayData* pDesc = dispData.GetDescription(id);
+        if (pDesc == NULL || val == m_values[id])
+            return;
+        m_values[id] = val;
+        char text[16];
+        dtostrf(val, 6, pDesc->nPrecision, text);
+        m_nDrawn++;
+    }
+    uint64_t m_nDrawn = 0;
+protected:
+    float m_values[DisplayData::numElements] = {};
+};
+
+DisplayData      DispData;
+BenchDisplaySink Screen;
+FileLogger       Logger;
+VirtualSensors   VirtSensors;
+Simulator        SensorSimulator;
+#ifdef HAVE_POWERUTIL
+    PowerUtil    Power;
+    Preferences  Prefs;
+    Settings     Config;
+#endif
+
+FileLogger::enLogFormat _logFormat = FileLogger::CSV_SIMPLE;
+
+// as in LevoEsp32M5Full.ino
+void ShowFloatData(DisplayData::enIds id, float fVal, uint32_t timestamp)
+{
+    {
+        ComponentScope scope(COMP_DISPLAY);
+        Screen.ShowValue(id, fVal, DispData);
+    }
+    if (_logFormat != FileLogger::NONE)
+    {
+        ComponentScope scope(COMP_LOGGER);
+        LevoEsp32Ble::stBleVal bleVal;
+        bleVal.unionType = LevoEsp32Ble::FLOAT; bleVal.fVal = fVal;
+        Logger.Writeln(id, bleVal, DispData, _logFormat, timestamp);
+    }
+}
+
+void FeedForward(DisplayData::enIds id, float fVal, uint32_t timestamp, bool bFromVirt)
+{
+    if (!bFromVirt)
+    {
+        ComponentScope scope(COMP_VIRTSENSORS);
+        VirtSensors.FeedValue(id, fVal, timestamp);
+    }
+#ifdef HAVE_POWERUTIL
+    {
+        ComponentScope scope(COMP_POWER);
+        Power.FeedValue(id, fVal, timestamp);
+    }
+#endif
+}
+
+static void printReport(uint64_t nValues, uint32_t rideMs, uint64_t wallUs, double cpuS)
+{
+    printf("\nride: %.1f min replayed in %.3f s (%.0fx), %llu values, %.0f values/s, process CPU %.3f s\n",
+        rideMs / 60000.0, wallUs / 1e6, wallUs ? rideMs * 1000.0 / wallUs : 0.0,
+        (unsigned long long)nValues, wallUs ? nValues * 1e6 / wallUs : 0.0, cpuS);
+
+    printf("\n%-16s %10s %10s %9s %10s %10s %10s\n", "component", "calls", "time ms", "ns/call", "static B", "heap peak", "allocs");
+    for (int i = 1; i < NUM_COMPONENTS; i++)
+    {
+        HostPlatform::stHeapStats heap;
+        HostPlatform::GetHeapStats(i, heap);
+        const stComponentStats& s = s_stats[i];
+        if (s.staticSize == 0)
+        {
+            printf("%-16s (not built)\n", s_componentNames[i]);
+            continue;
+        }
+        printf("%-16s %10llu %10.1f %9.0f %10zu %10llu %10llu\n", s_componentNames[i], (unsigned long long)s.nCalls, s.ns / 1e6,
+            s.nCalls ? (double)s.ns / s.nCalls : 0.0, s.staticSize, (unsigned long long)heap.peak, (unsigned long long)heap.nAllocs);
+    }
+
+    HostPlatform::stHeapStats total;
+    HostPlatform::GetHeapStats(total);
+    printf("\nheap: peak %llu bytes, %llu allocations (all threads)\n", (unsigned long long)total.peak, (unsigned long long)total.nAllocs);
+    printf("display: %llu of %llu values changed\n", (unsigned long long)Screen.m_nDrawn, (unsigned long long)s_stats[COMP_DISPLAY].nCalls);
+}
+
+static uint64_t nsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+// max. absolute and relative (above 10 W) error of one power model
+struct stPowerError
+{
+    float  errW;
+    float  errRel;
+    size_t iMax;
+    size_t nMismatch; // points off by more than 1 W and 1 %
+
+    void Add(size_t i, float val, float ref)
+    {
+        float err = fabsf(val - ref);
+        if (err > errW)
+        {
+            errW = err;
+            iMax = i;
+        }
+        if (fabsf(ref) > 10.0f)
+            errRel = max(errRel, err / fabsf(ref));
+        if (err > 1.0f && err > 0.01f * fabsf(ref))
+            nMismatch++;
+    }
+};
+
+// -p: barometric formula and air density tables against pow()
+static void benchBarometric()
+{
+    const int n = 100000;
+    int i;
+    float errAlt = 0.0f, errSea = 0.0f, errRho = 0.0f;
+    for (i = 0; i < n; i++)
+    {
+        float hPa      = 500.0f + 550.0f * i / n;
+        float altitude = -400.0f + 6300.0f * i / n;
+        errAlt = max(errAlt, fabsf(PowerMath::AltitudeFromPressure(hPa, 1013.25f) - PowerMath::AltitudeFromPressurePow(hPa, 1013.25f)));
+        errSea = max(errSea, fabsf(PowerMath::SealevelFromAltitude(950.0f, altitude) - PowerMath::SealevelFromAltitudePow(950.0f, altitude)));
+        errRho = max(errRho, fabsf(PowerMath::AirDensity(altitude, 18.0f) - PowerMath::AirDensityPow(altitude, 18.0f)));
+    }
+
+    volatile float sink = 0.0f;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (i = 0; i < n; i++)
+        sink += PowerMath::AltitudeFromPressurePow(900.0f + 0.001f * i, 1013.25f) + PowerMath::AirDensityPow(0.05f * i, 18.0f);
+    uint64_t nsPow = nsSince(start);
+    start = std::chrono::steady_clock::now();
+    for (i = 0; i < n; i++)
+        sink += PowerMath::AltitudeFromPressure(900.0f + 0.001f * i, 1013.25f) + PowerMath::AirDensity(0.05f * i, 18.0f);
+    uint64_t nsTable = nsSince(start);
+
+    printf("barometric tables: max error altitude %.4f m, sealevel %.4f hPa, air density %.6f kg/m^3\n", errAlt, errSea, errRho);
+    printf("altitude + air density: pow() %.1f ns, tables %.1f ns\n\n", (double)nsPow / n, (double)nsTable / n);
+}
+
+// -p: PowerMath::Power and PowerSegments against the pow() reference and BikePower::CurrentPower
+static int benchPower()
+{
+    PowerMath::Init();
+    benchBarometric();
+    PowerMath::stModel model = { 110.0f, 0.009725f, 0.437392f };
+
+    std::vector<float> speed, incl, alti, temp, dur;
+    for (float v = 0.5f; v <= 15.0f; v += 0.5f)                 // m/s
+        for (float g = -20.0f; g <= 20.0f; g += 1.0f)           // percent
+            for (float a = -400.0f; a <= 5000.0f; a += 200.0f)  // m
+                for (float t = -10.0f; t <= 40.0f; t += 5.0f)   // degree celsius
+                {
+                    speed.push_back(v);
+                    incl.push_back(g);
+                    alti.push_back(a);
+                    temp.push_back(t);
+                    dur.push_back(1.0f);
+                }
+    size_t i, n = speed.size();
+    std::vector<float> ref(n), power(n), segPower(n);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (i = 0; i < n; i++)
+        ref[i] = PowerMath::PowerPow(model, speed[i], incl[i], alti[i], temp[i]);
+    uint64_t nsPow = nsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    for (i = 0; i < n; i++)
+        power[i] = PowerMath::Power(model, speed[i], incl[i], alti[i], temp[i]);
+    uint64_t nsTable = nsSince(start);
+
+    PowerMath::stSegments seg = { speed.data(), incl.data(), alti.data(), temp.data(), dur.data(), n };
+    start = std::chrono::steady_clock::now();
+    PowerMath::PowerSegments(model, seg, segPower.data());
+    uint64_t nsSegments = nsSince(start);
+
+    stPowerError errTable = {}, errSegments = {};
+    for (i = 0; i < n; i++)
+    {
+        errTable.Add(i, power[i], ref[i]);
+        // segments take the acceleration from the speed change, 1 s per segment
+        float accel = (i > 0) ? speed[i] - speed[i - 1] : 0.0f;
+        errSegments.Add(i, segPower[i], PowerMath::Power(model, speed[i], incl[i], alti[i], temp[i], accel));
+    }
+
+    printf("power model grid: %zu points, mass %.0f kg, cR %f, cwA %f\n\n", n, model.mass, model.cR, model.cwA);
+    printf("%-26s %10s %9s %8s   %s\n", "model", "max err W", "rel err", "ns/call", "max err at v m/s, grade %, alt m, temp C");
+    printf("%-26s %10s %9s %8.1f\n", "pow() reference", "-", "-", (double)nsPow / n);
+    printf("%-26s %10.4f %8.4f%% %8.1f   %.1f, %.0f, %.0f, %.0f\n", "Power vs pow()", errTable.errW, errTable.errRel * 100.0f, (double)nsTable / n,
+        speed[errTable.iMax], incl[errTable.iMax], alti[errTable.iMax], temp[errTable.iMax]);
+    printf("%-26s %10.4f %8.4f%% %8.1f   against Power with same acceleration\n", "PowerSegments vs Power", errSegments.errW, errSegments.errRel * 100.0f,
+        (double)nsSegments / n);
+
+#ifdef HAVE_POWERUTIL
+    // library at constant speed: second call of each point has no acceleration
+    BikePower bikePower;
+    bikePower.SetSystemParams(model.mass, model.cR, model.cwA);
+    std::vector<float> libPower(n);
+    uint32_t ts = 1000;
+    start = std::chrono::steady_clock::now();
+    for (i = 0; i < n; i++)
+    {
+        bikePower.CurrentPower(speed[i], incl[i], alti[i], temp[i], ts);
+        libPower[i] = bikePower.CurrentPower(speed[i], incl[i], alti[i], temp[i], ts + 1000);
+        ts += 2000;
+    }
+    uint64_t nsLib = nsSince(start);
+
+    stPowerError errLib = {}, errLibPow = {};
+    for (i = 0; i < n; i++)
+    {
+        errLib.Add(i, power[i], libPower[i]);
+        errLibPow.Add(i, ref[i], libPower[i]);
+    }
+    printf("%-26s %10s %9s %8.1f\n", "BikePower::CurrentPower", "-", "-", (double)nsLib / (2 * n));
+    printf("%-26s %10.4f %8.4f%% %8s   %.1f, %.0f, %.0f, %.0f\n", "Power vs CurrentPower", errLib.errW, errLib.errRel * 100.0f, "",
+        speed[errLib.iMax], incl[errLib.iMax], alti[errLib.iMax], temp[errLib.iMax]);
+    printf("%-26s %10.4f %8.4f%% %8s   %.1f, %.0f, %.0f, %.0f\n", "pow() vs CurrentPower", errLibPow.errW, errLibPow.errRel * 100.0f, "",
+        speed[errLibPow.iMax], incl[errLibPow.iMax], alti[errLibPow.iMax], temp[errLibPow.iMax]);
+
+    // acceleration: speed ramps with one call per second, as PowerUtil::Update does
+    BikePower rampPower;
+    rampPower.SetSystemParams(model.mass, model.cR, model.cwA);
+    stPowerError errRamp = {};
+    float lastSpeed = 0.0f, rampSpeed = 0.0f;
+    ts = 1000;
+    rampPower.CurrentPower(0.0f, 0.0f, 500.0f, 18.0f, ts);
+    for (i = 0; i < 2000; i++)
+    {
+        float accel = ((i / 50) % 4 < 2) ? 0.5f : -0.5f; // up and down ramps
+        rampSpeed   = constrain(rampSpeed + accel, 0.0f, 15.0f);
+        float grade = (float)((i / 100) % 21) - 10.0f;
+        ts += 1000;
+        float lib = rampPower.CurrentPower(rampSpeed, grade, 500.0f, 18.0f, ts);
+        errRamp.Add(i, PowerMath::Power(model, rampSpeed, grade, 500.0f, 18.0f, rampSpeed - lastSpeed), lib);
+        lastSpeed = rampSpeed;
+    }
+    printf("%-26s %10.4f %8.4f%%            2000 s of +-0.5 m/s^2 ramps\n", "ramps vs CurrentPower", errRamp.errW, errRamp.errRel * 100.0f);
+
+    size_t nMismatch = errLib.nMismatch + errRamp.nMismatch;
+    if (nMismatch)
+    {
+        printf("\nPowerMath::Power differs from BikePower::CurrentPower by more than 1 W and 1 %% at %zu points\n", nMismatch);
+        return 1;
+    }
+    printf("\nPowerMath::Power matches BikePower::CurrentPower\n");
+    return 0;
+#else
+    printf("\nBikePowerCalc not built: no comparison with BikePower::CurrentPower\n");
+    return 0;
+#endif
+}
+
+// hilly loop of about 10 m between points, with time stamps like a recorded track
+static bool writeGpx(const char* pPath, uint32_t nPoints)
+{
+    FILE* pFile = fopen(pPath, "w");
+    if (pFile == NULL)
+        return false;
+    fprintf(pFile, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                   "<gpx version=\"1.1\" creator=\"levobench\" xmlns=\"http://www.topografix.com/GPX/1/1\">\n"
+                   " <trk>\n  <name>levobench %u points</name>\n  <trkseg>\n", nPoints);
+    for (uint32_t i = 0; i < nPoints; i++)
+    {
+        double angle = 2.0 * M_PI * i / nPoints;
+        double lat   = 47.5 + 1.4 * sin(angle);  // ~1000 km loop
+        double lon   = 11.0 + 2.1 * cos(angle);
+        double ele   = 800.0 + 400.0 * sin(angle * 37.0) + 30.0 * sin(angle * 997.0);
+        fprintf(pFile, "   <trkpt lat=\"%.7f\" lon=\"%.7f\">\n    <ele>%.1f</ele>\n    <time>2026-10-19T%02u:%02u:%02uZ</time>\n   </trkpt>\n",
+            lat, lon, ele, (i / 3600) % 24, (i / 60) % 60, i % 60);
+    }
+    fprintf(pFile, "  </trkseg>\n </trk>\n</gpx>\n");
+    return fclose(pFile) == 0;
+}
+
+// -r: route planning time and memory
+static int benchRoute(const char* pRoute, uint32_t nPoints)
+{
+    std::string route = pRoute;
+    size_t slash = route.find_last_of('/');
+    HostPlatform::SetSdRoot(slash == std::string::npos ? "." : route.substr(0, slash).c_str());
+    std::string sdName = "/" + route.substr(slash == std::string::npos ? 0 : slash + 1);
+
+    FILE* pFile = fopen(pRoute, "r");
+    if (pFile == NULL)
+    {
+        printf("generating %s with %u track points\n", pRoute, nPoints);
+        if (!writeGpx(pRoute, nPoints))
+        {
+            fprintf(stderr, "can't write %s\n", pRoute);
+            return 1;
+        }
+        pFile = fopen(pRoute, "r");
+    }
+    fseek(pFile, 0, SEEK_END);
+    long fileSize = ftell(pFile);
+    fclose(pFile);
+
+    PowerMath::Init();
+    RoutePlanner::stParams params;
+    RoutePlanner::InitParams(params);
+    params.remainWh = 500.0f;
+
+    // allocated like PowerUtil::PlanRoute does
+    bool bOk;
+    RoutePlanner::stResult result;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    clock_t cpuStart = clock();
+    {
+        ComponentScope scope(COMP_ROUTEPLANNER);
+        RoutePlanner* pPlanner = new RoutePlanner;
+        bOk = pPlanner->Plan(sdName.c_str(), params, result);
+        delete pPlanner;
+    }
+    uint64_t ns = nsSince(start);
+    double cpuS = (double)(clock() - cpuStart) / CLOCKS_PER_SEC;
+
+    HostPlatform::stHeapStats heap;
+    HostPlatform::GetHeapStats(COMP_ROUTEPLANNER, heap);
+    printf("\nroute: %s, %.1f MB, %u track points, %u segments\n", bOk ? "ok" : "failed",
+        fileSize / 1e6, result.nTrackPoints, result.nSegments);
+    printf("result: %.1f km, %.0f hm, %.0f Wh, range %.1f km with %.0f Wh\n",
+        result.distance, result.elevationGain, result.energyWh, result.range, params.remainWh);
+    printf("time: %.1f ms (%.0f ns/point, %.1f MB/s), process CPU %.3f s\n",
+        ns / 1e6, result.nTrackPoints ? (double)ns / result.nTrackPoints : 0.0, ns ? fileSize * 1e3 / ns : 0.0, cpuS);
+    printf("memory: RoutePlanner %zu bytes, stResult %zu bytes, heap peak %llu bytes, %llu allocations\n",
+        sizeof(RoutePlanner), sizeof(RoutePlanner::stResult), (unsigned long long)heap.peak, (unsigned long long)heap.nAllocs);
+    return bOk ? 0 : 1;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc == 2 && strcmp(argv[1], "-p") == 0)
+        return benchPower();
+    if ((argc == 3 || argc == 4) && strcmp(argv[1], "-r") == 0)
+        return benchRoute(argv[2], (argc == 4) ? strtoul(argv[3], NULL, 10) : 100000);
+
+    float speed = 0.0f;
+    bool  bVerbose = false;
+    const char* pRide = NULL;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+            _logFormat = (FileLogger::enLogFormat)atoi(argv[++i]);
+        else if (strcmp(argv[i], "-x") == 0 && i + 1 < argc)
+            speed = atof(argv[++i]);
+        else if (strcmp(argv[i], "-v") == 0)
+            bVerbose = true;
+        else
+            pRide = argv[i];
+    }
+    if (pRide == NULL || _logFormat >= FileLogger::NUM_FORMATS)
+    {
+        fprintf(stderr, "usage: levobench [-f <log format>] [-x <speed>] [-v] <ride.txt>\n"
+                        "       levobench -p\n"
+                        "       levobench -r <route.gpx> [<points>]\n");
+        return 1;
+    }
+
+    // ride directory is the SD card
+    std::string ride = pRide;
+    size_t slash = ride.find_last_of('/');
+    HostPlatform::SetSdRoot(slash == std::string::npos ? "." : ride.substr(0, slash).c_str());
+    std::string sdName = "/" + ride.substr(slash == std::string::npos ? 0 : slash + 1);
+    HostPlatform::SetSerialMute(!bVerbose);
+
+    s_stats[COMP_SIMULATOR].staticSize   = sizeof(Simulator);
+    s_stats[COMP_DISPLAY].staticSize     = sizeof(BenchDisplaySink) + sizeof(DisplayData);
+    s_stats[COMP_LOGGER].staticSize      = sizeof(FileLogger);
+    s_stats[COMP_VIRTSENSORS].staticSize = sizeof(VirtualSensors);
+
+    // setup()
+    uint32_t ti = 1000;
+    HostPlatform::SetMillis(ti);
+    PowerMath::Init();
+#ifdef HAVE_POWERUTIL
+    s_stats[COMP_POWER].staticSize = sizeof(PowerUtil);
+    Config.Load(Prefs);
+    Power.SysParamsInit(Config);
+#endif
+    SensorSimulator.SetSpeed(speed);
+    if (!SensorSimulator.Open(sdName.c_str(), DispData))
+    {
+        fprintf(stderr, "can't replay %s\n", pRide);
+        return 1;
+    }
+    Logger.SetSerialEcho(false);
+    if (_logFormat != FileLogger::NONE)
+    {
+        Logger.Init(DispData);
+        Logger.Open(_logFormat);
+    }
+
+    // loop()
+    uint32_t ti50 = ti + 50, ti100 = ti + 100, ti1000 = ti + 1000;
+    uint32_t tiStart = ti;
+    uint64_t nValues = 0;
+    clock_t cpuStart = clock();
+    uint64_t usStart = HostPlatform::Micros();
+    for (;;)
+    {
+        DisplayData::enIds id;
+        float fVal;
+        bool bValue = false;
+        for (int i = 0; i < 64; i++)
+        {
+            {
+                ComponentScope scope(COMP_SIMULATOR);
+                bValue = SensorSimulator.Update(id, fVal, ti);
+            }
+            if (!bValue)
+                break;
+            uint32_t simTime = SensorSimulator.GetTime();
+            ShowFloatData(id, fVal, simTime);
+            FeedForward(id, fVal, simTime, false);
+            nValues++;
+        }
+        if (!SensorSimulator.IsOpen())
+            break;
+
+        // clock follows log time at max. speed
+        if (speed <= 0.0f)
+            ti = max(ti + 1, SensorSimulator.GetTime());
+        else if (!bValue)
+            ti += 10;
+        HostPlatform::SetMillis(ti);
+
+        if (ti >= ti50)
+        {
+            ti50 = ti + 50;
+            bool bUpdate;
+            {
+                ComponentScope scope(COMP_VIRTSENSORS);
+                bUpdate = VirtSensors.Update(id, fVal, ti);
+            }
+            if (bUpdate)
+            {
+                ShowFloatData(id, fVal, ti);
+                FeedForward(id, fVal, ti, true);
+            }
+        }
+        if (ti >= ti100)
+        {
+            ti100 = ti + 100;
+            ComponentScope scope(COMP_LOGGER);
+            Logger.Poll(ti);
+        }
+        if (ti >= ti1000)
+        {
+            ti1000 = ti + 1000;
+#ifdef HAVE_POWERUTIL
+            bool bUpdate;
+            {
+                ComponentScope scope(COMP_POWER);
+                bUpdate = Power.Update(id, fVal, ti);
+            }
+            if (bUpdate)
+                ShowFloatData(id, fVal, ti);
+#endif
+        }
+    }
+    uint64_t wallUs = HostPlatform::Micros() - usStart;
+    double cpuS = (double)(clock() - cpuStart) / CLOCKS_PER_SEC;
+
+    HostPlatform::SetSerialMute(false);
+    Logger.Close();
+    printReport(nValues, ti - tiStart, wallUs, cpuS);
+    return 0;
+}
@@ -0,0 +1,59 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * host replacement for the Arduino core, only what the sketch classes use
+ *
+ */
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include "HostPlatform.h"
+#include "freertos.h"
+
+using std::min;
+using std::max;
+
+#ifndef PI
+#define PI 3.1415926535897932384626433832795
+#endif
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+inline uint32_t millis() { return HostPlatform::Millis(); }
+inline uint32_t micros() { return HostPlatform::Micros(); }
+void delay(uint32_t ms);
+inline void yield() {}
+char* dtostrf(double val, signed char width, unsigned char prec, char* pBuf);
+
+class HardwareSerial
+{
+public:
+    void   begin(unsigned long) {}
+    int    printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+    size_t print(const char* s)         { return HostPlatform::IsSerialMute() ? 0 : (size_t)fputs(s, stdout); }
+    size_t print(int n)                 { return HostPlatform::IsSerialMute() ? 0 : (size_t)::printf("%d", n); }
+    size_t print(unsigned int n)        { return HostPlatform::IsSerialMute() ? 0 : (size_t)::printf("%u", n); }
+    size_t print(double d, int p = 2)   { return HostPlatform::IsSerialMute() ? 0 : (size_t)::printf("%.*f", p, d); }
+    size_t println()                    { return print("\r\n"); }
+    template<class T> size_t println(T val) { size_t n = print(val); return n + println(); }
+};
+extern HardwareSerial Serial;
+
+class EspClass
+{
+public:
+    uint32_t getFreeHeap();
+};
+extern EspClass ESP;
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,61 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * SD card file system on a host directory, see HostPlatform::SetSdRoot()
+ *
+ */
+
+#ifndef HOST_FS_H
+#define HOST_FS_H
+
+#include "Arduino.h"
+
+#define FILE_READ   "r"
+#define FILE_WRITE  "w"
+#define FILE_APPEND "a"
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+class File
+{
+public:
+    File(FILE* pFile = NULL) : m_pFile(pFile) {}
+    operator bool() const { return m_pFile != NULL; }
+
+    size_t write(const uint8_t* pData, size_t len) { return m_pFile ? fwrite(pData, 1, len, m_pFile) : 0; }
+    size_t write(uint8_t c)                        { return write(&c, 1); }
+    int    read(uint8_t* pData, size_t len)        { return m_pFile ? (int)fread(pData, 1, len, m_pFile) : -1; }
+    int    read()                                  { return m_pFile ? fgetc(m_pFile) : -1; }
+    int    available();
+    bool   seek(uint32_t pos, SeekMode mode = SeekSet) { return m_pFile && fseek(m_pFile, pos, mode) == 0; }
+    size_t position() const                        { return m_pFile ? ftell(m_pFile) : 0; }
+    size_t size() const;
+    void   flush()                                 { if (m_pFile) fflush(m_pFile); }
+    void   close()                                 { if (m_pFile) fclose(m_pFile); m_pFile = NULL; }
+    int    printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+    size_t print(const char* s)                    { return write((const uint8_t*)s, strlen(s)); }
+    size_t println(const char* s = "")             { return print(s) + print("\r\n"); }
+
+protected:
+    FILE* m_pFile;
+};
+
+typedef enum { CARD_NONE, CARD_MMC, CARD_SD, CARD_SDHC, CARD_UNKNOWN } sdcard_type_t;
+
+class SDFS
+{
+public:
+    File          open(const char* pPath, const char* pMode = FILE_READ);
+    bool          exists(const char* pPath);
+    bool          remove(const char* pPath);
+    bool          rename(const char* pFrom, const char* pTo);
+    bool          mkdir(const char* pPath);
+    sdcard_type_t cardType();
+    uint64_t      totalBytes();
+    uint64_t      usedBytes();
+};
+extern SDFS SD;
+
+#endif // HOST_FS_H
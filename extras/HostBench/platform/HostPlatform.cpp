@@ -0,0 +1,401 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * Linux implementation of the platform used by the M5Full sketch
+ *
+ */
+
+#include <new>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include "Arduino.h"
+#include "M5Core2.h"
+
+HardwareSerial Serial;
+EspClass       ESP;
+SDFS           SD;
+M5Core2        M5;
+
+//////////////////////////////////////////////////////////////
+// clock
+
+static bool     s_bVirtualClock = false;
+static std::atomic<uint32_t> s_millis(0);
+
+static uint64_t realMicros()
+{
+    static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+void HostPlatform::SetMillis(uint32_t ms)
+{
+    s_bVirtualClock = true;
+    s_millis = ms;
+}
+
+uint32_t HostPlatform::Millis()
+{
+    return s_bVirtualClock ? s_millis.load() : (uint32_t)(realMicros() / 1000);
+}
+
+uint32_t HostPlatform::Micros()
+{
+    return (uint32_t)realMicros();
+}
+
+int64_t HostPlatform::TimerMicros()
+{
+    return s_bVirtualClock ? (int64_t)s_millis.load() * 1000 : (int64_t)realMicros();
+}
+
+void delay(uint32_t ms)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+char* dtostrf(double val, signed char width, unsigned char prec, char* pBuf)
+{
+    sprintf(pBuf, "%*.*f", width, prec, val);
+    return pBuf;
+}
+
+//////////////////////////////////////////////////////////////
+// serial
+
+static bool s_bSerialMute = false;
+
+void HostPlatform::SetSerialMute(bool bMute) { s_bSerialMute = bMute; }
+bool HostPlatform::IsSerialMute()            { return s_bSerialMute; }
+
+int HardwareSerial::printf(const char* fmt, ...)
+{
+    if (s_bSerialMute)
+        return 0;
+    va_list args;
+    va_start(args, fmt);
+    int n = vprintf(fmt, args);
+    va_end(args);
+    return n;
+}
+
+//////////////////////////////////////////////////////////////
+// heap statistics, every block carries its size and component
+
+struct stComponentHeap
+{
+    std::atomic<int64_t>  current;
+    std::atomic<int64_t>  peak;
+    std::atomic<uint64_t> nAllocs;
+};
+static stComponentHeap s_heap[HostPlatform::MAX_COMPONENTS + 1]; // last one: total
+static thread_local int s_component = 0;
+
+struct stBlockHeader
+{
+    size_t size;
+    int    component;
+    int    reserved[2]; // keep 16 byte alignment
+};
+
+static void updatePeak(stComponentHeap& heap, int64_t current)
+{
+    int64_t peak = heap.peak.load();
+    while (current > peak && !heap.peak.compare_exchange_weak(peak, current))
+        ;
+}
+
+static void* hostAlloc(size_t size)
+{
+    stBlockHeader* pHdr = (stBlockHeader*)malloc(sizeof(stBlockHeader) + size);
+    if (pHdr == NULL)
+        throw std::bad_alloc();
+    pHdr->size      = size;
+    pHdr->component = s_component;
+
+    stComponentHeap& comp  = s_heap[s_component];
+    stComponentHeap& total = s_heap[HostPlatform::MAX_COMPONENTS];
+    updatePeak(comp, comp.current += size);
+    updatePeak(total, total.current += size);
+    comp.nAllocs++;
+    total.nAllocs++;
+    return pHdr + 1;
+}
+
+static void hostFree(void* p)
+{
+    if (p == NULL)
+        return;
+    stBlockHeader* pHdr = (stBlockHeader*)p - 1;
+    s_heap[pHdr->component].current -= pHdr->size;
+    s_heap[HostPlatform::MAX_COMPONENTS].current -= pHdr->size;
+    free(pHdr);
+}
+
+void* operator new(size_t size)              { return hostAlloc(size); }
+void* operator new[](size_t size)            { return hostAlloc(size); }
+void  operator delete(void* p) noexcept      { hostFree(p); }
+void  operator delete[](void* p) noexcept    { hostFree(p); }
+void  operator delete(void* p, size_t) noexcept   { hostFree(p); }
+void  operator delete[](void* p, size_t) noexcept { hostFree(p); }
+
+void HostPlatform::SetComponent(int component)
+{
+    s_component = (component >= 0 && component < MAX_COMPONENTS) ? component : 0;
+}
+
+void HostPlatform::GetHeapStats(int component, stHeapStats& stats)
+{
+    stComponentHeap& heap = s_heap[(component >= 0 && component <= MAX_COMPONENTS) ? component : 0];
+    stats.current = heap.current;
+    stats.peak    = heap.peak;
+    stats.nAllocs = heap.nAllocs;
+}
+
+void HostPlatform::GetHeapStats(stHeapStats& stats)
+{
+    GetHeapStats(MAX_COMPONENTS, stats);
+}
+
+// like a M5Core2 with 4 MB PSRAM
+uint32_t EspClass::getFreeHeap()
+{
+    return 4 * 1024 * 1024 - (uint32_t)s_heap[HostPlatform::MAX_COMPONENTS].current;
+}
+
+//////////////////////////////////////////////////////////////
+// SD card
+
+static std::string s_sdRoot = ".";
+
+void HostPlatform::SetSdRoot(const char* pDir)
+{
+    s_sdRoot = pDir;
+}
+
+std::string HostPlatform::SdPath(const char* pPath)
+{
+    return s_sdRoot + ((pPath[0] == '/') ? "" : "/") + pPath;
+}
+
+int File::available()
+{
+    if (!m_pFile)
+        return 0;
+    return (int)(size() - position());
+}
+
+size_t File::size() const
+{
+    if (!m_pFile)
+        return 0;
+    struct stat st;
+    fflush(m_pFile);
+    return (fstat(fileno(m_pFile), &st) == 0) ? st.st_size : 0;
+}
+
+int File::printf(const char* fmt, ...)
+{
+    if (!m_pFile)
+        return 0;
+    va_list args;
+    va_start(args, fmt);
+    int n = vfprintf(m_pFile, fmt, args);
+    va_end(args);
+    return n;
+}
+
+// ESP32 modes: "r", "w", "a", "r+", ...
+File SDFS::open(const char* pPath, const char* pMode)
+{
+    std::string mode = pMode;
+    if (mode.find('b') == std::string::npos)
+        mode += "b";
+    return File(fopen(HostPlatform::SdPath(pPath).c_str(), mode.c_str()));
+}
+
+bool SDFS::exists(const char* pPath)
+{
+    struct stat st;
+    return stat(HostPlatform::SdPath(pPath).c_str(), &st) == 0;
+}
+
+bool SDFS::remove(const char* pPath)
+{
+    return ::remove(HostPlatform::SdPath(pPath).c_str()) == 0;
+}
+
+bool SDFS::rename(const char* pFrom, const char* pTo)
+{
+    return ::rename(HostPlatform::SdPath(pFrom).c_str(), HostPlatform::SdPath(pTo).c_str()) == 0;
+}
+
+bool SDFS::mkdir(const char* pPath)
+{
+    return ::mkdir(HostPlatform::SdPath(pPath).c_str(), 0755) == 0;
+}
+
+sdcard_type_t SDFS::cardType()
+{
+    struct stat st;
+    return (stat(s_sdRoot.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) ? CARD_SDHC : CARD_NONE;
+}
+
+uint64_t SDFS::totalBytes()
+{
+    struct statvfs st;
+    return (statvfs(s_sdRoot.c_str(), &st) == 0) ? (uint64_t)st.f_blocks * st.f_frsize : 0;
+}
+
+uint64_t SDFS::usedBytes()
+{
+    struct statvfs st;
+    return (statvfs(s_sdRoot.c_str(), &st) == 0) ? (uint64_t)(st.f_blocks - st.f_bfree) * st.f_frsize : 0;
+}
+
+//////////////////////////////////////////////////////////////
+// RTC: local time of the host
+
+void RTC::GetTime(RTC_TimeTypeDef* pTime)
+{
+    time_t now = time(NULL);
+    struct tm* pTm = localtime(&now);
+    pTime->Hours   = pTm->tm_hour;
+    pTime->Minutes = pTm->tm_min;
+    pTime->Seconds = pTm->tm_sec;
+}
+
+void RTC::GetDate(RTC_DateTypeDef* pDate)
+{
+    time_t now = time(NULL);
+    struct tm* pTm = localtime(&now);
+    pDate->WeekDay = pTm->tm_wday;
+    pDate->Month   = pTm->tm_mon + 1;
+    pDate->Date    = pTm->tm_mday;
+    pDate->Year    = pTm->tm_year + 1900;
+}
+
+//////////////////////////////////////////////////////////////
+// FreeRTOS
+
+// ring of items, no allocation after create
+struct HostQueue
+{
+    std::mutex              mutex;
+    std::condition_variable cond;
+    std::vector<uint8_t>    items;
+    size_t                  length;
+    size_t                  itemSize;
+    size_t                  head;
+    size_t                  count;
+};
+
+struct HostSemaphore
+{
+    std::mutex              mutex;
+    std::condition_variable cond;
+    UBaseType_t             count;
+    UBaseType_t             maxCount;
+};
+
+struct HostTask
+{
+    std::thread thread;
+};
+
+template<class L, class P> static bool waitFor(std::condition_variable& cond, L& lock, TickType_t ticks, P pred)
+{
+    if (ticks == portMAX_DELAY)
+    {
+        cond.wait(lock, pred);
+        return true;
+    }
+    return cond.wait_for(lock, std::chrono::milliseconds(ticks), pred);
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize)
+{
+    HostQueue* pQueue = new HostQueue;
+    pQueue->items.resize(length * itemSize);
+    pQueue->length   = length;
+    pQueue->itemSize = itemSize;
+    pQueue->head     = 0;
+    pQueue->count    = 0;
+    return pQueue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t hQueue, const void* pItem, TickType_t ticksToWait)
+{
+    std::unique_lock<std::mutex> lock(hQueue->mutex);
+    if (!waitFor(hQueue->cond, lock, ticksToWait, [&] { return hQueue->count < hQueue->length; }))
+        return pdFALSE;
+    size_t tail = (hQueue->head + hQueue->count) % hQueue->length;
+    memcpy(&hQueue->items[tail * hQueue->itemSize], pItem, hQueue->itemSize);
+    hQueue->count++;
+    hQueue->cond.notify_all();
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t hQueue, void* pItem, TickType_t ticksToWait)
+{
+    std::unique_lock<std::mutex> lock(hQueue->mutex);
+    if (!waitFor(hQueue->cond, lock, ticksToWait, [&] { return hQueue->count > 0; }))
+        return pdFALSE;
+    memcpy(pItem, &hQueue->items[hQueue->head * hQueue->itemSize], hQueue->itemSize);
+    hQueue->head = (hQueue->head + 1) % hQueue->length;
+    hQueue->count--;
+    hQueue->cond.notify_all();
+    return pdTRUE;
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t maxCount, UBaseType_t initialCount)
+{
+    HostSemaphore* pSem = new HostSemaphore;
+    pSem->count    = initialCount;
+    pSem->maxCount = maxCount;
+    return pSem;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t hSem, TickType_t ticksToWait)
+{
+    std::unique_lock<std::mutex> lock(hSem->mutex);
+    if (!waitFor(hSem->cond, lock, ticksToWait, [&] { return hSem->count > 0; }))
+        return pdFALSE;
+    hSem->count--;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t hSem)
+{
+    std::lock_guard<std::mutex> lock(hSem->mutex);
+    if (hSem->count >= hSem->maxCount)
+        return pdFALSE;
+    hSem->count++;
+    hSem->cond.notify_all();
+    return pdTRUE;
+}
+
+// tasks run until process exit
+BaseType_t xTaskCreatePinnedToCore(void (*fnTask)(void*), const char*, uint32_t, void* pParam, UBaseType_t, TaskHandle_t* pHandle, BaseType_t)
+{
+    HostTask* pTask = new HostTask;
+    pTask->thread = std::thread(fnTask, pParam);
+    pTask->thread.detach();
+    if (pHandle)
+        *pHandle = pTask;
+    return pdPASS;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    delay(ticks);
+}
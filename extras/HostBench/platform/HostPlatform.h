@@ -0,0 +1,51 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * Linux implementation of the platform used by the M5Full sketch: clock,
+ * SD file system, preferences, serial output, FreeRTOS and heap statistics.
+ *
+ * The sketch classes keep calling millis(), SD, Preferences and Serial,
+ * the headers in this folder provide these names on the host.
+ *
+ */
+
+#ifndef HOST_PLATFORM_H
+#define HOST_PLATFORM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+class HostPlatform
+{
+public:
+    enum { MAX_COMPONENTS = 8 };
+
+    // clock: millis() returns virtual time once set, real time before
+    static void     SetMillis(uint32_t ms);
+    static uint32_t Millis();
+    static uint32_t Micros(); // always real time
+    static int64_t  TimerMicros(); // esp_timer_get_time(), follows the virtual clock
+
+    // SD card: "/name" is mapped to <root>/name
+    static void        SetSdRoot(const char* pDir);
+    static std::string SdPath(const char* pPath);
+
+    static void SetSerialMute(bool bMute);
+    static bool IsSerialMute();
+
+    // heap: allocations are counted for the active component
+    struct stHeapStats
+    {
+        uint64_t current;
+        uint64_t peak;
+        uint64_t nAllocs;
+    };
+    static void SetComponent(int component); // 0: none
+    static void GetHeapStats(int component, stHeapStats& stats);
+    static void GetHeapStats(stHeapStats& stats); // all components
+};
+
+#endif // HOST_PLATFORM_H
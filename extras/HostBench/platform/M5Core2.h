@@ -0,0 +1,45 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * host replacement for M5Core2.h: SD card and RTC only
+ *
+ */
+
+#ifndef HOST_M5CORE2_H
+#define HOST_M5CORE2_H
+
+#include "Arduino.h"
+#include "FS.h"
+
+struct RTC_TimeTypeDef
+{
+    uint8_t Hours;
+    uint8_t Minutes;
+    uint8_t Seconds;
+};
+
+struct RTC_DateTypeDef
+{
+    uint8_t  WeekDay;
+    uint8_t  Month;
+    uint8_t  Date;
+    uint16_t Year;
+};
+
+class RTC
+{
+public:
+    void GetTime(RTC_TimeTypeDef* pTime);
+    void GetDate(RTC_DateTypeDef* pDate);
+};
+
+class M5Core2
+{
+public:
+    RTC Rtc;
+};
+extern M5Core2 M5;
+
+#endif // HOST_M5CORE2_H
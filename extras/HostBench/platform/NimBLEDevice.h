@@ -0,0 +1,21 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * NimBLE types referenced by LevoEsp32Ble.h, BLE is not available on the host
+ *
+ */
+
+#ifndef HOST_NIMBLE_DEVICE_H
+#define HOST_NIMBLE_DEVICE_H
+
+#include "Arduino.h"
+
+class NimBLEClient;
+class NimBLEScanResults;
+class NimBLEAdvertisedDevice;
+class NimBLERemoteCharacteristic;
+struct ble_gap_upd_params;
+
+#endif // HOST_NIMBLE_DEVICE_H
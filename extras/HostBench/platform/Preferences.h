@@ -0,0 +1,58 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * preferences in memory, each run starts with defaults
+ *
+ */
+
+#ifndef HOST_PREFERENCES_H
+#define HOST_PREFERENCES_H
+
+#include "Arduino.h"
+#include <map>
+#include <string>
+
+class Preferences
+{
+public:
+    bool     begin(const char*, bool = false) { return true; }
+    void     end() {}
+    bool     clear()                  { m_values.clear(); return true; }
+    bool     remove(const char* key)  { return m_values.erase(key) > 0; }
+    bool     isKey(const char* key)   { return m_values.count(key) > 0; }
+
+    size_t   putUChar(const char* key, uint8_t val)   { return putBytes(key, &val, sizeof(val)); }
+    size_t   putUShort(const char* key, uint16_t val) { return putBytes(key, &val, sizeof(val)); }
+    size_t   putULong(const char* key, uint32_t val)  { return putBytes(key, &val, sizeof(val)); }
+    size_t   putFloat(const char* key, float val)     { return putBytes(key, &val, sizeof(val)); }
+    size_t   putBytes(const char* key, const void* pData, size_t len) { m_values[key].assign((const char*)pData, len); return len; }
+
+    uint8_t  getUChar(const char* key, uint8_t def = 0)   { return get(key, def); }
+    uint16_t getUShort(const char* key, uint16_t def = 0) { return get(key, def); }
+    uint32_t getULong(const char* key, uint32_t def = 0)  { return get(key, def); }
+    float    getFloat(const char* key, float def = NAN)   { return get(key, def); }
+    size_t   getBytesLength(const char* key)              { return isKey(key) ? m_values[key].size() : 0; }
+    size_t   getBytes(const char* key, void* pData, size_t len)
+    {
+        if (!isKey(key))
+            return 0;
+        len = std::min(len, m_values[key].size());
+        memcpy(pData, m_values[key].data(), len);
+        return len;
+    }
+
+protected:
+    std::map<std::string, std::string> m_values;
+
+    template<class T> T get(const char* key, T def)
+    {
+        T val = def;
+        if (isKey(key) && m_values[key].size() == sizeof(T))
+            memcpy(&val, m_values[key].data(), sizeof(T));
+        return val;
+    }
+};
+
+#endif // HOST_PREFERENCES_H
@@ -0,0 +1,2 @@
+// host: SD is declared in FS.h
+#include "FS.h"
@@ -0,0 +1,17 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * host replacement for esp_timer.h: 64 bit microseconds since start
+ *
+ */
+
+#ifndef HOST_ESP_TIMER_H
+#define HOST_ESP_TIMER_H
+
+#include "HostPlatform.h"
+
+inline int64_t esp_timer_get_time() { return HostPlatform::TimerMicros(); }
+
+#endif // HOST_ESP_TIMER_H
@@ -0,0 +1,42 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * FreeRTOS tasks, queues and semaphores on std::thread
+ *
+ */
+
+#ifndef HOST_FREERTOS_H
+#define HOST_FREERTOS_H
+
+#include <stdint.h>
+
+typedef int      BaseType_t;
+typedef uint32_t TickType_t;
+typedef uint32_t UBaseType_t;
+
+#define pdTRUE            1
+#define pdFALSE           0
+#define pdPASS            1
+#define portMAX_DELAY     0xffffffffUL
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+struct HostQueue;
+struct HostSemaphore;
+struct HostTask;
+typedef HostQueue*     QueueHandle_t;
+typedef HostSemaphore* SemaphoreHandle_t;
+typedef HostTask*      TaskHandle_t;
+
+QueueHandle_t     xQueueCreate(UBaseType_t length, UBaseType_t itemSize);
+BaseType_t        xQueueSend(QueueHandle_t hQueue, const void* pItem, TickType_t ticksToWait);
+BaseType_t        xQueueReceive(QueueHandle_t hQueue, void* pItem, TickType_t ticksToWait);
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t maxCount, UBaseType_t initialCount);
+BaseType_t        xSemaphoreTake(SemaphoreHandle_t hSem, TickType_t ticksToWait);
+BaseType_t        xSemaphoreGive(SemaphoreHandle_t hSem);
+BaseType_t        xTaskCreatePinnedToCore(void (*fnTask)(void*), const char* pName, uint32_t stackDepth, void* pParam,
+                                          UBaseType_t priority, TaskHandle_t* pHandle, BaseType_t core);
+void              vTaskDelay(TickType_t ticks);
+
+#endif // HOST_FREERTOS_H
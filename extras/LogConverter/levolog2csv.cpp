@@ -0,0 +1,337 @@
+/*
+ *
+ *  Created: 19/10/2026
+ *      Author: Bernd Wokoeck
+ *
+ * Host tool: convert binary ride logs (FileLogger::BIN_DELTA, *.bin) to CSV
+ *
+ * build:   g++ -O2 -o levolog2csv levolog2csv.cpp
+ *
+ * usage:   levolog2csv [-t | -c <prefix> | -s] <file.bin>
+ *          (default)   one line per value: Time Id Label Value Unit (like CSV_KNOWN)
+ *          -t          all dynamic values per line (like CSV_TABLE)
+ *          -c prefix   one file per value id: <prefix>_<id>.csv with Time Value (columns)
+ *          -s          statistics: sessions, blocks, values and size compared to CSV formats
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include "../../examples/LevoEsp32M5Full/BinLogFormat.h"
+
+enum { FLAG_DYNAMIC = 1, FLAG_STATIC = 2 };
+
+struct stDesc
+{
+    bool        bValid = false;
+    int         flags = 0;
+    int         precision = 0;
+    std::string label;
+    std::string unit;
+};
+
+struct stSession
+{
+    int    day, month, year, hour, minute, second;
+    stDesc desc[256];
+};
+
+enum enMode { MODE_LONG, MODE_TABLE, MODE_COLUMNS, MODE_STATS };
+
+class Converter
+{
+public:
+    Converter(enMode mode, const char* prefix) : m_mode(mode), m_prefix(prefix ? prefix : "") {}
+    ~Converter();
+    bool Run(const std::vector<uint8_t>& data);
+
+protected:
+    enMode      m_mode;
+    std::string m_prefix;
+    stSession   m_session;
+    double      m_tableValue[256];
+    std::map<int, FILE*> m_columnFiles;
+
+    // statistics
+    unsigned m_nSessions = 0, m_nBlocks = 0, m_nValues = 0, m_nRaw = 0, m_nErrors = 0;
+    double   m_csvSimpleBytes = 0, m_csvTableBytes = 0;
+
+    size_t parseSession(const uint8_t* p, size_t len);
+    size_t parseBlock(const uint8_t* p, size_t len);
+    void   onValue(uint32_t time, int id, double value);
+    void   onRaw(uint32_t time, const uint8_t* p, size_t len);
+    std::string format(double value, int precision);
+    std::string unit(const std::string& unit);
+};
+
+Converter::~Converter()
+{
+    for (auto& f : m_columnFiles)
+        fclose(f.second);
+}
+
+std::string Converter::format(double value, int precision)
+{
+    char s[32];
+    snprintf(s, sizeof(s), "%.*f", precision, value);
+    return s;
+}
+
+// "&o" is the degree symbol
+std::string Converter::unit(const std::string& unit)
+{
+    return (unit == "&o") ? "\xb0" : unit;
+}
+
+size_t Converter::parseSession(const uint8_t* p, size_t len)
+{
+    if (len < 14 || memcmp(p, BinLogFormat::Magic(), 4) != 0 || p[4] != BinLogFormat::VERSION)
+        return 0;
+
+    stSession& s = m_session;
+    s = stSession();
+    s.day    = p[5];
+    s.month  = p[6];
+    s.year   = p[7] | (p[8] << 8);
+    s.hour   = p[9];
+    s.minute = p[10];
+    s.second = p[11];
+    int nIds = p[12];
+    size_t n = 13;
+    for (int i = 0; i < nIds; i++)
+    {
+        if (n + 4 > len)
+            return 0;
+        stDesc& d = s.desc[p[n]];
+        d.bValid    = true;
+        d.flags     = p[n + 1];
+        d.precision = p[n + 2];
+        size_t lenLabel = p[n + 3];
+        n += 4;
+        if (n + lenLabel + 1 > len)
+            return 0;
+        d.label.assign((const char*)&p[n], lenLabel);
+        n += lenLabel;
+        size_t lenUnit = p[n++];
+        if (n + lenUnit > len)
+            return 0;
+        d.unit.assign((const char*)&p[n], lenUnit);
+        n += lenUnit;
+    }
+
+    for (int i = 0; i < 256; i++)
+        m_tableValue[i] = 0.0;
+    m_nSessions++;
+
+    if (m_mode == MODE_LONG)
+    {
+        printf("%02d.%02d.%04d, %02d:%02d:%02d\n", s.day, s.month, s.year, s.hour, s.minute, s.second);
+        printf("Time\tId\tLabel\tValue\tUnit\n");
+    }
+    else if (m_mode == MODE_TABLE)
+    {
+        printf("%02d.%02d.%04d, %02d:%02d:%02d\n", s.day, s.month, s.year, s.hour, s.minute, s.second);
+        printf("Time\tId");
+        for (int i = 0; i < 256; i++)
+            if (s.desc[i].bValid && (s.desc[i].flags & FLAG_DYNAMIC))
+                printf("\t%s", s.desc[i].label.c_str());
+        printf("\n");
+    }
+    return n;
+}
+
+size_t Converter::parseBlock(const uint8_t* p, size_t len)
+{
+    if (len < BinLogFormat::BLOCK_HEADER || p[0] != BinLogFormat::BLOCK_MARKER)
+        return 0;
+    size_t payload = p[1] | (p[2] << 8);
+    if (payload + BinLogFormat::BLOCK_HEADER > len || payload + BinLogFormat::BLOCK_HEADER > BinLogFormat::BLOCK_SIZE)
+        return 0;
+
+    const uint8_t* q = p + BinLogFormat::BLOCK_HEADER;
+    size_t n = 0;
+    uint32_t time, v;
+    size_t k = BinLogFormat::GetVarint(q, payload, time);
+    if (k == 0)
+        return 0;
+    n += k;
+
+    int32_t last[256] = { 0 };
+    while (n < payload)
+    {
+        int id = q[n++];
+        uint32_t dt;
+        if ((k = BinLogFormat::GetVarint(&q[n], payload - n, dt)) == 0)
+            return 0;
+        n += k;
+        time += dt;
+
+        if (id == BinLogFormat::ID_RAW)
+        {
+            if (n >= payload || n + 1 + q[n] > payload)
+                return 0;
+            onRaw(time, &q[n + 1], q[n]);
+            n += 1 + q[n];
+        }
+        else
+        {
+            if ((k = BinLogFormat::GetVarint(&q[n], payload - n, v)) == 0)
+                return 0;
+            n += k;
+            last[id] += BinLogFormat::UnZigZag(v);
+            static const double scale[] = { 1.0, 10.0, 100.0, 1000.0 };
+            int prec = m_session.desc[id].precision;
+            onValue(time, id, last[id] / scale[(prec >= 0 && prec <= 3) ? prec : 0]);
+        }
+    }
+    m_nBlocks++;
+    return BinLogFormat::BLOCK_HEADER + payload;
+}
+
+void Converter::onValue(uint32_t time, int id, double value)
+{
+    const stDesc& d = m_session.desc[id];
+    std::string strTime = format(time / 1000.0, 3);
+    std::string strValue = format(value, d.precision);
+    m_nValues++;
+    m_tableValue[id] = value;
+
+    switch (m_mode)
+    {
+    case MODE_LONG:
+        printf("%s\t%d\t%s\t%s\t%s\n", strTime.c_str(), id, d.label.c_str(), strValue.c_str(), unit(d.unit).c_str());
+        break;
+
+    case MODE_TABLE:
+        printf("%s\t%d", strTime.c_str(), id);
+        for (int i = 0; i < 256; i++)
+            if (m_session.desc[i].bValid && (m_session.desc[i].flags & FLAG_DYNAMIC))
+                printf("\t%s", format(m_tableValue[i], m_session.desc[i].precision).c_str());
+        printf("\n");
+        break;
+
+    case MODE_COLUMNS:
+    {
+        FILE*& f = m_columnFiles[id];
+        if (!f)
+        {
+            std::string name = m_prefix + "_" + std::to_string(id) + ".csv";
+            f = fopen(name.c_str(), "w");
+            if (!f)
+            {
+                m_nErrors++;
+                return;
+            }
+            fprintf(f, "Time\t%s\n", d.label.c_str());
+        }
+        fprintf(f, "%s\t%s\n", strTime.c_str(), strValue.c_str());
+        break;
+    }
+
+    case MODE_STATS:
+    {
+        // same value as CSV_SIMPLE (time 9.3, dist 7.2, value 7.x) and CSV_TABLE line
+        m_csvSimpleBytes += 9 + 1 + 7 + 1 + std::to_string(id).size() + 1 + d.label.size() + 1 + std::max<size_t>(7, strValue.size()) + 1 + unit(d.unit).size() + 2;
+        double line = 9 + 1 + 7 + 1 + std::to_string(id).size() + 2;
+        for (int i = 0; i < 256; i++)
+            if (m_session.desc[i].bValid && (m_session.desc[i].flags & FLAG_DYNAMIC))
+                line += 1 + std::max<size_t>(7, format(m_tableValue[i], m_session.desc[i].precision).size());
+        m_csvTableBytes += line;
+        break;
+    }
+    }
+}
+
+void Converter::onRaw(uint32_t time, const uint8_t* p, size_t len)
+{
+    m_nRaw++;
+    if (m_mode != MODE_LONG)
+        return;
+    printf("%s\t-1\t", format(time / 1000.0, 3).c_str());
+    for (size_t i = 0; i < len; i++)
+        printf("%02x ", p[i]);
+    printf("\n");
+}
+
+bool Converter::Run(const std::vector<uint8_t>& data)
+{
+    size_t pos = 0, n;
+    while (pos < data.size())
+    {
+        if ((n = parseSession(&data[pos], data.size() - pos)) > 0 ||
+            (n = parseBlock(&data[pos], data.size() - pos)) > 0)
+        {
+            pos += n;
+            continue;
+        }
+
+        // damaged data: search next block or session
+        m_nErrors++;
+        pos++;
+        while (pos < data.size() && data[pos] != BinLogFormat::BLOCK_MARKER && data[pos] != (uint8_t)BinLogFormat::Magic()[0])
+            pos++;
+    }
+
+    if (m_mode == MODE_STATS)
+    {
+        printf("sessions:    %u\n", m_nSessions);
+        printf("blocks:      %u\n", m_nBlocks);
+        printf("values:      %u (+ %u raw)\n", m_nValues, m_nRaw);
+        printf("errors:      %u\n", m_nErrors);
+        printf("binary size: %lu bytes, %.2f bytes per value\n", (unsigned long)data.size(), m_nValues ? (double)data.size() / m_nValues : 0.0);
+        printf("CSV_SIMPLE:  %.0f bytes (x%.1f)\n", m_csvSimpleBytes, data.size() ? m_csvSimpleBytes / data.size() : 0.0);
+        printf("CSV_TABLE:   %.0f bytes (x%.1f)\n", m_csvTableBytes, data.size() ? m_csvTableBytes / data.size() : 0.0);
+    }
+    else if (m_nErrors)
+        fprintf(stderr, "%u damaged data ranges skipped\n", m_nErrors);
+
+    return m_nSessions > 0;
+}
+
+int main(int argc, char* argv[])
+{
+    enMode mode = MODE_LONG;
+    const char* prefix = NULL;
+    const char* filename = NULL;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "-t"))
+            mode = MODE_TABLE;
+        else if (!strcmp(argv[i], "-s"))
+            mode = MODE_STATS;
+        else if (!strcmp(argv[i], "-c") && i + 1 < argc)
+        {
+            mode = MODE_COLUMNS;
+            prefix = argv[++i];
+        }
+        else
+            filename = argv[i];
+    }
+    if (!filename)
+    {
+        fprintf(stderr, "usage: levolog2csv [-t | -c <prefix> | -s] <file.bin>\n");
+        return 1;
+    }
+
+    FILE* f = fopen(filename, "rb");
+    if (!f)
+    {
+        fprintf(stderr, "can't open %s\n", filename);
+        return 1;
+    }
+    std::vector<uint8_t> data;
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+        data.insert(data.end(), buf, buf + n);
+    fclose(f);
+
+    Converter conv(mode, prefix);
+    return conv.Run(data) ? 0 : 1;
+}
@@ -272,6 +272,30 @@ void LevoEsp32Ble::Disconnect()
     m_bAutoReconnect = false;
 }
 
+// Disconnect and connect again, e.g. after pin change
+void LevoEsp32Ble::Restart()
+{
+    if (m_pin == 0)
+        return;
+    m_bAutoReconnect = true;
+    NimBLEClient* pClient = s_advDevice ? NimBLEDevice::getClientByPeerAddress(s_advDevice->getAddress()) : NULL;
+    if (pClient && pClient->isConnected())
+    {
+        pClient->disconnect(); // onDisconnect() starts scan
+        Serial.println("Ble Restart() called.");
+    }
+    else
+        Reconnect();
+}
+
+// Pin for next pairing, NimBLE is not initialized as long as there is no pin
+void LevoEsp32Ble::SetPin( uint32_t pin )
+{
+    m_pin = pin;
+    if (pin != 0 && !NimBLEDevice::getInitialized())
+        initStack();
+}
+
 // subscribe to Levo notifications
 bool LevoEsp32Ble::Subscribe()
 {
@@ -556,7 +580,17 @@ void LevoEsp32Ble::Init( uint32_t pin, bool bBtEnabled )
         return;
 
     m_pin = pin;
+    initStack();
 
+    if( bBtEnabled )
+    {
+        m_bAutoReconnect = true;
+        startScan();
+    }
+}
+
+void LevoEsp32Ble::initStack()
+{
     // Initialize NimBLE, no device name specified as we are not advertising
     NimBLEDevice::init("");
     
@@ -571,12 +605,6 @@ void LevoEsp32Ble::Init( uint32_t pin, bool bBtEnabled )
     
     // Optional: set any devices you don't want to get advertisments from 
     // NimBLEDevice::addIgnored(NimBLEAddress ("aa:bb:cc:dd:ee:ff")); 
- 
-    if( bBtEnabled )
-    {
-        m_bAutoReconnect = true;
-        startScan();
-    }
 }
 
 bool LevoEsp32Ble::Update( stBleVal& bleVal )
@@ -127,6 +127,8 @@ public:
     bool Update( stBleVal & bleVal );
     void Disconnect();
     void Reconnect();
+    void Restart();              // drop connection and connect again, keeps stack and queue
+    void SetPin( uint32_t pin ); // used with next connection
     bool Subscribe();
     bool Unsubscribe();
 
@@ -138,6 +140,7 @@ public:
     bool ReadRequestedBleValue(enLevoBleDataType valueType, stBleVal& bleVal);
 
 protected:
+    void initStack();
     void startScan();
     bool connectToServer();
 
@@ -10,7 +10,7 @@
 #include "LevoReadWrite.h"
 
 // set all elements to -1
-void LevoReadWrite::resetAssistData(stLevoAssist& sd )
+void LevoReadWrite::ResetAssistData(stLevoAssist& sd )
 {
     memset(sd.assist, -1, sizeof(sd.assist ) );
     memset(sd.peakAssist, -1, sizeof(sd.peakAssist));
@@ -18,7 +18,7 @@ void LevoReadWrite::resetAssistData(stLevoAssist& sd )
 }
 
 // check if all values contain valid values
-bool LevoReadWrite::isValidAssistData(stLevoAssist& sd)
+bool LevoReadWrite::IsValidAssistData(stLevoAssist& sd)
 {
     if( sd.assist[0]     == -1 || sd.assist[1]     == -1 || sd.assist[2]     == -1  || 
         sd.peakAssist[0] == -1 || sd.peakAssist[1] == -1 || sd.peakAssist[2] == -1  ||
@@ -28,6 +28,23 @@ bool LevoReadWrite::isValidAssistData(stLevoAssist& sd)
     return true;
 }
 
+// copy a read assist data field
+bool LevoReadWrite::SetAssistDataField(stLevoAssist& sd, stBleVal& bleVal)
+{
+    switch (bleVal.dataType)
+    {
+    case MOT_PEAKASSIST:    memcpy(sd.peakAssist, bleVal.raw.data, stLevoAssist::NUM_LEVELS); break;
+    case MOT_SHUTTLE:       sd.shuttle     = (int8_t)bleVal.fVal; break;
+    case BIKE_ASSISTLEV1:   sd.assist[0]   = (int8_t)bleVal.fVal; break;
+    case BIKE_ASSISTLEV2:   sd.assist[1]   = (int8_t)bleVal.fVal; break;
+    case BIKE_ASSISTLEV3:   sd.assist[2]   = (int8_t)bleVal.fVal; break;
+    case BIKE_FAKECHANNEL:  sd.fakeChannel = (int8_t)bleVal.fVal; break;
+    case BIKE_ACCEL:        sd.accelSens   = (int8_t)bleVal.fVal; break;
+    default: return false;
+    }
+    return true;
+}
+
 // set current assist level
 bool LevoReadWrite::WriteAssistLevel(enAssistLevel enLevel)
 {
@@ -61,7 +78,7 @@ LevoReadWrite::enAssistLevel LevoReadWrite::GetAssistLevel()
 // read support data synchronuous
 bool LevoReadWrite::ReadAssistDataFields(stLevoAssist& sd)
 {
-    resetAssistData(sd);
+    ResetAssistData(sd);
 
     if (!IsConnected())
         return false;
@@ -74,7 +91,7 @@ bool LevoReadWrite::ReadAssistDataFields(stLevoAssist& sd)
     Serial.println("ReadAssistDataFields");
 
     int i;
-    for (i = 0; i < sizeof(m_assistDataFields)/sizeof(enLevoBleDataType); )
+    for (i = 0; i < NUM_ASSIST_FIELDS; )
     {
         timeout = millis() + 1000L;
         if (ReadAsync(m_assistDataFields[i], true))
@@ -88,22 +105,13 @@ bool LevoReadWrite::ReadAssistDataFields(stLevoAssist& sd)
                     if( bleVal.dataType == m_assistDataFields[i])
                     {
                         // Serial.printf("Got 0x%04.4x\r\n", bleVal.dataType);
-                        switch (bleVal.dataType)
-                        {
-                        case MOT_PEAKASSIST:    memcpy(sd.peakAssist, bleVal.raw.data, stLevoAssist::NUM_LEVELS); break;
-                        case MOT_SHUTTLE:       sd.shuttle     = (int8_t)bleVal.fVal; break;
-                        case BIKE_ASSISTLEV1:   sd.assist[0]   = (int8_t)bleVal.fVal; break;
-                        case BIKE_ASSISTLEV2:   sd.assist[1]   = (int8_t)bleVal.fVal; break;
-                        case BIKE_ASSISTLEV3:   sd.assist[2]   = (int8_t)bleVal.fVal; break;
-                        case BIKE_FAKECHANNEL:  sd.fakeChannel = (int8_t)bleVal.fVal; break;
-                        case BIKE_ACCEL:        sd.accelSens   = (int8_t)bleVal.fVal; break;
-                        }
+                        SetAssistDataField(sd, bleVal);
                         i++;
                         break;
                     }
                 }
 
-                if( millis() > timeout )
+                if( (int32_t)(millis() - timeout) > 0 ) // wrap safe
                    break;
                 delay(1);
             }
@@ -113,7 +121,7 @@ bool LevoReadWrite::ReadAssistDataFields(stLevoAssist& sd)
     if( bResubscribe )
         Subscribe();
 
-    return isValidAssistData( sd );
+    return IsValidAssistData( sd );
 }
 
 // write support data synchronuous
@@ -202,7 +210,7 @@ bool LevoReadWrite::ReadSync(enLevoBleDataType valueType, stBleVal& bleVal, uint
                 if (bleVal.dataType == valueType)
                     return true;
             }
-            if (millis() > timeout)
+            if ((int32_t)(millis() - timeout) > 0) // wrap safe
                 break;
             delay(1);
         }
@@ -52,8 +52,15 @@ public:
     bool ReadAssistDataFields(stLevoAssist & assistData );
     bool WriteAssistDataFields(stLevoAssist& assistData, uint16_t writeMask = ALL);
 
+    // async read of assist data: ReadAsync( GetAssistDataField(i), true ) for each field, Update() result to SetAssistDataField()
+    enum { NUM_ASSIST_FIELDS = 7 };
+    enLevoBleDataType GetAssistDataField(int i) { return m_assistDataFields[i]; }
+    bool SetAssistDataField(stLevoAssist& assistData, stBleVal& bleVal); // false if bleVal is no assist data field
+    void ResetAssistData(stLevoAssist& assistData);
+    bool IsValidAssistData(stLevoAssist& assistData);
+
 protected:
-    const enLevoBleDataType m_assistDataFields[7] = 
+    const enLevoBleDataType m_assistDataFields[NUM_ASSIST_FIELDS] = 
     {
             MOT_PEAKASSIST, MOT_SHUTTLE,
             BIKE_ASSISTLEV1, BIKE_ASSISTLEV2, BIKE_ASSISTLEV3,
@@ -61,9 +68,6 @@ protected:
     };
 
     enLevoBleDataType m_requestedValueType = UNKNOWN;
-
-    void resetAssistData(stLevoAssist& supportData);
-    bool isValidAssistData(stLevoAssist& supportData);
 };
 
 #endif // LEVOREADWRITE_H
\ No newline at end of file